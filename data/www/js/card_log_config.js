@@ -0,0 +1,97 @@
+// Author: @tweathers-sec
+// Copyright: @tweathers-sec and Mayweather Group LLC
+
+registerHandler("card_log", function (data) {
+  updateCardLogStatus();
+});
+
+function updateCardLogStatus() {
+  fetch("/card-log")
+    .then((response) => response.json())
+    .then((data) => {
+      const usedKB = Math.round(data.used_bytes / 1024);
+      const maxKB = Math.round(data.max_bytes / 1024);
+      document.getElementById("card-log-used").textContent =
+        usedKB + " KB" + (data.full ? " (Full)" : "");
+      document.getElementById("card-log-capacity").textContent = maxKB + " KB";
+      document.getElementById("card-log-policy").textContent =
+        data.policy === "stop" ? "Stop Logging" : "Overwrite Oldest";
+
+      document.getElementById("card_log_max_kb").value = maxKB;
+      document.getElementById("card_log_policy").value = data.policy;
+    })
+    .catch((error) => {
+      console.error("Error fetching card log status:", error);
+      document.getElementById("card-log-used").textContent = "Error";
+      document.getElementById("card-log-capacity").textContent = "Error";
+      document.getElementById("card-log-policy").textContent = "Error";
+    });
+
+  fetch("/api/storage")
+    .then((response) => response.json())
+    .then((stats) => {
+      document.getElementById("storage-queue").textContent =
+        stats.queue_depth + " / " + stats.queue_capacity +
+        (stats.dropped ? " (" + stats.dropped + " dropped)" : "");
+      document.getElementById("storage-high-water").textContent =
+        stats.queue_high_water;
+      document.getElementById("storage-latency").textContent =
+        (stats.avg_latency_us / 1000).toFixed(1) + " ms avg, " +
+        (stats.max_latency_us / 1000).toFixed(1) + " ms max";
+    })
+    .catch((error) => console.error("Error fetching storage stats:", error));
+
+  fetch("credential_config.json")
+    .then((response) => response.json())
+    .then((config) => {
+      document.getElementById("credential_renotify_min").value = Math.round(
+        config.RENOTIFY_SECONDS / 60
+      );
+      document.getElementById("credential_log_repeats").value = config.LOG_REPEATS
+        ? "true"
+        : "false";
+    })
+    .catch((error) => console.error("Error fetching credential config:", error));
+}
+
+function processCardLogForm() {
+  const maxKB = parseInt(document.getElementById("card_log_max_kb").value);
+  const policy = document.getElementById("card_log_policy").value;
+
+  if (isNaN(maxKB) || maxKB < 32 || maxKB > 1024) {
+    window.alert("Capacity must be between 32 and 1024 KB");
+    return;
+  }
+
+  const renotifyMin = parseInt(
+    document.getElementById("credential_renotify_min").value
+  );
+  const logRepeats =
+    document.getElementById("credential_log_repeats").value === "true";
+
+  if (isNaN(renotifyMin) || renotifyMin < 0 || renotifyMin > 10080) {
+    window.alert("Re-notify window must be between 0 and 10080 minutes");
+    return;
+  }
+
+  sendData({ CARD_LOG_MAX_KB: maxKB, CARD_LOG_POLICY: policy });
+  sendData({
+    CREDENTIAL_RENOTIFY_MIN: renotifyMin,
+    CREDENTIAL_LOG_REPEATS: logRepeats,
+  });
+  window.alert("Card storage settings have been updated.");
+
+  document.querySelector(".cardLogForm").classList.remove("visible");
+}
+
+function toggleCardLogVisibility() {
+  const form = document.querySelector(".cardLogForm");
+  if (form) {
+    form.classList.toggle("visible");
+  }
+}
+
+document.addEventListener("DOMContentLoaded", function () {
+  ensureWebSocket();
+  updateCardLogStatus();
+});
@@ -0,0 +1,42 @@
+function formatClockTime(seconds) {
+  return new Date(seconds * 1000).toISOString().replace("T", " ").slice(0, 19);
+}
+
+async function loadClockInfo() {
+  const clockTime = document.getElementById("clockTime");
+  const clockLastSync = document.getElementById("clockLastSync");
+  const clockOffset = document.getElementById("clockOffset");
+  const clockDrift = document.getElementById("clockDrift");
+
+  try {
+    const response = await fetch("/api/time");
+    if (!response.ok) {
+      throw new Error(`HTTP error! status: ${response.status}`);
+    }
+    const data = await response.json();
+
+    if (clockTime) {
+      clockTime.textContent = data.synced ? formatClockTime(data.time) : "Not Set";
+    }
+    if (clockLastSync) {
+      clockLastSync.textContent =
+        data.sync_count > 0 ? `${formatClockTime(data.last_sync)} (${data.sync_count} syncs)` : data.source;
+    }
+    if (clockOffset) {
+      clockOffset.textContent = data.offset_ms !== undefined ? `${data.offset_ms} ms` : "N/A";
+    }
+    if (clockDrift) {
+      clockDrift.textContent = data.drift_ppm !== undefined ? `${data.drift_ppm} ppm` : "N/A";
+    }
+  } catch (error) {
+    console.error("Error fetching clock information:", error);
+    if (clockTime) {
+      clockTime.textContent = "Error";
+    }
+  }
+}
+
+document.addEventListener("DOMContentLoaded", () => {
+  loadClockInfo();
+  setInterval(loadClockInfo, 60000);
+});
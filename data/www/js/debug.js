@@ -1,7 +1,7 @@
 // Author: @tweathers-sec
 // Copyright: @tweathers-sec and Mayweather Group LLC
 
-var connection = new WebSocket("ws://" + location.hostname + ":81/");
+var connection = new WebSocket("ws://" + location.host + "/ws");
 
 document.addEventListener("DOMContentLoaded", function () {
   const debugButton = document.getElementById("debug-submit-button");
@@ -25,6 +25,10 @@ function processDebugForm() {
   const formData = {
     DEBUG: debugEnabled,
   };
+  const levelSelect = document.getElementById("log-level-select");
+  if (levelSelect) {
+    formData.LOG_LEVEL = levelSelect.value;
+  }
 
   const debugConfig = JSON.stringify(formData);
   console.log("Sending debug config:", debugConfig);
@@ -40,23 +44,93 @@ function processDebugForm() {
         "screen /dev/ttyUSBX 115200\n" +
         "or\n" +
         "screen /dev/ttyACMX 115200\n\n" +
-        "Note: Debug mode will slightly impact battery life. Remember to disable debugging prior to deployment.\n\n" +
-        "Rebooting..."
+        "The Live Console below shows the same output without a cable.\n\n" +
+        "Note: Debug mode will slightly impact battery life. Remember to disable debugging prior to deployment."
     );
   } else {
     window.alert(
       "Debug mode has been disabled.\n\n" +
-        "The device will no longer output debug messages over serial.\n\n" +
-        "Rebooting..."
+        "The device will no longer output debug messages over serial."
     );
   }
+}
+
+// Live console
+const CONSOLE_MAX_LINES = 500;
+let consoleRunning = false;
+
+function toggleConsole() {
+  consoleRunning = !consoleRunning;
+  sendConsoleLevel();
+  const button = document.getElementById("console-toggle-button");
+  if (button) {
+    button.textContent = consoleRunning ? "Stop" : "Start";
+  }
+}
+
+function changeConsoleLevel() {
+  if (consoleRunning) {
+    sendConsoleLevel();
+  }
+}
+
+function sendConsoleLevel() {
+  if (connection.readyState !== WebSocket.OPEN) {
+    return;
+  }
+  const levelSelect = document.getElementById("console-level-select");
+  const level = consoleRunning && levelSelect ? levelSelect.value : "none";
+  connection.send(JSON.stringify({ CONSOLE: level }));
+}
+
+function appendConsoleLine(text, className) {
+  const output = document.getElementById("console-output");
+  if (!output) {
+    return;
+  }
+
+  const atBottom = output.scrollTop + output.clientHeight >= output.scrollHeight - 4;
+  const line = document.createElement("div");
+  line.textContent = text;
+  if (className) {
+    line.className = className;
+  }
+  output.appendChild(line);
+  while (output.childNodes.length > CONSOLE_MAX_LINES) {
+    output.removeChild(output.firstChild);
+  }
+  if (atBottom) {
+    output.scrollTop = output.scrollHeight;
+  }
+}
 
-  setTimeout(function () {
-    window.location.reload();
-  }, 2000);
+function handleConsoleMessage(data) {
+  if (data.skipped) {
+    appendConsoleLine("... " + data.skipped + " line(s) skipped ...", "console-skipped");
+  }
+  (data.console || []).forEach((line) => {
+    appendConsoleLine(line.text, "console-" + line.level);
+  });
 }
 
 connection.onmessage = function (event) {
+  if (event.data.startsWith("Connected")) {
+    return;
+  }
+
+  try {
+    const data = JSON.parse(event.data);
+    if (data.console || data.skipped) {
+      handleConsoleMessage(data);
+      return;
+    }
+    if (data.log_level !== undefined) {
+      updateDebugStatus(data.debug ? "Enabled" : "Disabled");
+      updateLogLevelSelect(data.log_level);
+    }
+  } catch (e) {
+    // Not JSON
+  }
   console.log("WebSocket message received:", event.data);
 };
 
@@ -66,6 +140,9 @@ connection.onerror = function (error) {
 
 connection.onopen = function () {
   console.log("WebSocket connection established");
+  if (consoleRunning) {
+    sendConsoleLevel();
+  }
 };
 
 function updateDebugMode() {
@@ -74,6 +151,7 @@ function updateDebugMode() {
     .then((data) => {
       const status = data.DEBUG ? "Enabled" : "Disabled";
       updateDebugStatus(status);
+      updateLogLevelSelect(data.LOG_LEVEL || "verbose");
     })
     .catch((error) => {
       console.error("Error fetching debug config:", error);
@@ -104,3 +182,10 @@ function updateDebugStatus(status) {
   debugStatus.textContent = status.charAt(0).toUpperCase() + status.slice(1);
   updateDebugSelect(debugStatus.textContent);
 }
+
+function updateLogLevelSelect(level) {
+  const levelSelect = document.getElementById("log-level-select");
+  if (levelSelect) {
+    levelSelect.value = level;
+  }
+}
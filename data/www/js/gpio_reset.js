@@ -3,7 +3,7 @@
 
 // Use the existing connection from device.js
 var connection =
-  connection || new WebSocket("ws://" + location.hostname + ":81/");
+  connection || new WebSocket("ws://" + location.host + "/ws");
 
 function resetGPIO() {
   if (
@@ -24,6 +24,11 @@ connection.onmessage = function (event) {
   console.log("WebSocket message received:", event.data);
   const response = JSON.parse(event.data);
 
+  // The device acknowledges a queued command before it reports the result
+  if (response.source === "command") {
+    return;
+  }
+
   if (response.status === "success") {
     alert("GPIO settings have been reset to default values");
   } else {
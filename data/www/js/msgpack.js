@@ -0,0 +1,97 @@
+// MessagePack decoder for the device's binary WebSocket frames. Covers the
+// types ArduinoJson writes: nil, booleans, integers, floats, strings, binary,
+// arrays and maps. 64-bit integers become Numbers.
+
+function decodeMsgPack(buffer) {
+  const view = new DataView(buffer);
+  const bytes = new Uint8Array(buffer);
+  const text = new TextDecoder();
+  let offset = 0;
+
+  function uint(size) {
+    let value;
+    if (size === 1) value = view.getUint8(offset);
+    else if (size === 2) value = view.getUint16(offset);
+    else if (size === 4) value = view.getUint32(offset);
+    else value = Number(view.getBigUint64(offset));
+    offset += size;
+    return value;
+  }
+
+  function int(size) {
+    let value;
+    if (size === 1) value = view.getInt8(offset);
+    else if (size === 2) value = view.getInt16(offset);
+    else if (size === 4) value = view.getInt32(offset);
+    else value = Number(view.getBigInt64(offset));
+    offset += size;
+    return value;
+  }
+
+  function str(length) {
+    const value = text.decode(bytes.subarray(offset, offset + length));
+    offset += length;
+    return value;
+  }
+
+  function bin(length) {
+    const value = bytes.slice(offset, offset + length);
+    offset += length;
+    return value;
+  }
+
+  function array(length) {
+    const value = [];
+    for (let i = 0; i < length; i++) value.push(read());
+    return value;
+  }
+
+  function map(length) {
+    const value = {};
+    for (let i = 0; i < length; i++) {
+      const key = read();
+      value[key] = read();
+    }
+    return value;
+  }
+
+  function read() {
+    const type = uint(1);
+    if (type <= 0x7f) return type;
+    if (type <= 0x8f) return map(type & 0x0f);
+    if (type <= 0x9f) return array(type & 0x0f);
+    if (type <= 0xbf) return str(type & 0x1f);
+    if (type >= 0xe0) return type - 0x100;
+
+    switch (type) {
+      case 0xc0: return null;
+      case 0xc2: return false;
+      case 0xc3: return true;
+      case 0xc4: return bin(uint(1));
+      case 0xc5: return bin(uint(2));
+      case 0xc6: return bin(uint(4));
+      case 0xca: offset += 4; return view.getFloat32(offset - 4);
+      case 0xcb: offset += 8; return view.getFloat64(offset - 8);
+      case 0xcc: return uint(1);
+      case 0xcd: return uint(2);
+      case 0xce: return uint(4);
+      case 0xcf: return uint(8);
+      case 0xd0: return int(1);
+      case 0xd1: return int(2);
+      case 0xd2: return int(4);
+      case 0xd3: return int(8);
+      case 0xd9: return str(uint(1));
+      case 0xda: return str(uint(2));
+      case 0xdb: return str(uint(4));
+      case 0xdc: return array(uint(2));
+      case 0xdd: return array(uint(4));
+      case 0xde: return map(uint(2));
+      case 0xdf: return map(uint(4));
+    }
+    throw new Error("Unsupported MessagePack type 0x" + type.toString(16));
+  }
+
+  return read();
+}
+
+window.decodeMsgPack = decodeMsgPack;
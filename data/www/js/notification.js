@@ -32,7 +32,7 @@ function main() {
     alert("Notifications have been disabled.");
   }
 
-  const connection = new WebSocket("ws://" + location.hostname + ":81/");
+  const connection = new WebSocket("ws://" + location.host + "/ws");
 
   connection.onerror = function (error) {
     console.error("WebSocket Error ", error);
@@ -1,7 +1,7 @@
 // Author: @tweathers-sec
 // Copyright: @tweathers-sec and Mayweather Group LLC
 
-var connection = new WebSocket("ws://" + location.hostname + ":81/");
+var connection = new WebSocket("ws://" + location.host + "/ws");
 
 function loadReaderConfig() {
   fetch("reader_config.json")
@@ -3,6 +3,34 @@
 
 let capturedCards;
 let isPaxtonMode = false;
+let cardView = "unique";
+
+// Raw history is fetched newest first, one page at a time
+const PAGE_SIZE = 50;
+let historyRecords = [];
+let historyTotal = 0;
+
+// New reads are pushed over the WebSocket as they are decoded. Conditional
+// GETs (an unchanged log answers 304) catch up after a gap and take over
+// while the WebSocket is down.
+const POLL_INTERVAL_MS = 5000;
+const SYNC_LIMIT = 200;
+let historyEpoch = null;
+let historyHead = 0;
+let historyEtag = null;
+let credentialsEtag = null;
+let liveSubscribed = false;
+let liveHead = 0;
+
+// Capture to table, per read: device-side age plus decode and render here
+const liveLatency = { last: 0, max: 0 };
+window.liveLatency = liveLatency;
+
+registerHandler("open", () => sendData({ CARDS: true }));
+registerHandler("close", () => {
+  liveSubscribed = false;
+});
+registerHandler("live", handleLive);
 
 fetch("reader_config.json")
   .then((r) => r.json())
@@ -13,80 +41,319 @@ fetch("reader_config.json")
     isPaxtonMode = false;
   })
   .finally(() => {
-    fetch("cards.csv")
-      .then((response) => response.text())
-      .then((csvData) => {
-        capturedCards = parseCSV(csvData, isPaxtonMode);
-        setHeaders(isPaxtonMode);
-        buildTable(capturedCards);
-        attachSortHandlers();
-      })
-      .catch((error) => console.error("Error fetching CSV:", error));
+    loadCards();
+    attachSortHandlers();
+    setInterval(pollCards, POLL_INTERVAL_MS);
+  });
+
+function loadCards() {
+  if (cardView === "history") {
+    historyRecords = [];
+    historyTotal = 0;
+    historyEpoch = null;
+    historyEtag = null;
+    loadMoreCards();
+    return;
+  }
+
+  fetch("api/credentials", { cache: "no-store" })
+    .then((response) => {
+      credentialsEtag = response.headers.get("ETag");
+      return response.json();
+    })
+    .then((entries) => {
+      capturedCards = parseCredentials(entries, isPaxtonMode);
+      setHeaders(isPaxtonMode);
+      buildTable(capturedCards);
+      updateLoadMore();
+    })
+    .catch((error) => console.error("Error fetching credentials:", error));
+}
+
+function loadMoreCards() {
+  fetch(
+    "api/cards?order=desc&limit=" + PAGE_SIZE + "&offset=" + historyRecords.length
+  )
+    .then((response) => response.json())
+    .then((page) => {
+      if (historyEpoch === null) {
+        historyEpoch = page.epoch;
+        historyHead = page.head;
+      }
+      historyTotal = page.total;
+      historyRecords = historyRecords.concat(page.records);
+      capturedCards = parseRecords(historyRecords, isPaxtonMode);
+      setHeaders(isPaxtonMode);
+      buildTable(capturedCards);
+      updateLoadMore();
+    })
+    .catch((error) => console.error("Error fetching card history:", error));
+}
+
+function pollCards() {
+  if (document.hidden) return;
+  // While reads are pushed, only poll to fill a gap the push could not
+  if (liveSubscribed && (cardView === "unique" || historyHead >= liveHead)) return;
+  if (cardView === "history") {
+    pollHistory();
+  } else {
+    pollCredentials();
+  }
+}
+
+function handleLive(data) {
+  if (data.status) {
+    // Subscription answer; pick up anything read while disconnected
+    liveSubscribed = data.status === "success" && data.subscribed === true;
+    if (liveSubscribed) {
+      liveHead = 0;
+      if (cardView === "unique") pollCredentials();
+      else pollHistory();
+    }
+    return;
+  }
+
+  const received = performance.now();
+  const records = data.records || [];
+  records.forEach((record) => {
+    liveHead = Math.max(liveHead, record.seq);
+  });
+
+  if (cardView === "unique") {
+    // Counts and first/last seen come from the credential index
+    pollCredentials();
+    return;
+  }
+  if (historyEpoch === null || records.length === 0) return;
+  if (data.epoch !== historyEpoch) {
+    loadCards();
+    return;
+  }
+
+  let gap = data.skipped > 0;
+  records.forEach((record) => {
+    if (record.seq <= historyHead) return;
+    if (gap || record.seq !== historyHead + 1) {
+      gap = true;
+      return;
+    }
+    historyRecords.unshift(record);
+    historyHead = record.seq;
+    historyTotal++;
   });
 
+  capturedCards = parseRecords(historyRecords, isPaxtonMode);
+  buildTable(capturedCards);
+  updateLoadMore();
+
+  const newest = records[records.length - 1];
+  if (newest.age_us !== undefined) {
+    liveLatency.last = newest.age_us / 1000 + (performance.now() - received);
+    liveLatency.max = Math.max(liveLatency.max, liveLatency.last);
+    console.debug(
+      "Read #" + newest.seq + " on screen " + liveLatency.last.toFixed(1) + " ms after capture (+ network)"
+    );
+  }
+
+  // Missed records are fetched from the log
+  if (gap) pollHistory();
+}
+
+function conditionalFetch(url, etag) {
+  const options = { cache: "no-store", headers: {} };
+  if (etag) options.headers["If-None-Match"] = etag;
+  return fetch(url, options);
+}
+
+function pollHistory() {
+  if (historyEpoch === null) return;
+  conditionalFetch(
+    "api/cards?since=" + historyHead + "&limit=" + SYNC_LIMIT,
+    historyEtag
+  )
+    .then((response) => {
+      if (response.status === 304) return null;
+      const etag = response.headers.get("ETag");
+      return response.json().then((page) => ({ page, etag }));
+    })
+    .then((result) => {
+      if (!result || cardView !== "history") return;
+      const page = result.page;
+
+      // The log was wiped or restarted - sequence numbers no longer line up
+      if (page.epoch !== historyEpoch || page.head < historyHead) {
+        loadCards();
+        return;
+      }
+
+      const fresh = page.records.slice().reverse();
+      if (fresh.length > 0) {
+        historyHead = fresh[0].seq;
+        historyRecords = fresh.concat(historyRecords);
+      } else {
+        historyHead = page.head;
+      }
+      historyTotal = page.total;
+
+      // Only trust the validator once caught up; otherwise fetch the rest next time
+      historyEtag = historyHead === page.head ? result.etag : null;
+
+      capturedCards = parseRecords(historyRecords, isPaxtonMode);
+      buildTable(capturedCards);
+      updateLoadMore();
+    })
+    .catch((error) => console.error("Error syncing card history:", error));
+}
+
+function pollCredentials() {
+  conditionalFetch("api/credentials", credentialsEtag)
+    .then((response) => {
+      if (response.status === 304) return null;
+      credentialsEtag = response.headers.get("ETag");
+      return response.json();
+    })
+    .then((entries) => {
+      if (!entries || cardView !== "unique") return;
+      capturedCards = parseCredentials(entries, isPaxtonMode);
+      buildTable(capturedCards);
+    })
+    .catch((error) => console.error("Error syncing credentials:", error));
+}
+
+function updateLoadMore() {
+  const button = document.getElementById("load-more");
+  if (!button) return;
+  button.style.display =
+    cardView === "history" && historyRecords.length < historyTotal
+      ? ""
+      : "none";
+}
+
+function toggleCardView() {
+  cardView = cardView === "unique" ? "history" : "unique";
+  const toggle = document.getElementById("view-toggle");
+  if (toggle) {
+    toggle.textContent =
+      cardView === "unique" ? "Show Raw History" : "Show Unique Credentials";
+  }
+  loadCards();
+}
+
 function attachSortHandlers() {
-  document.querySelectorAll("th").forEach((th) => {
-    th.addEventListener("click", function () {
-      const column = this.getAttribute("data-column");
-      let order = this.getAttribute("data-order") || "asc";
-      order = order === "asc" ? "desc" : "asc";
-      this.setAttribute("data-order", order);
-
-      capturedCards.sort((a, b) =>
-        order === "asc"
-          ? a[column] > b[column]
-            ? 1
-            : -1
-          : a[column] < b[column]
+  // Headers are rebuilt when the view changes, so listen on the table itself
+  const table = document.querySelector(".content-table");
+  if (!table) return;
+  table.addEventListener("click", function (event) {
+    const th = event.target.closest("th");
+    if (!th || !capturedCards) return;
+    const column = th.getAttribute("data-column");
+    let order = th.getAttribute("data-order") || "asc";
+    order = order === "asc" ? "desc" : "asc";
+    th.setAttribute("data-order", order);
+
+    capturedCards.sort((a, b) =>
+      order === "asc"
+        ? a[column] > b[column]
           ? 1
           : -1
-      );
+        : a[column] < b[column]
+        ? 1
+        : -1
+    );
 
-      buildTable(capturedCards);
-    });
+    buildTable(capturedCards);
   });
 }
 
 function setHeaders(paxton) {
   const headerRow = document.querySelector(".content-table tr");
   if (!headerRow) return;
+  const uniqueHeaders =
+    cardView === "unique"
+      ? `
+      <th class="content-head" data-column="COUNT" data-order="asc">Reads</th>
+      <th class="content-head" data-column="LAST" data-order="asc">Last Seen</th>
+    `
+      : `
+      <th class="content-head" data-column="TIME" data-order="asc">Captured</th>
+    `;
   if (paxton) {
-    headerRow.innerHTML = `
+    headerRow.innerHTML =
+      `
       <th class="content-head" data-column="TYPE" data-order="desc">Bits</th>
       <th class="content-head" data-column="TOKEN" data-order="desc">Token</th>
       <th class="content-head" data-column="HEX" data-order="desc">HEX Value</th>
-    `;
+    ` + uniqueHeaders;
   } else {
-    headerRow.innerHTML = `
+    headerRow.innerHTML =
+      `
       <th class="content-head" data-column="BL" data-order="desc">Bit Length</th>
       <th class="content-head" data-column="FC" data-order="desc">Facility Code</th>
       <th class="content-head" data-column="CN" data-order="desc">Card Number</th>
-    `;
+    ` + uniqueHeaders;
   }
 }
 
-function parseCSV(csvData, paxton) {
-  const lines = csvData
-    .split("\n")
-    .map((line) => line.trim())
-    .filter(Boolean);
+function seenOrder(timestamp) {
+  // Seconds since boot are from this boot, so newer than any wall time
+  return timestamp && timestamp <= 1600000000 ? 1e10 + timestamp : timestamp;
+}
+
+function parseCredentials(entries, paxton) {
+  // Most recently seen first
+  return entries
+    .filter((entry) => entry.net2 === paxton)
+    .sort((a, b) => seenOrder(b.last) - seenOrder(a.last))
+    .map((entry) => {
+      const COUNT = entry.count;
+      const LAST = entry.last;
+      if (paxton) {
+        return { TYPE: entry.bits, TOKEN: entry.cn, HEX: entry.hex, COUNT, LAST };
+      }
+      const piv = entry.bits === 32 && isNaN(entry.cn);
+      return {
+        BL: piv ? "PIV/MF" : entry.bits,
+        FC: piv ? "N/A" : entry.fc,
+        CN: isNaN(entry.cn) ? entry.cn : parseInt(entry.cn),
+        COUNT,
+        LAST,
+      };
+    });
+}
+
+function formatSeen(timestamp) {
+  if (!timestamp) return "Unknown";
+  // Reads captured before the clock was set carry seconds since boot
+  return timestamp > 1600000000
+    ? new Date(timestamp * 1000).toLocaleString()
+    : "Boot +" + timestamp + "s";
+}
+
+function uniqueCells(row) {
+  return cardView === "unique"
+    ? `
+      <td>${row.COUNT}</td>
+      <td>${formatSeen(row.LAST)}</td>`
+    : `
+      <td>${formatSeen(row.TIME)}</td>`;
+}
+
+function parseRecords(records, paxton) {
+  // Records arrive newest first; keypad digits are grouped in capture order
+  const chronological = records.slice().reverse();
   const data = [];
   let keypadCNs = [];
+  let keypadTime = 0;
 
-  lines.forEach((line) => {
-    const parts = line.split(",");
-    if (parts.length < 3) return;
-    const left0 = parts[0] || "";
-    const dataType = left0.includes(":") ? left0.split(":")[1].trim() : "";
+  chronological.forEach((record) => {
+    const dataType = record.DATA_TYPE || "";
+    const TIME = record.time || 0;
 
     if (paxton) {
       // Handle Paxton keypad presses
       if (dataType === "PAXTON_KEYPAD") {
-        const keyPress =
-          parts[5] && parts[5].includes(":")
-            ? parts[5].split(":")[1].trim()
-            : "";
-        keypadCNs.push(keyPress);
+        keypadCNs.push(record.Key_Press || "");
+        keypadTime = TIME;
         return;
       }
 
@@ -94,23 +361,21 @@ function parseCSV(csvData, paxton) {
       if (dataType === "PAXTON") {
         // If we have pending keypad data, flush it first
         if (keypadCNs.length > 0) {
-          data.push({ TYPE: "PIN", TOKEN: keypadCNs.join(""), HEX: "N/A" });
+          data.push({
+            TYPE: "PIN",
+            TOKEN: keypadCNs.join(""),
+            HEX: "N/A",
+            TIME: keypadTime,
+          });
           keypadCNs = [];
         }
 
-      const TYPE =
-        parts[2] && parts[2].includes(":")
-          ? parts[2].split(":")[1].trim()
-          : "75";
-      const HEX =
-          parts[3] && parts[3].includes(":")
-            ? parts[3].split(":")[1].trim()
-            : "";
-      const TOKEN =
-          parts[5] && parts[5].includes(":")
-            ? parts[5].split(":")[1].trim()
-            : "";
-      data.push({ TYPE, TOKEN, HEX });
+        data.push({
+          TYPE: record.Bit_Length || "75",
+          TOKEN: record.Card_Number || "",
+          HEX: record.Hex_Value || "",
+          TIME,
+        });
         return;
       }
 
@@ -123,9 +388,9 @@ function parseCSV(csvData, paxton) {
       return;
     }
 
-    let BL = parts[2].split(":")[1]?.trim() ?? "";
-    let FC = parts[4].split(":")[1]?.trim() ?? "";
-    let CN = parts[5].split(":")[1]?.trim() ?? "";
+    let BL = record.Bit_Length ?? "";
+    let FC = record.Facility_Code ?? "";
+    let CN = record.Card_Number ?? "";
 
     BL = isNaN(BL) ? BL : parseInt(BL);
     FC = isNaN(FC) ? FC : parseInt(FC);
@@ -134,26 +399,42 @@ function parseCSV(csvData, paxton) {
     if (dataType === "KEYPAD") {
       // Only aggregate keypad rows in HID mode
       keypadCNs.push(CN);
+      keypadTime = TIME;
     } else {
       if (keypadCNs.length > 0) {
-        data.push({ BL: "PIN", FC: "N/A", CN: keypadCNs.join("") });
+        data.push({
+          BL: "PIN",
+          FC: "N/A",
+          CN: keypadCNs.join(""),
+          TIME: keypadTime,
+        });
         keypadCNs = [];
       }
       if (FC !== 0 || CN !== 0) {
-        data.push({ BL, FC, CN });
+        data.push({ BL, FC, CN, TIME });
       }
     }
   });
 
   if (keypadCNs.length > 0) {
     if (paxton) {
-      data.push({ TYPE: "PIN", TOKEN: keypadCNs.join(""), HEX: "N/A" });
+      data.push({
+        TYPE: "PIN",
+        TOKEN: keypadCNs.join(""),
+        HEX: "N/A",
+        TIME: keypadTime,
+      });
     } else {
-    data.push({ BL: "PIN", FC: "N/A", CN: keypadCNs.join("") });
+      data.push({
+        BL: "PIN",
+        FC: "N/A",
+        CN: keypadCNs.join(""),
+        TIME: keypadTime,
+      });
     }
   }
 
-  return data;
+  return data.reverse();
 }
 
 function buildTable(data) {
@@ -166,7 +447,7 @@ function buildTable(data) {
     <tr>
       <td>${row.TYPE ?? ""}</td>
       <td>${row.TOKEN ?? ""}</td>
-      <td>${row.HEX ?? ""}</td>
+      <td>${row.HEX ?? ""}</td>${uniqueCells(row)}
     </tr>`
       )
       .join("");
@@ -177,7 +458,7 @@ function buildTable(data) {
     <tr>
       <td>${row.BL}</td>
       <td>${row.FC}</td>
-      <td>${row.CN}</td>
+      <td>${row.CN}</td>${uniqueCells(row)}
     </tr>`
       )
       .join("");
@@ -16,16 +16,15 @@ function setTheme(theme) {
   const logoImages = document.querySelectorAll(".footer .theme-logo");
   if (logoImages.length > 0) {
     logoImages.forEach((img) => {
-      const timestamp = new Date().getTime();
       if (
         theme === "light" ||
         theme === "classic" ||
         theme === "github" ||
         theme === "arrow"
       ) {
-        img.src = `img/doppelganger_lm.png?t=${timestamp}`;
+        img.src = "img/doppelganger_lm.png";
       } else {
-        img.src = `img/doppelganger_dm.png?t=${timestamp}`;
+        img.src = "img/doppelganger_dm.png";
       }
     });
   }
@@ -5,7 +5,14 @@
 let ws = null;
 let isInitializing = false;
 
-// Message handlers
+// Event protocol version and the encodings offered to the device, best
+// first; it answers with a "hello" naming the one it will send
+const PROTOCOL_VERSION = 1;
+const ENCODINGS = window.decodeMsgPack ? ["msgpack", "json"] : ["json"];
+let encoding = "json";
+
+// Message handlers, keyed by the "source" of a message; "open" and "close"
+// run when the connection comes up or drops
 const handlers = {};
 
 function registerHandler(type, handler) {
@@ -15,6 +22,10 @@ function registerHandler(type, handler) {
   handlers[type].push(handler);
 }
 
+function dispatch(type, data) {
+  (handlers[type] || []).forEach((handler) => handler(data));
+}
+
 function ensureWebSocket() {
   if (isInitializing) {
     return ws;
@@ -22,21 +33,30 @@ function ensureWebSocket() {
 
   if (!ws || ws.readyState !== WebSocket.OPEN) {
     isInitializing = true;
-    ws = new WebSocket("ws://" + window.location.hostname + ":81");
+    ws = new WebSocket("ws://" + window.location.host + "/ws");
+    ws.binaryType = "arraybuffer";
 
     ws.onopen = () => {
       isInitializing = false;
+      encoding = "json";
+      ws.send(JSON.stringify({ HELLO: { v: PROTOCOL_VERSION, encodings: ENCODINGS } }));
+      // Lets the device timestamp reads when it has no NTP access
+      ws.send(JSON.stringify({ TIME: Math.floor(Date.now() / 1000) }));
+      dispatch("open");
     };
 
     ws.onmessage = (event) => {
-      if (event.data.startsWith("Connected")) {
+      const binary = event.data instanceof ArrayBuffer;
+      if (!binary && event.data.startsWith("Connected")) {
         return;
       }
 
       try {
-        const data = JSON.parse(event.data);
-        if (data.source && handlers[data.source]) {
-          handlers[data.source].forEach((handler) => handler(data));
+        const data = binary ? decodeMsgPack(event.data) : JSON.parse(event.data);
+        if (data.source === "hello") {
+          encoding = data.encoding;
+        } else if (data.source) {
+          dispatch(data.source, data);
         }
       } catch (error) {
         console.error("Error parsing WebSocket message:", error);
@@ -51,6 +71,7 @@ function ensureWebSocket() {
     ws.onclose = () => {
       ws = null;
       isInitializing = false;
+      dispatch("close");
       setTimeout(ensureWebSocket, 2000);
     };
   }
@@ -67,6 +88,7 @@ function sendData(data) {
 }
 
 window.sendData = sendData;
+window.getWebSocketEncoding = () => encoding;
 window.ensureWebSocket = ensureWebSocket;
 window.registerHandler = registerHandler;
 
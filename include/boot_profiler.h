@@ -0,0 +1,110 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <mutex>
+
+// Boot profiler
+// setup() and the network task bracket each boot phase with start()/end(),
+// timed with esp_timer from when the application started. The breakdown is
+// kept in RAM for /device-info. When the network task finishes it is logged
+// and added to a short history on flash, so a slow association or a
+// filesystem repair on an earlier boot can still be diagnosed remotely.
+// A phase that ends after that (the first SNTP sync) saves the record again.
+
+#define BOOT_HISTORY_FILE "/boots.bin"
+#define BOOT_HISTORY_TMP_FILE "/boots.tmp"
+#define BOOT_HISTORY_VERSION 1
+#define BOOT_HISTORY_LENGTH 8 // Boots kept, newest first
+
+// The position in this enum is stored in the history, so only append to it
+enum BootPhase : uint8_t
+{
+    BOOT_PHASE_FS_MOUNT,
+    BOOT_PHASE_FS_FORMAT,
+    BOOT_PHASE_CONFIG,
+    BOOT_PHASE_DEBUG,
+    BOOT_PHASE_GPIO,
+    BOOT_PHASE_READER,
+    BOOT_PHASE_CARD_LOG,
+    BOOT_PHASE_CREDENTIALS,
+    BOOT_PHASE_STATS,
+    BOOT_PHASE_STORAGE,
+    BOOT_PHASE_CLOCK,
+    BOOT_PHASE_WIFI,
+    BOOT_PHASE_MDNS,
+    BOOT_PHASE_NTP,
+    BOOT_PHASE_EMAIL,
+    BOOT_PHASE_WEB,
+    BOOT_PHASE_COUNT
+};
+
+struct BootRecord
+{
+    uint32_t bootNumber;
+    uint32_t wallTime;    // Clock when the boot finished; 0 if it was not set
+    uint8_t resetReason;  // esp_reset_reason_t
+    uint8_t reserved[3];
+    uint32_t captureReadyUs;
+    uint32_t networkReadyUs;
+    uint32_t phaseUs[BOOT_PHASE_COUNT]; // 0 when the phase did not run
+};
+
+class BootProfiler
+{
+public:
+    static BootProfiler &getInstance();
+
+    // Load the history of earlier boots; call once LittleFS is mounted
+    void begin();
+
+    void start(BootPhase phase);
+    void end(BootPhase phase);
+
+    // Milestones of this boot
+    void markCaptureReady();
+    void markFirstRead(); // Only the first call counts
+
+    // Network task done: log the breakdown and save it to the history
+    void finish();
+
+    // This boot and the history, for /device-info
+    void writeJson(JsonObject out) const;
+
+private:
+    BootProfiler();
+    ~BootProfiler() = default;
+
+    // Prevent copying
+    BootProfiler(const BootProfiler &) = delete;
+    BootProfiler &operator=(const BootProfiler &) = delete;
+
+    static uint32_t nowUs();
+    static const char *phaseName(uint8_t phase);
+    static const char *resetReasonName(uint8_t reason);
+    static void writeRecordJson(const BootRecord &record, JsonObject out);
+    static void saveJob(const uint8_t *data, size_t length);
+    bool save();
+
+    struct HistoryHeader
+    {
+        uint32_t version;
+        uint32_t length; // Bytes of records that follow
+        uint32_t crc;
+    };
+
+    BootRecord current;
+    uint32_t phaseStartUs[BOOT_PHASE_COUNT];
+    uint32_t firstReadUs;
+    bool finished;
+
+    BootRecord history[BOOT_HISTORY_LENGTH]; // Earlier boots, newest first
+    uint8_t historyCount;
+
+    mutable std::mutex profilerMutex;
+};
+
+extern BootProfiler &bootProfiler;
+
+#endif // BOOT_PROFILER_H
@@ -2,6 +2,7 @@
 #define CARD_EVENT_HANDLER_H
 
 #include "card_processor.h"
+#include "credential_index.h"
 #include "email_manager.h"
 #include "logger.h"
 #include "reset_card_manager.h"
@@ -27,6 +28,7 @@ private:
     void processNet2CardData(CardProcessor &cardProcessor);
     void processPinData(CardProcessor &cardProcessor);
     void processKeypadData(CardProcessor &cardProcessor);
+    CredentialSighting recordCredential(CardProcessor &cardProcessor);
     String formatPinCode(CardProcessor &cardProcessor);
 };
 
@@ -0,0 +1,45 @@
+#ifndef CARD_EXPORT_H
+#define CARD_EXPORT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "card_log_manager.h"
+#include "deflate_stream.h"
+
+// Compressed export of the whole card log
+// Records are pulled from the log a buffer at a time, rendered as CSV or
+// JSON lines and fed through a DeflateStream, so an export of any size needs
+// only the fixed state of one export object (about 12 KB). Only a few
+// exports may run at once to keep that bounded too.
+
+#define CARD_EXPORT_INPUT_SIZE 512
+#define CARD_EXPORT_MAX_ACTIVE 1
+
+class CardExport
+{
+public:
+    // Returns nullptr when CARD_EXPORT_MAX_ACTIVE exports are already running
+    static CardExport *create(CardLogLineFormat format);
+    ~CardExport();
+
+    // Fill buffer with the next gzip bytes; returns 0 once the stream is complete
+    size_t read(uint8_t *buffer, size_t maxLen);
+
+    uint32_t getBytesIn() const { return deflate.getTotalIn(); }
+    uint32_t getBytesOut() const { return deflate.getTotalOut(); }
+
+private:
+    explicit CardExport(CardLogLineFormat format);
+
+    CardLogCursor cursor;
+    DeflateStream deflate;
+    uint8_t input[CARD_EXPORT_INPUT_SIZE];
+    size_t inputLen;
+    size_t inputPos;
+    bool sourceDone;
+    uint32_t startTime;
+
+    static std::atomic<uint8_t> active;
+};
+
+#endif // CARD_EXPORT_H
@@ -0,0 +1,73 @@
+#ifndef CARD_LOG_INDEX_H
+#define CARD_LOG_INDEX_H
+
+#include <Arduino.h>
+
+// Secondary index for the card log
+// Every segment has a sidecar .idx file with one fixed-size entry per record
+// (sequence number, frame offset, capture time, facility code and format ID),
+// appended together with the record. Each live segment also keeps a small
+// summary in RAM - the formats it holds, a Bloom filter over its facility
+// codes and its time range - so filtered queries skip whole segments without
+// opening them and read only the index entries of the ones that may match.
+
+#define CARD_INDEX_FORMAT_OTHER 0   // Format not in the table (or not recorded)
+#define CARD_INDEX_NO_TIME UINT32_MAX
+
+// Entry flags
+#define CARD_INDEX_HAS_FC 0x01 // Record carries a numeric facility code
+
+struct CardIndexEntry
+{
+    uint32_t seq;
+    uint32_t timestamp; // Capture time (0 if unknown)
+    uint32_t facilityCode;
+    uint16_t offset; // Frame position inside the segment
+    uint8_t format;  // CardIndex format ID
+    uint8_t flags;
+};
+
+static_assert(sizeof(CardIndexEntry) == 16, "CardIndexEntry must be packed to 16 bytes");
+
+struct CardSegmentSummary
+{
+    uint32_t formatMask; // Bit per format ID present in the segment
+    uint32_t fcBloom;    // Two bits per facility code
+    uint32_t minTime;    // CARD_INDEX_NO_TIME when no record has a time
+    uint32_t maxTime;
+};
+
+// Filter of a /api/cards query; zero fields are unbounded
+struct CardLogFilter
+{
+    bool active = false;
+    bool hasFormat = false;
+    uint32_t formatMask = 0; // Format IDs accepted when hasFormat is set
+    bool hasFacilityCode = false;
+    uint32_t facilityCode = 0;
+    uint32_t from = 0; // Capture time range, inclusive
+    uint32_t to = 0;
+    uint32_t afterSeq = 0; // Continuation: only records newer / older than these
+    uint32_t beforeSeq = 0;
+};
+
+// Map a stored "Format" value to its ID
+uint8_t cardIndexFormatId(const char *format, size_t length);
+
+// Name of a format ID ("Other" for CARD_INDEX_FORMAT_OTHER and unknown IDs)
+const char *cardIndexFormatName(uint8_t id);
+
+// Mask of every known format whose name contains the query (case-insensitive)
+uint32_t cardIndexFormatMask(const char *query);
+
+// Fill format, facility code and flags from a stored "Key: Value, ..." record
+void cardIndexParseRecord(const char *payload, size_t length, CardIndexEntry &entry);
+
+void cardIndexClearSummary(CardSegmentSummary &summary);
+void cardIndexAddToSummary(CardSegmentSummary &summary, const CardIndexEntry &entry);
+
+// Summary test: false only when no record of the segment can match
+bool cardIndexSummaryMayMatch(const CardSegmentSummary &summary, const CardLogFilter &filter);
+bool cardIndexEntryMatches(const CardIndexEntry &entry, const CardLogFilter &filter);
+
+#endif // CARD_LOG_INDEX_H
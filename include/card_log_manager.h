@@ -0,0 +1,253 @@
+#ifndef CARD_LOG_MANAGER_H
+#define CARD_LOG_MANAGER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <mutex>
+#include "card_log_index.h"
+
+// Segmented card log
+// Records are appended to fixed-size segment files under CARD_LOG_DIR. The
+// manifest names the live range [firstSegment, activeSegment] of the current
+// epoch. A wipe only bumps the epoch; stale segment files are removed a few
+// at a time from update(), so appends and wipes take bounded time.
+//
+// Each record is stored as a CardLogFrameHeader followed by its payload. The
+// CRC covers the header (with crc = 0) and payload, so a record torn by a
+// reset is detected and dropped at boot. Only the active segment is scanned
+// during recovery, which keeps boot time independent of the log size.
+// Version 2 frames carry the capture time (see clock_manager.h); version 1
+// frames written by older firmware are still read, without a time.
+//
+// A sidecar .idx file per segment (see card_log_index.h) lets filtered
+// queries skip segments and frames without parsing record text.
+
+#define CARD_LOG_DIR "/log"
+#define CARD_LOG_MANIFEST_FILE "/log/manifest.json"
+#define CARD_LOG_MANIFEST_TMP_FILE "/log/manifest.tmp"
+#define CARD_LOG_RECOVERY_TMP_FILE "/log/recover.tmp"
+#define CARD_LOG_MANIFEST_VERSION 2
+
+#define CARD_LOG_INDEX_TMP_FILE "/log/index.tmp"
+
+#ifndef CARD_LOG_SEGMENT_SIZE
+#define CARD_LOG_SEGMENT_SIZE 16384         // Bytes written to a segment before rotating
+#endif
+#ifndef CARD_LOG_MAX_SEGMENTS
+#define CARD_LOG_MAX_SEGMENTS 64            // Upper bound on live segments
+#endif
+#ifndef CARD_LOG_DEFAULT_MAX_BYTES
+#define CARD_LOG_DEFAULT_MAX_BYTES 524288   // Default total cap (512 KB)
+#endif
+#define CARD_LOG_MIN_MAX_BYTES (2 * CARD_LOG_SEGMENT_SIZE)
+#define CARD_LOG_MAX_RECORD 320             // Longest single record line
+
+#define CARD_PAGE_DEFAULT_LIMIT 50
+#define CARD_PAGE_MAX_LIMIT 200
+#define CARD_PAGE_RENDER_SIZE 640 // One record rendered as JSON
+
+#define CARD_LOG_FRAME_MAGIC 0xC5
+#define CARD_LOG_FRAME_VERSION 2
+#define CARD_LOG_FRAME_V1 1
+#define CARD_LOG_FRAME_V1_HEADER_SIZE 12 // Version 1 has no timestamp: crc follows seq
+#define CARD_LOG_TIME_FIELD_SIZE 40      // ", Timestamp: ..." appended to CSV lines
+
+struct CardLogFrameHeader
+{
+    uint8_t magic;
+    uint8_t version;
+    uint16_t length;    // Payload bytes following the header
+    uint32_t seq;       // Monotonic record sequence number
+    uint32_t timestamp; // Capture time, wall clock or seconds since boot; 0 if unknown
+    uint32_t crc;       // CRC32 over header (crc = 0) and payload
+};
+
+static_assert(sizeof(CardLogFrameHeader) == 16, "CardLogFrameHeader must be packed to 16 bytes");
+static_assert(CARD_LOG_SEGMENT_SIZE + sizeof(CardLogFrameHeader) + CARD_LOG_MAX_RECORD <= 65536,
+              "Frame offsets inside a segment must fit in 16 bits");
+
+enum CardLogFullPolicy
+{
+    CARD_LOG_EVICT_OLDEST,
+    CARD_LOG_STOP_WHEN_FULL
+};
+
+enum CardLogLineFormat
+{
+    CARD_LOG_LINES_CSV,  // Stored record plus ", Timestamp: ..."
+    CARD_LOG_LINES_JSONL // One JSON object per line, as in /api/cards
+};
+
+// Read position used to stream the log (e.g. chunked HTTP responses)
+struct CardLogCursor
+{
+    CardLogLineFormat format = CARD_LOG_LINES_CSV;
+    uint32_t epoch = 0;
+    uint32_t segment = 0;
+    uint32_t offset = 0;
+    bool started = false;
+
+    // Rendered line that did not fit in the previous output buffer
+    uint16_t pendingLen = 0;
+    uint16_t pendingPos = 0;
+    char pending[CARD_PAGE_RENDER_SIZE + 1];
+};
+
+static_assert(CARD_PAGE_RENDER_SIZE >= CARD_LOG_MAX_RECORD + CARD_LOG_TIME_FIELD_SIZE,
+              "CSV lines must fit the cursor line buffer");
+
+enum CardPageOrder
+{
+    CARD_PAGE_ASC, // Oldest first
+    CARD_PAGE_DESC // Newest first
+};
+
+// State of one /api/cards page being streamed. Its size is fixed, so the
+// RAM a request needs does not depend on the size of the log.
+struct CardPageCursor
+{
+    uint32_t offset = 0;
+    uint16_t limit = CARD_PAGE_DEFAULT_LIMIT;
+    CardPageOrder order = CARD_PAGE_DESC;
+
+    uint32_t epoch = 0;
+    uint32_t segment = 0;
+    uint32_t fileOffset = 0;  // Next frame (oldest-first walk)
+    uint32_t skip = 0;        // Frames still to skip in the current segment
+    uint32_t minSeq = 0;      // Oldest-first walk: skip frames below this sequence number
+    bool hasSince = false;    // since= request: records newer than `since`, oldest first
+    uint32_t since = 0;
+    int32_t nextIndex = -1;   // Newest-first walk: next frame index to window
+    CardLogFilter filter;     // Filtered walk over the segment indexes
+    bool inSegment = false;   // Current segment passed its summary test
+    uint32_t entryIndex = 0;  // Next index entry (oldest first) or entries left (newest first)
+    uint16_t segmentsScanned = 0;
+    uint32_t lastSeq = 0;
+    uint16_t positions[CARD_PAGE_MAX_LIMIT];
+    uint16_t positionCount = 0;
+    uint32_t remaining = 0;
+    uint16_t emitted = 0;
+    bool started = false;
+    bool finished = false;
+
+    uint16_t pendingLen = 0;
+    uint16_t pendingPos = 0;
+    char pending[CARD_PAGE_RENDER_SIZE];
+};
+
+class CardLogManager
+{
+public:
+    static CardLogManager &getInstance();
+
+    // Mount-time setup: load or create the manifest, migrate legacy cards.csv
+    void begin();
+
+    // Hand out the sequence number for a record about to be queued
+    uint32_t reserveSeq() { return nextSeq++; }
+
+    // Hand back a reserved number whose record was never queued, so the log
+    // stays gapless; only the most recent reservation can be returned
+    void releaseSeq(uint32_t seq)
+    {
+        uint32_t expected = seq + 1;
+        nextSeq.compare_exchange_strong(expected, seq);
+    }
+
+    // Append one record line (without trailing newline) under a reserved sequence number
+    bool append(const char *record, size_t length, uint32_t seq, uint32_t timestamp);
+
+    // Rewrite boot-relative capture times of this boot's records as wall-clock times
+    void resolveBootTimes(uint32_t wallOffset);
+
+    // Drop all stored records by starting a new epoch
+    void wipe();
+
+    // Background housekeeping - removes at most one stale segment per call
+    void update();
+
+    // Stream stored records in capture order as CSV or JSON lines; returns 0 at end of log
+    size_t read(CardLogCursor &cursor, uint8_t *buffer, size_t maxLen);
+
+    // Stream one page of records as a JSON document; returns 0 when done
+    size_t readPage(CardPageCursor &cursor, uint8_t *buffer, size_t maxLen);
+
+    // Render a stored "Key: Value, ..." record as a JSON object
+    static int renderRecordJson(uint32_t seq, uint32_t timestamp, const char *payload, size_t length, char *out,
+                                size_t outLen);
+
+    // Capacity configuration
+    void setCapacity(uint32_t maxBytes, CardLogFullPolicy policy);
+    uint32_t getMaxBytes() const { return maxBytes; }
+    CardLogFullPolicy getPolicy() const { return policy; }
+
+    // Status
+    uint32_t getEpoch() const { return epoch; }
+    uint32_t getSegmentCount() const { return activeSegment - firstSegment + 1; }
+    uint32_t getUsedBytes() const;
+    uint32_t getRecordCount() const;
+    uint32_t getNextSeq() const { return nextSeq; }
+    uint32_t getHeadSeq() const { return headSeq; }
+    bool isFull() const { return full; }
+
+    // Strong validator for the stored records: changes on every append, wipe,
+    // eviction or resolve of boot-relative times
+    void getEtag(char *out, size_t outLen) const;
+
+private:
+    CardLogManager();
+    ~CardLogManager() = default;
+
+    // Prevent copying
+    CardLogManager(const CardLogManager &) = delete;
+    CardLogManager &operator=(const CardLogManager &) = delete;
+
+    bool loadManifest();
+    bool saveManifest();
+    void resetManifest(uint32_t newEpoch);
+    void migrateLegacyLog();
+    void recoverActiveSegment();
+    bool rotate(uint32_t baseSeq);
+    bool writeFrame(const char *record, size_t length, uint32_t seq, uint32_t timestamp);
+    bool isStaleSegment(const char *name) const;
+    static void segmentPath(char *out, size_t outLen, uint32_t epoch, uint32_t index);
+    static void indexPath(char *out, size_t outLen, uint32_t epoch, uint32_t index);
+    void syncSegmentIndex(uint32_t index);
+    static uint32_t frameCrc(const CardLogFrameHeader &header, const uint8_t *payload);
+    static size_t frameSize(const CardLogFrameHeader &header);
+    static bool readFrameHeader(File &segment, CardLogFrameHeader &header);
+    static bool readFrame(File &segment, CardLogFrameHeader &header, char *payload);
+    uint32_t resolveSegmentTimes(uint32_t index, uint32_t wallOffset);
+    uint32_t countRecords() const;
+    void startPage(CardPageCursor &cursor);
+    bool nextPageRecord(CardPageCursor &cursor, File &segment, uint32_t &openSegment,
+                        CardLogFrameHeader &header, char *payload);
+    bool openSegmentAt(File &segment, uint32_t &openSegment, uint32_t index, uint32_t position);
+    bool segmentMayMatch(uint32_t index, const CardLogFilter &filter) const;
+    bool nextFilteredRecord(CardPageCursor &cursor, File &segment, uint32_t &openSegment, File &indexFile,
+                            uint32_t &openIndex, CardLogFrameHeader &header, char *payload);
+
+    uint32_t epoch;
+    uint32_t firstSegment;
+    uint32_t activeSegment;
+    uint32_t activeSize;
+    std::atomic<uint32_t> nextSeq;
+    uint32_t headSeq; // Sequence number of the newest stored record
+    uint32_t bootFirstSeq; // First sequence number written during this boot
+    uint32_t wallOffset;   // Added to boot-relative times once the clock is known
+    uint32_t resolveCount; // Resolves that rewrote records, kept in the manifest
+    uint32_t segmentBaseSeq[CARD_LOG_MAX_SEGMENTS]; // First seq of each live segment, indexed by segment % CARD_LOG_MAX_SEGMENTS
+    uint32_t segmentRecords[CARD_LOG_MAX_SEGMENTS]; // Records stored in each live segment
+    CardSegmentSummary segmentSummary[CARD_LOG_MAX_SEGMENTS];
+    uint32_t maxBytes;
+    CardLogFullPolicy policy;
+    bool full;
+    bool gcPending;
+
+    mutable std::mutex logMutex;
+};
+
+extern CardLogManager &cardLogManager;
+
+#endif
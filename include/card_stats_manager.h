@@ -0,0 +1,91 @@
+#ifndef CARD_STATS_MANAGER_H
+#define CARD_STATS_MANAGER_H
+
+#include <Arduino.h>
+#include <mutex>
+#include "card_processor.h"
+
+// Read statistics
+// Aggregate counters (per format, per facility code, per hour of day, bad
+// reads) are updated on every read and kept in RAM, so /api/stats never scans
+// the card log. The storage task saves them while idle, at most once per
+// CARD_STATS_SAVE_INTERVAL_MS, so they survive a reboot.
+
+#define CARD_STATS_FILE "/stats.bin"
+#define CARD_STATS_TMP_FILE "/stats.tmp"
+#define CARD_STATS_VERSION 1
+#define CARD_STATS_FORMATS 32           // Indexed by card log format ID
+#define CARD_STATS_FACILITY_CODES 64    // Distinct facility codes counted individually
+#define CARD_STATS_SAVE_INTERVAL_MS 60000
+
+struct CardStatsFacility
+{
+    uint32_t facilityCode;
+    uint32_t count;
+};
+
+struct CardStatsCounters
+{
+    uint32_t since; // Capture time of the first counted read (0 if unknown)
+    uint32_t total;
+    uint32_t badReads; // No parser for the bit length
+    uint32_t byFormat[CARD_STATS_FORMATS];
+    uint32_t byHour[24];   // Hour of day (UTC) of the read
+    uint32_t hourUnknown;  // Reads taken before the clock was set
+    uint32_t facilityOther; // Reads of facility codes beyond the table
+    uint32_t facilityCount;
+    CardStatsFacility facilities[CARD_STATS_FACILITY_CODES];
+};
+
+class CardStatsManager
+{
+public:
+    static CardStatsManager &getInstance();
+
+    // Load the saved counters
+    void begin();
+
+    // Count one completed read
+    void recordRead(CardProcessor &cardProcessor);
+
+    // Zero every counter
+    void clear();
+
+    // Storage task housekeeping - saves the counters when due
+    void update();
+
+    // Write the counters as a JSON document
+    void writeJson(Print &out);
+
+    // Bumped on every change; used as the HTTP validator for /api/stats
+    uint32_t getVersion() const { return version; }
+
+private:
+    CardStatsManager();
+    ~CardStatsManager() = default;
+
+    // Prevent copying
+    CardStatsManager(const CardStatsManager &) = delete;
+    CardStatsManager &operator=(const CardStatsManager &) = delete;
+
+    struct StatsFileHeader
+    {
+        uint32_t version;
+        uint32_t length;
+        uint32_t crc;
+    };
+
+    void load();
+    void save();
+
+    CardStatsCounters counters;
+    volatile uint32_t version;
+    uint32_t savedVersion;
+    uint32_t lastSave;
+
+    std::mutex statsMutex;
+};
+
+extern CardStatsManager &cardStatsManager;
+
+#endif
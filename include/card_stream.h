@@ -0,0 +1,94 @@
+#ifndef CARD_STREAM_H
+#define CARD_STREAM_H
+
+#include <Arduino.h>
+#include <mutex>
+#include "card_log_manager.h"
+
+// Live card reads
+// Every record queued for the card log (cards, PIN digits and keypad
+// presses) is also published here, and the main loop pushes it to
+// WebSocket clients that subscribed with {"CARDS": true}. Records are
+// rendered exactly as /api/cards renders them and carry the same sequence
+// number and epoch, so a client that sees a jump, or a frame reporting
+// skipped records, fetches the rest with /api/cards?since=. Repeat reads that the
+// credential index only counts are announced without a record so the
+// unique view can refresh. Each record also carries age_us, the time from
+// capture to the frame being sent.
+
+#define CARD_STREAM_HISTORY 8 // Events kept for subscribers (power of two)
+#define CARD_STREAM_MAX_CLIENTS 4
+#define CARD_STREAM_BATCH 4   // Most records per WebSocket frame
+
+struct CardStreamStats
+{
+    uint8_t subscribers;
+    uint32_t published;
+    uint32_t skipped;       // Events subscribers missed and had to backfill
+    uint32_t lastLatencyUs; // Capture to send, newest record sent
+    uint32_t maxLatencyUs;
+};
+
+class CardStream
+{
+public:
+    static CardStream &getInstance();
+
+    // A record was queued for the card log under seq
+    void publish(uint32_t seq, uint32_t timestamp, const char *record, size_t length);
+
+    // A repeat read was counted but not logged
+    void publishRepeat();
+
+    // Returns false when every subscriber slot is taken
+    bool subscribe(uint32_t client);
+    void unsubscribe(uint32_t client);
+
+    // Send pending events to subscribers (main loop)
+    void update();
+
+    CardStreamStats getStats();
+
+private:
+    CardStream();
+    ~CardStream() = default;
+
+    // Prevent copying
+    CardStream(const CardStream &) = delete;
+    CardStream &operator=(const CardStream &) = delete;
+
+    struct Event
+    {
+        bool logged;        // False for a repeat that only updated counters
+        uint32_t seq;       // Card log sequence number
+        uint32_t timestamp;
+        uint32_t captureUs; // esp_timer when published
+        uint16_t length;
+        char text[CARD_LOG_MAX_RECORD];
+    };
+
+    struct Subscriber
+    {
+        bool active;
+        uint32_t client;
+        uint32_t nextEvent; // Next event this client has not seen
+        uint32_t skipped;   // Events lost since the last frame
+    };
+
+    void append(const Event &event);
+    void send(Subscriber &subscriber);
+
+    Event history[CARD_STREAM_HISTORY];
+    uint32_t head; // Position of the next event
+    std::mutex historyMutex;
+
+    Subscriber subscribers[CARD_STREAM_MAX_CLIENTS];
+    uint8_t activeCount;
+    Event outbox[CARD_STREAM_BATCH]; // Events of the frame being built
+
+    CardStreamStats stats;
+};
+
+extern CardStream &cardStream;
+
+#endif // CARD_STREAM_H
@@ -0,0 +1,104 @@
+#ifndef CLOCK_MANAGER_H
+#define CLOCK_MANAGER_H
+
+#include <Arduino.h>
+#include <mutex>
+
+// Capture clock
+// Timestamps taken before the wall clock is known are stored as seconds
+// since boot. Values below CLOCK_MIN_VALID_TIME (September 2020) are never a
+// real date, so a single 32-bit field holds either kind; 0 means unknown.
+// Once SNTP syncs or a browser supplies its clock, the boot-to-wall offset is
+// fixed and records captured earlier in this boot are resolved in place.
+//
+// SNTP runs in the background in UTC: startSync() returns at once, the
+// sync callback does the rest, and SNTP re-syncs every
+// CLOCK_SYNC_INTERVAL_MS. Each re-sync is compared with the wall time
+// predicted from the previous one, which gives the correction it applied
+// and the drift of the local clock between syncs.
+
+#define CLOCK_MIN_VALID_TIME 1600000000UL
+
+#ifndef CLOCK_NTP_SERVER_1
+#define CLOCK_NTP_SERVER_1 "pool.ntp.org"
+#endif
+#ifndef CLOCK_NTP_SERVER_2
+#define CLOCK_NTP_SERVER_2 "time.nist.gov"
+#endif
+#ifndef CLOCK_SYNC_INTERVAL_MS
+#define CLOCK_SYNC_INTERVAL_MS 3600000UL // SNTP re-sync period
+#endif
+
+struct ClockSyncStats
+{
+    const char *source;   // What first set the clock; nullptr while unset
+    uint32_t syncCount;   // SNTP syncs this boot
+    uint32_t lastSync;    // Wall time of the last SNTP sync; 0 if none
+    int32_t lastOffsetMs; // Correction applied by the last re-sync
+    int32_t driftPpm;     // Local clock error between the last two syncs
+    bool hasDrift;        // False until a second SNTP sync
+};
+
+class ClockManager
+{
+public:
+    static ClockManager &getInstance();
+
+    // Register for SNTP sync notifications
+    void begin();
+
+    // Start background SNTP once the network is up; never blocks
+    void startSync();
+
+    // Wall-clock seconds once synced, otherwise seconds since boot (at least 1)
+    uint32_t now() const;
+    bool isSynced() const { return wallOffset != 0; }
+
+    // Wall time minus seconds since boot; 0 until the first sync
+    uint32_t getWallOffset() const { return wallOffset; }
+
+    // A boot-relative time from this boot as wall time, once that is known
+    uint32_t toWallTime(uint32_t timestamp) const
+    {
+        uint32_t offset = wallOffset;
+        return (offset != 0 && timestamp != 0 && !isWallTime(timestamp)) ? timestamp + offset : timestamp;
+    }
+
+    // Set the clock from a browser when SNTP has not synced yet
+    void setFromBrowser(uint32_t epochSeconds);
+
+    ClockSyncStats getSyncStats() const;
+
+    // Resolve earlier records if the storage queue refused the job at sync
+    // time (storage task, when its queue is empty)
+    void update();
+
+    static bool isWallTime(uint32_t timestamp) { return timestamp >= CLOCK_MIN_VALID_TIME; }
+    static uint32_t secondsSinceBoot();
+
+private:
+    ClockManager();
+    ~ClockManager() = default;
+
+    // Prevent copying
+    ClockManager(const ClockManager &) = delete;
+    ClockManager &operator=(const ClockManager &) = delete;
+
+    void onSynced(const char *source);
+    void onSntpSync(const struct timeval *tv);
+    static void sntpSyncCallback(struct timeval *tv);
+    static void resolveJob(const uint8_t *data, size_t length);
+
+    volatile uint32_t wallOffset;
+    volatile bool resolvePending;
+
+    // SNTP bookkeeping, written from the lwIP task
+    mutable std::mutex syncMutex;
+    ClockSyncStats stats;
+    int64_t lastSyncMonoUs; // esp_timer at the last SNTP sync
+    int64_t lastSyncWallUs; // Wall time it set, in microseconds
+};
+
+extern ClockManager &clockManager;
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef COMMAND_EXECUTOR_H
+#define COMMAND_EXECUTOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "card_log_manager.h"
+#include "config_manager.h"
+
+// Command executor
+// Control messages from the web UI are parsed into typed commands and
+// queued here; a worker task carries them out one at a time. Each command
+// gets an ID. Its client is told {"source": "command", "id": N, "command":
+// "<name>", "state": "queued"} when it is queued. When the command finishes,
+// the client gets the same response as before ("status", "source", ...)
+// plus "id", "command" and "state" ("done" or "failed"). Nothing in the
+// worker sleeps. Commands that need a restart flush the configuration and
+// arm a timer, which restarts once the storage task is idle.
+//
+// The worker runs on the loop's core at the loop's priority, so time
+// slicing keeps a long command from holding the loop off. Reader, GPIO and
+// reset card changes are only committed here; their listeners subscribe
+// for the main loop and apply them between passes (see ConfigManager).
+
+#define COMMAND_QUEUE_LENGTH 8
+#define COMMAND_TASK_STACK 6144
+#define COMMAND_TASK_PRIORITY 1
+#define COMMAND_TASK_CORE 1
+#define COMMAND_RESTART_DELAY_MS 1000    // Lets the completion reach the client
+#define COMMAND_RESTART_MAX_WAIT_MS 5000 // Longest a restart waits for queued flash writes
+#define COMMAND_RESTART_POLL_MS 100
+
+enum CommandType : uint8_t
+{
+    COMMAND_DEBUG,
+    COMMAND_READER_TYPE,
+    COMMAND_GPIO,
+    COMMAND_CARD_LOG_CAPACITY,
+    COMMAND_CREDENTIAL_OPTIONS,
+    COMMAND_RESET_GPIO,
+    COMMAND_WIPE_CARDS,
+    COMMAND_RESTORE_NOTIFICATIONS,
+    COMMAND_RESET_CARD_DEFAULTS,
+    COMMAND_WIPE_WIFI,
+    COMMAND_FACTORY_RESET,
+    COMMAND_NOTIFICATIONS,
+    COMMAND_RESET_CARD,
+    COMMAND_PAXTON_RESET_CARD,
+    COMMAND_TYPE_COUNT
+};
+
+struct DebugCommand
+{
+    bool setEnabled; // False when only the log level was sent
+    bool enabled;
+    uint8_t logLevel;
+};
+
+struct CardLogCapacityCommand
+{
+    uint32_t maxBytes;
+    CardLogFullPolicy policy;
+};
+
+struct CredentialOptionsCommand
+{
+    uint32_t renotifySeconds;
+    bool logRepeats;
+};
+
+struct ResetCardCommand
+{
+    uint16_t bitLength;
+    uint32_t facilityCode;
+    uint32_t cardNumber;
+};
+
+struct Command
+{
+    CommandType type;
+    uint32_t id;     // Assigned by submit()
+    uint32_t client; // WebSocket client that gets the acknowledgement and result
+    union
+    {
+        DebugCommand debug;
+        uint8_t readerType; // ReaderType
+        GpioConfig gpio;
+        CardLogCapacityCommand cardLog;
+        CredentialOptionsCommand credentials;
+        NotificationConfig notifications;
+        ResetCardCommand resetCard;
+        char paxtonHex[CONFIG_PAXTON_HEX_LENGTH + 1];
+    };
+};
+
+struct CommandStats
+{
+    uint32_t depth;
+    uint32_t executed;
+    uint32_t failed;
+    uint32_t dropped; // Commands refused because the queue was full
+    uint32_t lastDurationUs;
+    uint32_t maxDurationUs;
+};
+
+class CommandExecutor
+{
+public:
+    static CommandExecutor &getInstance();
+
+    // Create the queue and start the worker
+    void begin();
+
+    // Queue a command and acknowledge it to its client; returns its ID, or 0
+    // if it was refused. Called from the main loop only.
+    uint32_t submit(Command &command);
+
+    // Flush the configuration and restart once queued flash writes are done;
+    // returns at once. Also used by the reset card and WiFi reset paths.
+    void scheduleRestart();
+
+    static const char *commandName(CommandType type);
+
+    CommandStats getStats() const;
+
+private:
+    CommandExecutor();
+    ~CommandExecutor() = default;
+
+    // Prevent copying
+    CommandExecutor(const CommandExecutor &) = delete;
+    CommandExecutor &operator=(const CommandExecutor &) = delete;
+
+    // Carry out a command and fill in its response; returns false if it failed
+    bool execute(const Command &command, JsonDocument &response);
+    // Send the result to the command's client
+    void complete(const Command &command, bool ok, JsonDocument &response);
+    static void restartTimerCallback(void *arg);
+    static void commandTaskFunction(void *parameter);
+
+    QueueHandle_t queue;
+    TaskHandle_t commandTaskHandle;
+    StaticQueue_t queueControl;
+    uint8_t queueStorage[COMMAND_QUEUE_LENGTH * sizeof(Command)];
+    Command current;
+
+    esp_timer_handle_t restartTimer;
+    int64_t restartRequestedAt;
+
+    uint32_t nextId;
+    volatile uint32_t executed;
+    volatile uint32_t failed;
+    volatile uint32_t dropped;
+    volatile uint32_t lastDurationUs;
+    volatile uint32_t maxDurationUs;
+};
+
+extern CommandExecutor &commandExecutor;
+
+#endif // COMMAND_EXECUTOR_H
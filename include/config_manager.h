@@ -0,0 +1,198 @@
+#ifndef CONFIG_MANAGER_H
+#define CONFIG_MANAGER_H
+
+#include <Arduino.h>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Device configuration
+// Every setting lives in one typed DeviceConfig, loaded once at boot from a
+// versioned, CRC-checked file. A commit replaces the sections it names,
+// notifies the subsystems that subscribed to them and marks the blob dirty.
+// update() saves it once commits have been quiet for CONFIG_SAVE_DELAY_MS
+// (or at most CONFIG_SAVE_MAX_DELAY_MS after the first), so a burst of
+// changes costs one flash write. The save runs on the storage task and
+// writes a temporary file that is renamed over the old one, so a power cut
+// leaves either the old or the new configuration.
+//
+// Listeners that touch capture state (reader interrupts, GPIO pulses, the
+// reset card key) subscribe for the main loop. A commit made on another
+// task leaves their sections pending, and applyPending() at the top of
+// loop() calls them, so they never change state mid-pass.
+//
+// The file stores one record per field (ID, size, bytes), not the raw
+// struct, so a firmware that adds, widens or removes a field still loads
+// every setting it shares with the one that saved it; new fields take their
+// defaults. Field IDs are listed in config_manager.cpp and are permanent.
+//
+// The first boot after an upgrade migrates the per-subsystem JSON files that
+// used to hold these settings, then removes them. The web UI still fetches
+// those paths; main.cpp serves them from RAM through writeJson().
+
+#define CONFIG_FILE "/config.bin"
+#define CONFIG_TMP_FILE "/config.tmp"
+#define CONFIG_VERSION 2       // Field records
+#define CONFIG_VERSION_RAW 1   // Raw DeviceConfig, read once and rewritten
+#define CONFIG_FILE_MAX_BODY 512
+
+// Legacy files read once by the migration
+#define CONFIG_LEGACY_READER_FILE "/www/reader_config.json"
+#define CONFIG_LEGACY_DEBUG_FILE "/www/debug_config.json"
+#define CONFIG_LEGACY_GPIO_FILE "/www/gpio_settings.json"
+#define CONFIG_LEGACY_GPIO_COPY_FILE "/www/gpio.json"
+#define CONFIG_LEGACY_NOTIFICATION_FILE "/notifications.json"
+#define CONFIG_LEGACY_RESET_CARD_FILE "/www/reset_card.json"
+#define CONFIG_LEGACY_CREDENTIAL_FILE "/www/credential_config.json"
+
+#ifndef CONFIG_SAVE_DELAY_MS
+#define CONFIG_SAVE_DELAY_MS 500 // Quiet time before a dirty configuration is saved
+#endif
+#ifndef CONFIG_SAVE_MAX_DELAY_MS
+#define CONFIG_SAVE_MAX_DELAY_MS 5000 // Longest a change may wait under steady commits
+#endif
+
+#define CONFIG_MAX_LISTENERS 8
+#define CONFIG_SMTP_FIELD_SIZE 35
+#define CONFIG_SMTP_PORT_SIZE 6
+#define CONFIG_PAXTON_HEX_LENGTH 10
+
+enum ConfigSection : uint32_t
+{
+    CONFIG_READER = 1UL << 0,
+    CONFIG_DEBUG = 1UL << 1,
+    CONFIG_GPIO = 1UL << 2,
+    CONFIG_NOTIFICATIONS = 1UL << 3,
+    CONFIG_RESET_CARD = 1UL << 4,
+    CONFIG_CREDENTIALS = 1UL << 5,
+    CONFIG_ALL = 0x3F
+};
+
+struct GpioConfig
+{
+    bool pin35Enabled;
+    bool pin36Enabled;
+    bool pin35DefaultHigh;
+    bool pin36DefaultHigh;
+    uint16_t pin35PulseMs;
+    uint16_t pin36PulseMs;
+};
+
+struct NotificationConfig
+{
+    bool enableEmail;
+    char smtpHost[CONFIG_SMTP_FIELD_SIZE];
+    char smtpPort[CONFIG_SMTP_PORT_SIZE];
+    char smtpUser[CONFIG_SMTP_FIELD_SIZE];
+    char smtpPass[CONFIG_SMTP_FIELD_SIZE];
+    char smtpRecipient[CONFIG_SMTP_FIELD_SIZE];
+};
+
+struct ResetCardConfig
+{
+    uint16_t bitLength;
+    uint32_t facilityCode;
+    uint32_t cardNumber;
+    char paxtonHex[CONFIG_PAXTON_HEX_LENGTH + 1]; // Upper case
+};
+
+struct DeviceConfig
+{
+    uint8_t readerType; // ReaderType
+    bool debugEnabled;
+    uint8_t logLevel; // Serial console level while debug output is enabled
+    GpioConfig gpio;
+    NotificationConfig notifications;
+    ResetCardConfig resetCard;
+    uint32_t credentialRenotifySeconds;
+    bool credentialLogRepeats;
+};
+
+// Called after a commit with the sections that changed
+typedef void (*ConfigListener)(uint32_t sections, const DeviceConfig &config);
+
+class ConfigManager
+{
+public:
+    static ConfigManager &getInstance();
+
+    // Load the blob (or migrate the legacy files); call right after mounting LittleFS
+    void begin();
+
+    // Copy of the current configuration
+    DeviceConfig get() const;
+
+    // Take the named sections from config, notify listeners and mark them dirty
+    void commit(const DeviceConfig &config, uint32_t sections);
+
+    // Commit the factory defaults of the named sections
+    void restoreDefaults(uint32_t sections);
+
+    // Queue the save once the debounce window has passed (main loop)
+    void update();
+
+    // Queue the save now, e.g. before a restart; false if the queue is full
+    bool flush();
+
+    // Listeners are called on the committing task, outside the lock;
+    // main loop listeners wait for applyPending() when that is another task
+    void subscribe(uint32_t sections, ConfigListener listener, bool onMainLoop = false);
+
+    // Call main loop listeners for sections committed by other tasks (main loop)
+    void applyPending();
+
+    // One section in the JSON layout of its legacy file
+    void writeJson(uint32_t section, Print &out) const;
+
+    // Time begin() took, for the boot log and /api/storage
+    uint32_t getLoadMicros() const { return loadMicros; }
+
+private:
+    ConfigManager();
+    ~ConfigManager() = default;
+
+    // Prevent copying
+    ConfigManager(const ConfigManager &) = delete;
+    ConfigManager &operator=(const ConfigManager &) = delete;
+
+    static void setDefaults(DeviceConfig &config, uint32_t sections);
+    static void copySections(DeviceConfig &to, const DeviceConfig &from, uint32_t sections);
+    bool load(bool &upgraded);
+    static size_t encode(const DeviceConfig &config, uint8_t *out, size_t outLen);
+    static bool decode(const uint8_t *data, size_t length, DeviceConfig &config);
+    void migrate();
+    static void saveJob(const uint8_t *data, size_t length);
+    bool save();
+
+    struct ConfigFileHeader
+    {
+        uint32_t version;
+        uint32_t length;
+        uint32_t crc;
+    };
+
+    struct Listener
+    {
+        uint32_t sections;
+        ConfigListener callback;
+        bool onMainLoop;
+    };
+
+    DeviceConfig config;
+    mutable std::mutex configMutex;
+    Listener listeners[CONFIG_MAX_LISTENERS];
+    uint8_t listenerCount;
+    uint32_t mainLoopSections; // Sections with a main loop listener
+    TaskHandle_t mainLoopTask; // Task that ran begin(), i.e. setup() and loop()
+    uint32_t loadMicros;
+
+    // Guarded by configMutex
+    uint32_t dirtySections;
+    unsigned long firstDirty; // millis() of the oldest unsaved commit
+    unsigned long lastDirty;  // millis() of the newest unsaved commit
+    uint32_t pendingSections; // Committed elsewhere, not yet seen by main loop listeners
+};
+
+extern ConfigManager &configManager;
+
+#endif // CONFIG_MANAGER_H
@@ -0,0 +1,114 @@
+#ifndef CONSOLE_LOG_H
+#define CONSOLE_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Console log sink
+// Lines are formatted once into a fixed slot of a lock-free multi-producer
+// ring (bounded MPMC queue with a sequence number per slot) and written to
+// the USB CDC console by a low-priority task. A producer never waits for the
+// console or for another producer: when the ring is full the line is dropped
+// and counted, and the drain task reports the loss once it catches up.
+// Every line carries its level; the drain task writes it to Serial if the
+// serial level allows and hands it to the tap (the web console stream).
+
+// Log levels (see log.h)
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_VERBOSE 5
+
+#define CONSOLE_LOG_SLOTS 32       // Ring slots (power of two)
+#define CONSOLE_LOG_LINE_SIZE 240  // Longest line kept; longer lines are truncated
+#define CONSOLE_LOG_TASK_STACK 3072
+#define CONSOLE_LOG_TASK_PRIORITY 1
+#define CONSOLE_LOG_TASK_CORE 0
+
+// Called by the drain task for every line (not NUL-terminated)
+typedef void (*ConsoleLogTap)(uint8_t level, const char *text, size_t length);
+
+struct ConsoleLogStats
+{
+    uint32_t written;   // Lines accepted into the ring
+    uint32_t dropped;   // Lines lost because the ring was full
+    uint32_t truncated; // Lines cut to CONSOLE_LOG_LINE_SIZE
+    uint32_t highWater; // Most slots in use at once
+};
+
+class ConsoleLog
+{
+public:
+    static ConsoleLog &getInstance();
+
+    // Start the drain task; lines queued earlier are written once it runs
+    void begin();
+
+    // Queue one line (without newline); returns false if it was dropped.
+    // Unleveled lines (banners) are queued as LOG_LEVEL_INFO.
+    bool write(const char *text, size_t length);
+    bool println(const char *text) { return write(text, strlen(text)); }
+    bool printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    bool logf(uint8_t level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+    // Runtime levels of the two outputs. getLevel() is the most verbose of
+    // them: leveled lines above it are discarded before formatting.
+    void setSerialLevel(uint8_t level);
+    uint8_t getSerialLevel() const { return serialLevel.load(std::memory_order_relaxed); }
+    void setStreamLevel(uint8_t level);
+    uint8_t getLevel() const { return runtimeLevel.load(std::memory_order_relaxed); }
+
+    void setTap(ConsoleLogTap callback) { tap.store(callback, std::memory_order_release); }
+
+    ConsoleLogStats getStats() const;
+
+private:
+    ConsoleLog();
+    ~ConsoleLog() = default;
+
+    // Prevent copying
+    ConsoleLog(const ConsoleLog &) = delete;
+    ConsoleLog &operator=(const ConsoleLog &) = delete;
+
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence; // Position the slot is ready for
+        uint16_t length;
+        uint8_t level;
+        char text[CONSOLE_LOG_LINE_SIZE];
+    };
+
+    Slot *claim(uint32_t &position);
+    void publish(Slot *slot, uint32_t position);
+    bool vlogf(uint8_t level, const char *format, va_list args);
+    void updateRuntimeLevel();
+    bool drainOne();
+    static void drainTaskFunction(void *parameter);
+
+    Slot slots[CONSOLE_LOG_SLOTS];
+    std::atomic<uint32_t> enqueuePos;
+    std::atomic<uint32_t> dequeuePos;
+    TaskHandle_t drainTaskHandle;
+    std::atomic<uint8_t> runtimeLevel;
+    std::atomic<uint8_t> serialLevel;
+    std::atomic<uint8_t> streamLevel;
+    std::atomic<ConsoleLogTap> tap;
+
+    std::atomic<uint32_t> written;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> truncated;
+    std::atomic<uint32_t> highWater;
+};
+
+extern ConsoleLog &consoleLog;
+
+// "error", "warn", "info", "debug", "verbose" (and "none")
+const char *consoleLogLevelName(uint8_t level);
+bool consoleLogLevelFromName(const char *name, uint8_t &level);
+
+#endif // CONSOLE_LOG_H
@@ -0,0 +1,80 @@
+#ifndef CONSOLE_STREAM_H
+#define CONSOLE_STREAM_H
+
+#include <Arduino.h>
+#include <mutex>
+#include "console_log.h"
+
+// Web console
+// The console drain task copies every line into a small history ring, and
+// the main loop sends it to WebSocket clients that subscribed with
+// {"CONSOLE": "<level>"}. Each subscriber has its own cursor, level filter and
+// token bucket. A client that falls behind skips ahead to the oldest line
+// still held and is told how many it missed, so a slow browser loses old
+// lines instead of holding up anything that logs.
+
+#define CONSOLE_STREAM_HISTORY 32    // Lines kept for subscribers (power of two)
+#define CONSOLE_STREAM_MAX_CLIENTS 4
+#define CONSOLE_STREAM_RATE 20       // Lines per second per client
+#define CONSOLE_STREAM_BURST 40      // Lines a client may receive at once after a pause
+#define CONSOLE_STREAM_BATCH 8       // Most lines per WebSocket frame
+
+class ConsoleStream
+{
+public:
+    static ConsoleStream &getInstance();
+
+    // Attach to the console drain task
+    void begin();
+
+    // Start or change a client's subscription; LOG_LEVEL_NONE ends it.
+    // Returns false when every subscriber slot is taken.
+    bool subscribe(uint32_t client, uint8_t level);
+    void unsubscribe(uint32_t client);
+
+    // Send pending lines to subscribers (main loop)
+    void update();
+
+private:
+    ConsoleStream();
+    ~ConsoleStream() = default;
+
+    // Prevent copying
+    ConsoleStream(const ConsoleStream &) = delete;
+    ConsoleStream &operator=(const ConsoleStream &) = delete;
+
+    struct Line
+    {
+        uint32_t seq;
+        uint8_t level;
+        char text[CONSOLE_LOG_LINE_SIZE + 1];
+    };
+
+    struct Subscriber
+    {
+        bool active;
+        uint32_t client;
+        uint8_t level;
+        uint32_t nextSeq;  // Next line this client has not seen
+        uint32_t skipped;  // Lines lost since the last frame
+        uint16_t tokens;
+        unsigned long lastRefill;
+    };
+
+    static void onConsoleLine(uint8_t level, const char *text, size_t length);
+    void append(uint8_t level, const char *text, size_t length);
+    void send(Subscriber &subscriber);
+    void updateStreamLevel();
+
+    Line history[CONSOLE_STREAM_HISTORY];
+    uint32_t head; // Sequence number of the next line
+    std::mutex historyMutex;
+
+    Subscriber subscribers[CONSOLE_STREAM_MAX_CLIENTS];
+    uint8_t activeCount;
+    Line outbox[CONSOLE_STREAM_BATCH]; // Lines of the frame being built
+};
+
+extern ConsoleStream &consoleStream;
+
+#endif // CONSOLE_STREAM_H
@@ -0,0 +1,10 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+// Standard (IEEE 802.3) CRC32. Pass 0 to start, or a previous result to
+// continue over more data. Uses the ESP32 ROM routine when it is available.
+uint32_t crc32Update(uint32_t crc, const void *data, size_t length);
+
+#endif // CRC32_H
@@ -0,0 +1,134 @@
+#ifndef CREDENTIAL_INDEX_H
+#define CREDENTIAL_INDEX_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <mutex>
+#include "config_manager.h"
+
+// Credential de-duplication index
+// Every distinct credential (bit length, facility code, card number / UID)
+// gets one slot in a fixed open-addressing table in RAM holding its first and
+// last sighting and a swipe count. Changes are appended to a small journal
+// (through the storage task) so the index survives a reboot; the journal is
+// compacted into a snapshot once it holds mostly superseded records.
+//
+// Sightings before the clock is set are stored as seconds since boot (see
+// clock_manager.h) and resolved to wall time when it syncs. Boot-relative
+// times still in the journal at the next boot belong to a boot that no
+// longer exists and are loaded as unknown (0).
+
+#define CREDENTIAL_INDEX_CAPACITY 512    // Table slots (power of two)
+#define CREDENTIAL_INDEX_MAX_ENTRIES 384 // Keep the load factor at 75%
+#define CREDENTIAL_ID_LENGTH 24          // Card number or UID text
+#define CREDENTIAL_HEX_LENGTH 20
+
+#define CREDENTIAL_JOURNAL_FILE "/credentials.jrn"
+#define CREDENTIAL_JOURNAL_TMP_FILE "/credentials.tmp"
+#define CREDENTIAL_DEFAULT_RENOTIFY_SECONDS 3600
+
+struct CredentialEntry
+{
+    uint32_t hash; // 0 marks an empty slot
+    uint8_t bits;
+    uint8_t net2;
+    uint16_t reserved;
+    uint32_t facilityCode;
+    uint32_t firstSeen;
+    uint32_t lastSeen;
+    uint32_t lastNotified;
+    uint32_t count;
+    char id[CREDENTIAL_ID_LENGTH];
+    char hex[CREDENTIAL_HEX_LENGTH];
+};
+
+// Outcome of recording one read
+struct CredentialSighting
+{
+    bool firstSeen; // Credential was not in the index before
+    bool notify;    // Outside the re-notify window - send notifications
+    bool log;       // Append the full record to the card log
+    uint32_t count;
+};
+
+// Read position used to stream the index as JSON
+struct CredentialCursor
+{
+    uint16_t slot = 0;
+    uint16_t emitted = 0;
+    bool started = false;
+    bool finished = false;
+    uint16_t pendingLen = 0;
+    uint16_t pendingPos = 0;
+    char pending[192];
+};
+
+class CredentialIndex
+{
+public:
+    static CredentialIndex &getInstance();
+
+    // Load options and replay the journal
+    void begin();
+
+    // Record one read of a credential
+    CredentialSighting record(uint8_t bits, uint32_t facilityCode, const char *id, const char *hex, bool net2);
+
+    // Forget every credential
+    void clear();
+
+    // Add the boot-to-wall offset to this boot's sighting times and rewrite
+    // the journal (storage task)
+    void resolveBootTimes(uint32_t wallOffset);
+
+    // Stream the index as a JSON array; returns 0 when done
+    size_t readJson(CredentialCursor &cursor, uint8_t *buffer, size_t maxLen);
+
+    // Options
+    void setOptions(uint32_t renotifySeconds, bool logRepeats);
+    uint32_t getRenotifySeconds() const { return renotifySeconds; }
+    bool getLogRepeats() const { return logRepeats; }
+
+    uint16_t getCount() const { return count; }
+
+    // Bumped on every change; used as the HTTP validator for /api/credentials
+    uint32_t getVersion() const { return version; }
+
+private:
+    CredentialIndex();
+    ~CredentialIndex() = default;
+
+    // Prevent copying
+    CredentialIndex(const CredentialIndex &) = delete;
+    CredentialIndex &operator=(const CredentialIndex &) = delete;
+
+    struct JournalRecord
+    {
+        CredentialEntry entry;
+        uint32_t crc;
+    };
+
+    static bool resolveTime(uint32_t &timestamp, uint32_t wallOffset);
+    static uint32_t hashKey(uint8_t bits, uint32_t facilityCode, const char *id);
+    CredentialEntry *find(uint32_t hash, uint8_t bits, uint32_t facilityCode, const char *id, bool insert);
+    void loadOptions();
+    static void onConfigChanged(uint32_t sections, const DeviceConfig &config);
+    void loadJournal();
+    void appendJournal(const CredentialEntry &entry);
+    void compactJournal();
+    static void compactJob(const uint8_t *data, size_t length);
+
+    CredentialEntry table[CREDENTIAL_INDEX_CAPACITY];
+    uint16_t count;
+    volatile uint32_t version;
+    uint32_t journalRecords;
+    bool compactPending;
+    uint32_t renotifySeconds;
+    bool logRepeats;
+
+    mutable std::mutex indexMutex;
+};
+
+extern CredentialIndex &credentialIndex;
+
+#endif
@@ -2,8 +2,7 @@
 #define DEBUG_MANAGER_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
-#include <LittleFS.h>
+#include "console_log.h"
 
 // Forward declaration of global debug state
 extern bool DEBUG_ENABLED;
@@ -24,19 +23,22 @@ public:
         DEBUG_ENABLED = state;
         if (!state)
         {
-            Serial.end();
+            consoleLog.setSerialLevel(LOG_LEVEL_NONE); // Serial stays open for the drain task
         }
     }
 
-    // Web interface methods
+    // Web interface methods; changes apply immediately
     bool updateDebugState(bool newState);
     bool getCurrentDebugState() const;
+    bool updateLogLevel(uint8_t level);
+    uint8_t getLogLevel() const { return logLevel; }
 
 private:
-    static const char *DEBUG_CONFIG_FILE;
     bool debugEnabled;
-    bool readDebugConfig();
-    bool writeDebugConfig(bool state);
+    uint8_t logLevel; // Serial console level while debug output is enabled
+    void readDebugConfig();
+    void writeDebugConfig();
+    void applyConsoleLevel();
 };
 
 extern DebugManager debugManager; // Global instance
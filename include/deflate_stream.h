@@ -0,0 +1,76 @@
+#ifndef DEFLATE_STREAM_H
+#define DEFLATE_STREAM_H
+
+#include <Arduino.h>
+
+// Streaming gzip compressor
+// A small-window LZ77 matcher feeding fixed-Huffman deflate blocks (RFC 1951)
+// inside a gzip wrapper (RFC 1952). All state lives in this object, so the
+// memory an export needs is fixed no matter how much data passes through.
+// Text logs with repeated keys compress well without dynamic Huffman tables.
+
+#ifndef DEFLATE_WINDOW_SIZE
+#define DEFLATE_WINDOW_SIZE 2048  // History searched for matches (power of two)
+#endif
+#ifndef DEFLATE_HASH_SIZE
+#define DEFLATE_HASH_SIZE 1024    // Hash heads (power of two)
+#endif
+#ifndef DEFLATE_MAX_CHAIN
+#define DEFLATE_MAX_CHAIN 16      // Candidates tried per position
+#endif
+#define DEFLATE_OUTPUT_SIZE 512
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+
+class DeflateStream
+{
+public:
+    DeflateStream();
+
+    // Start a new gzip member
+    void begin();
+
+    // Take up to length bytes of input and compress while there is room for
+    // the output. Pass finish once the last input byte has been offered.
+    // Returns the number of input bytes consumed.
+    size_t process(const uint8_t *data, size_t length, bool finish);
+
+    // Move compressed bytes out; returns 0 when nothing is ready
+    size_t read(uint8_t *buffer, size_t maxLen);
+
+    bool isDone() const { return done && outPos == outLen; }
+    uint32_t getTotalIn() const { return totalIn; }
+    uint32_t getTotalOut() const { return totalOut; }
+
+private:
+    void putBits(uint32_t value, uint8_t count);
+    void putCode(uint16_t code, uint8_t length);
+    void putLiteral(uint16_t symbol);
+    void putMatch(uint16_t length, uint16_t distance);
+    void putByte(uint8_t value);
+    void alignToByte();
+    void slide();
+    uint16_t hashAt(uint16_t position) const;
+    void insert(uint16_t position);
+    uint16_t findMatch(uint16_t &distance) const;
+    void finishStream();
+
+    uint8_t window[2 * DEFLATE_WINDOW_SIZE];
+    uint16_t head[DEFLATE_HASH_SIZE];
+    uint16_t prev[DEFLATE_WINDOW_SIZE]; // Hash chains, indexed by position modulo the window
+    uint16_t pos; // Next byte to encode
+    uint16_t end; // Bytes held in the window buffer
+
+    uint8_t out[DEFLATE_OUTPUT_SIZE];
+    uint16_t outLen;
+    uint16_t outPos;
+    uint32_t bitBuffer;
+    uint8_t bitCount;
+
+    uint32_t crc;
+    uint32_t totalIn;
+    uint32_t totalOut;
+    bool done;
+};
+
+#endif // DEFLATE_STREAM_H
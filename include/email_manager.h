@@ -6,10 +6,6 @@
 #include <queue>
 #include <mutex>
 #include <base64.h>
-#include <ArduinoJson.h>
-
-// File paths
-#define NOTIFICATION_CONFIG_FILE "/notifications.json"
 
 class EmailManager
 {
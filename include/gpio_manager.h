@@ -2,11 +2,9 @@
 #define GPIO_MANAGER_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
-#include <FS.h>
-#include <LittleFS.h>
 #include <driver/gpio.h>
 #include "card_processor.h"
+#include "config_manager.h"
 
 // Forward declaration of CardProcessor
 class CardProcessor;
@@ -34,12 +32,10 @@ private:
     bool pin35Pulsing;
     bool pin36Pulsing;
 
-    const char *CONFIG_FILE = "/www/gpio_settings.json";
-
     GPIOManager();
-    bool loadConfig();
-    bool saveConfig();
     void initializeGPIO();
+    void applyConfig(const GpioConfig &config);
+    static void onConfigChanged(uint32_t sections, const DeviceConfig &config);
 
 public:
     static GPIOManager &getInstance();
@@ -21,7 +21,7 @@ public:
     void turnOff();
     void toggle();
 
-    // Startup sequence - preserve exact timing and pattern
+    // Startup sequence - same pattern and timing, played by update()
     void runStartupSequence();
 
     // Reset button feedback sequences
@@ -78,6 +78,11 @@ private:
     // Sequence state tracking
     int blinkCount = 0;
     unsigned long lastBlinkTime = 0;
+
+    // Startup pattern position; -1 when not playing
+    int startupStep = -1;
+    unsigned long startupStepTime = 0;
+    void updateStartupSequence();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include "console_log.h"
+
+// Leveled logging
+// LOG_E / LOG_W / LOG_I / LOG_D / LOG_V format one line into the console
+// ring. Each source file sets its threshold after its includes:
+//
+//     #define LOG_MODULE_LEVEL LOG_LEVEL_READER
+//
+// A line above the module threshold is a constant-false branch: the call,
+// its arguments and its format string are dropped by the compiler. Lines
+// that are compiled in are also checked against consoleLog.getLevel(), the
+// most verbose of the serial and web console levels, set at run time.
+
+// Build-wide threshold; the release environment lowers it
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_VERBOSE
+#endif
+
+// Per-module thresholds, e.g. -DLOG_LEVEL_WEBSOCKET=LOG_LEVEL_DEBUG
+#ifndef LOG_LEVEL_MAIN
+#define LOG_LEVEL_MAIN LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_LOGGER
+#define LOG_LEVEL_LOGGER LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_READER
+#define LOG_LEVEL_READER LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_RESET
+#define LOG_LEVEL_RESET LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_EMAIL
+#define LOG_LEVEL_EMAIL LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_WEBSOCKET
+#define LOG_LEVEL_WEBSOCKET LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_WIFI
+#define LOG_LEVEL_WIFI LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CARDLOG
+#define LOG_LEVEL_CARDLOG LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CREDENTIALS
+#define LOG_LEVEL_CREDENTIALS LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_STORAGE
+#define LOG_LEVEL_STORAGE LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CLOCK
+#define LOG_LEVEL_CLOCK LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_STATS
+#define LOG_LEVEL_STATS LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CONFIG
+#define LOG_LEVEL_CONFIG LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_BOOT
+#define LOG_LEVEL_BOOT LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_COMMAND
+#define LOG_LEVEL_COMMAND LOG_LEVEL
+#endif
+
+#define LOG_AT(level, format, ...)                                                   \
+    do                                                                               \
+    {                                                                                \
+        if ((level) <= (LOG_MODULE_LEVEL) && (level) <= ::consoleLog.getLevel())     \
+        {                                                                            \
+            ::consoleLog.logf(level, format, ##__VA_ARGS__);                         \
+        }                                                                            \
+    } while (0)
+
+#define LOG_E(format, ...) LOG_AT(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#define LOG_W(format, ...) LOG_AT(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define LOG_I(format, ...) LOG_AT(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define LOG_D(format, ...) LOG_AT(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#define LOG_V(format, ...) LOG_AT(LOG_LEVEL_VERBOSE, format, ##__VA_ARGS__)
+
+// Section divider used between console messages
+#define LOG_SEPARATOR() LOG_I("======================================================================")
+
+#endif // LOG_H
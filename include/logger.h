@@ -8,9 +8,6 @@
 // File paths
 #define FORMAT_LITTLEFS_IF_FAILED true
 #define CARDS_CSV_FILE "/www/cards.csv"
-#define LOGGER_RESET_CARD_FILE "/www/reset_card.json"
-#define LOGGER_DEBUG_CONFIG_FILE "/www/debug_config.json"
-#define NOTIFICATION_CONFIG_FILE "/notifications.json"
 
 class Logger
 {
@@ -24,7 +21,7 @@ public:
     void writeKeypadLog();
     void logStartupBanner(const char *device, const char *version, const char *builddate, const char *hardware);
     void logWiFiInfo(const char *ssid, IPAddress ip, IPAddress gateway, const char *mac, int rssi);
-    void logResetCardInfo(const char *resetCardFile);
+    void logResetCardInfo();
     void logTimeInfo(time_t now);
     void logEmailStatus(bool enabled, const char *recipient);
     void logMDNSStatus(const char *host);
@@ -43,6 +40,7 @@ private:
     void logCardDataPIN();
     void logCardDataKeypad();
     void logCardDataError();
+    void appendCardRecord(const char *record, int length);
 
     // Constructor and destructor
     Logger();
@@ -2,9 +2,8 @@
 #define READER_MANAGER_H
 
 #include <Arduino.h>
-#include <LittleFS.h>
-#include <ArduinoJson.h>
 #include "version_config.h"
+#include "config_manager.h"
 
 // Manages switching between HID and Paxton/Net2 reader modes
 
@@ -23,16 +22,10 @@ public:
     // Initialize reader manager
     void begin();
 
-    // Load reader configuration from file
+    // Take the reader type from the device configuration
     void loadConfig();
 
-    // Save reader configuration to file
-    void saveConfig(ReaderType type);
-
-    // Set default configuration
-    void setDefaultConfig();
-
-    // Switch between HID and Paxton modes
+    // Switch between HID and Paxton modes and save the choice
     void switchMode(ReaderType newType);
 
     // Attach appropriate interrupts based on current reader type
@@ -55,6 +48,8 @@ private:
     ReaderManager(const ReaderManager &) = delete;
     ReaderManager &operator=(const ReaderManager &) = delete;
 
+    static void onConfigChanged(uint32_t sections, const DeviceConfig &config);
+
     ReaderType currentReaderType;
     bool interruptsInitialized;
 };
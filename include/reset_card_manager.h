@@ -2,10 +2,18 @@
 #define RESET_CARD_MANAGER_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
-#include <LittleFS.h>
 #include "card_processor.h"
+#include "config_manager.h"
 
+#define RESET_CARD_DEFAULT_BL 35
+#define RESET_CARD_DEFAULT_FC 111
+#define RESET_CARD_DEFAULT_CN 4444
+#define RESET_CARD_DEFAULT_PAXTON_HEX "0000001337"
+
+// Reset card identity
+// Kept in RAM as a copy of the reset card section of the device
+// configuration, so checking a read is a compare. Commits to that section
+// refresh the copy.
 class ResetCardManager
 {
 public:
@@ -14,13 +22,15 @@ public:
     void checkResetCard(CardProcessor &cardProcessor);
     void setDefaultResetCard();
     void resetStoredWiFi();
-    bool readResetCardConfig(int &resetBL, int &resetFC, int &resetCN, String &paxtonHex);
+
+    const ResetCardConfig &getKey() const { return key; }
 
 private:
-    bool readResetCardConfig(int &resetBL, int &resetFC, int &resetCN);
-    bool readPaxtonResetCard(String &paxtonHex);
+    static void onConfigChanged(uint32_t sections, const DeviceConfig &config);
+
+    ResetCardConfig key;
 };
 
 extern ResetCardManager resetCardManager; // Global instance declaration
 
-#endif
\ No newline at end of file
+#endif
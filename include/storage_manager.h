@@ -0,0 +1,114 @@
+#ifndef STORAGE_MANAGER_H
+#define STORAGE_MANAGER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// Storage writer
+// All flash writes are handed to a dedicated task pinned to core 0 through a
+// statically allocated queue of fixed-size requests, so the loop task that
+// completes Wiegand frames never waits on a LittleFS write or erase.
+// Requests are executed strictly in the order they were queued.
+
+#define STORAGE_QUEUE_LENGTH 32
+#define STORAGE_PAYLOAD_SIZE 384
+#define STORAGE_PATH_LENGTH 32
+#define STORAGE_TASK_STACK 6144
+#define STORAGE_TASK_PRIORITY 1
+#define STORAGE_TASK_CORE 0
+#define STORAGE_IDLE_TICKS pdMS_TO_TICKS(50) // Housekeeping runs when idle this long
+
+// Work executed on the storage task; data points at a copy of the queued payload
+typedef void (*StorageJob)(const uint8_t *data, size_t length);
+
+enum StorageRequestType : uint8_t
+{
+    STORAGE_CARD_RECORD,
+    STORAGE_APPEND_FILE,
+    STORAGE_REMOVE_FILE,
+    STORAGE_RUN_JOB
+};
+
+struct StorageRequest
+{
+    StorageRequestType type;
+    uint16_t length;
+    uint32_t seq;
+    uint32_t timestamp; // Capture time of a card record
+    int64_t queuedAt;
+    StorageJob job;
+    char path[STORAGE_PATH_LENGTH];
+    uint8_t payload[STORAGE_PAYLOAD_SIZE];
+};
+
+struct StorageStats
+{
+    uint32_t depth;
+    uint32_t highWater;
+    uint32_t capacity;
+    uint32_t processed;
+    uint32_t dropped;
+    uint32_t lastLatencyUs; // Queue wait plus write time of the last request
+    uint32_t maxLatencyUs;
+    uint32_t avgLatencyUs;
+};
+
+class StorageManager
+{
+public:
+    static StorageManager &getInstance();
+
+    // Create the queue and start the writer task
+    void begin();
+
+    // Queue a card record; returns its sequence number, or 0 if it was dropped
+    uint32_t appendCardRecord(const char *record, size_t length, uint32_t timestamp);
+
+    // Generic file operations; an append larger than STORAGE_PAYLOAD_SIZE
+    // bytes is refused (false), never split or cut short
+    bool appendFile(const char *path, const void *data, size_t length);
+    bool removeFile(const char *path);
+
+    // Run a job on the storage task after everything queued before it
+    bool run(StorageJob job, const void *data = nullptr, size_t length = 0);
+
+    StorageStats getStats() const;
+
+    // True when nothing is queued or being written, e.g. before a restart
+    bool isIdle() const { return inFlight == 0; }
+
+private:
+    StorageManager();
+    ~StorageManager() = default;
+
+    // Prevent copying
+    StorageManager(const StorageManager &) = delete;
+    StorageManager &operator=(const StorageManager &) = delete;
+
+    bool enqueue(StorageRequest &request);
+    void process(StorageRequest &request);
+    static void storageTaskFunction(void *parameter);
+
+    QueueHandle_t queue;
+    TaskHandle_t storageTaskHandle;
+    StaticQueue_t queueControl;
+    uint8_t queueStorage[STORAGE_QUEUE_LENGTH * sizeof(StorageRequest)];
+    StorageRequest current;
+
+    // Updated from every task that queues work
+    std::atomic<uint32_t> inFlight; // Accepted and not yet finished, including the one running
+    std::atomic<uint32_t> highWater;
+    std::atomic<uint32_t> processed;
+    std::atomic<uint32_t> dropped;
+    volatile uint32_t lastLatencyUs;
+    volatile uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+};
+
+extern StorageManager &storageManager;
+
+#endif
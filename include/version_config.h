@@ -39,9 +39,6 @@ extern const int C_PIN_LED; // GPIO for the LED (OUTPUT)
 // File paths
 #define FORMAT_LITTLEFS_IF_FAILED true
 #define CARDS_CSV_FILE "/www/cards.csv"
-#define RESET_CARD_FILE "/www/reset_card.json"
-#define NOTIFICATION_CONFIG_FILE "/notifications.json"
-#define READER_CONFIG_FILE "/www/reader_config.json"
 
 // WiFiManager Configurations
 extern const char *defaultPASS;
@@ -0,0 +1,33 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// Web UI embedded in the firmware
+// scripts/build_web_assets.py turns data/www into src/web_assets_data.cpp
+// on every build: one const array per asset, already minified and gzipped,
+// plus the table below. The arrays stay in flash and responses are sent
+// straight from the memory-mapped image, so serving the UI never touches
+// LittleFS or waits on the storage task.
+
+#define WEB_LEGACY_DIR "/www" // Where earlier releases kept the UI on LittleFS
+
+struct WebAsset
+{
+    const char *path;        // Request path, e.g. "/css/style.10a41a92.css"
+    const char *contentType;
+    const uint8_t *data;
+    uint32_t length;
+    const char *etag;        // Quoted, computed at build time
+    bool gzip;               // data is gzip; send with Content-Encoding: gzip
+    bool immutable;          // Name carries a content hash; cache forever
+};
+
+extern const WebAsset WEB_ASSETS[];
+extern const size_t WEB_ASSET_COUNT;
+
+// Remove the UI files an earlier filesystem image left on LittleFS; runs
+// on the storage task after the legacy migrations have read their files
+void removeLegacyWebFiles();
+
+#endif // WEB_ASSETS_H
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <Arduino.h>
-#include <WebSocketsServer.h>
+#include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "reset_card_manager.h"
 #include "email_manager.h"
 #include "wifi_setup_manager.h"
@@ -12,7 +14,52 @@
 #include "version_config.h"
 #include "notification_manager.h"
 
-// Declare websockets as extern since it's defined in main.cpp
-extern WebSocketsServer websockets;
+// WebSocket endpoint
+// The endpoint shares the async web server on port 80. Connections and
+// frames arrive on the async TCP task, which copies each whole message into
+// a statically allocated queue and returns; the main loop takes them off
+// the queue, so socket servicing never runs in the loop that completes
+// Wiegand frames. The loop only parses a message and answers subscriptions;
+// anything that changes settings or stored data becomes a typed command
+// for the command executor.
 
-void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length);
\ No newline at end of file
+#define WS_PATH "/ws"
+#define WS_MAX_CLIENTS 8      // Oldest connections are closed beyond this
+#define WS_QUEUE_LENGTH 8
+#define WS_MESSAGE_SIZE 512   // Largest command accepted, in one frame
+#define WS_CLEANUP_INTERVAL_MS 1000
+
+enum WebSocketEventType : uint8_t
+{
+    WS_EVENT_CONNECT,
+    WS_EVENT_DISCONNECT,
+    WS_EVENT_TEXT,
+    WS_EVENT_BINARY
+};
+
+struct WebSocketEvent
+{
+    WebSocketEventType type;
+    uint16_t length;
+    uint32_t client;
+    uint8_t payload[WS_MESSAGE_SIZE];
+};
+
+struct WebSocketQueueStats
+{
+    uint32_t clients;
+    uint32_t queued;
+    uint32_t dropped;  // Messages lost to a full queue
+    uint32_t rejected; // Fragmented or larger than WS_MESSAGE_SIZE
+};
+
+// Defined in main.cpp
+extern AsyncWebSocket websockets;
+
+// Create the queue and attach the endpoint to the server (network task)
+void beginWebSocket(AsyncWebServer &server);
+
+// Handle queued connections and messages (main loop)
+void processWebSocketEvents();
+
+WebSocketQueueStats getWebSocketStats();
@@ -0,0 +1,89 @@
+#ifndef WEBSOCKET_PROTOCOL_H
+#define WEBSOCKET_PROTOCOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <mutex>
+
+// WebSocket message protocol
+// Messages are maps. Clients send commands as maps of command keys
+// ({"CARDS": true}, {"RBL": 26, "RFC": 1, "RCN": 2}, ...); the device
+// answers and pushes maps tagged with "source" ("live", "hello",
+// "card_log", ...). Version 1 is that schema.
+//
+// Every client starts in JSON text frames. A client that sends
+// {"HELLO": {"v": 1, "encodings": ["msgpack", "json"]}} gets
+// {"source": "hello", "v": 1, "encoding": "<chosen>"} back in JSON, and
+// from then on the device sends that client MessagePack binary frames.
+// Commands are accepted in either encoding at any time. Frames are encoded
+// into and decoded from fixed buffers; nothing is built in a heap String.
+
+#define WS_PROTOCOL_VERSION 1
+#define WS_PROTOCOL_MAX_CLIENTS 8 // Clients beyond this many stay on JSON
+#define WS_FRAME_SIZE 4096        // Largest encoded frame
+
+enum WsEncoding : uint8_t
+{
+    WS_ENCODING_JSON,
+    WS_ENCODING_MSGPACK,
+};
+
+struct WsProtocolStats
+{
+    uint32_t framesJson;
+    uint32_t framesMsgPack;
+    uint32_t bytesJson;
+    uint32_t bytesMsgPack;
+    uint32_t oversized; // Frames that did not fit WS_FRAME_SIZE
+    uint32_t busy;      // Frames not sent because the client's queue was full
+};
+
+class WebSocketProtocol
+{
+public:
+    static WebSocketProtocol &getInstance();
+
+    // New connection or disconnect: back to JSON
+    void reset(uint32_t client);
+
+    // Parse a text (JSON) or binary (MessagePack) message into doc
+    bool decode(bool binary, const uint8_t *payload, size_t length, JsonDocument &doc);
+
+    // Answer a HELLO; returns false if doc is not one
+    bool negotiate(uint32_t client, JsonDocument &doc);
+
+    // Encode doc for this client and queue it; false if the client is gone
+    // or its send queue is full
+    bool send(uint32_t client, const JsonDocument &doc);
+
+    WsEncoding getEncoding(uint32_t client);
+
+    // False once the server has dropped the client
+    bool isConnected(uint32_t client);
+
+    // Forget encodings of clients that are gone (main loop)
+    void prune();
+    WsProtocolStats getStats();
+
+private:
+    WebSocketProtocol();
+    ~WebSocketProtocol() = default;
+
+    // Prevent copying
+    WebSocketProtocol(const WebSocketProtocol &) = delete;
+    WebSocketProtocol &operator=(const WebSocketProtocol &) = delete;
+
+    void setEncoding(uint32_t client, WsEncoding encoding);
+
+    // Clients that negotiated MessagePack; 0 marks a free slot
+    uint32_t binaryClients[WS_PROTOCOL_MAX_CLIENTS];
+
+    std::mutex frameMutex; // Guards binaryClients, frame and stats
+    uint8_t frame[WS_FRAME_SIZE];
+    WsProtocolStats stats;
+};
+
+extern WebSocketProtocol &webSocketProtocol;
+
+#endif // WEBSOCKET_PROTOCOL_H
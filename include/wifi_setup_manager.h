@@ -6,9 +6,6 @@
 #include <ESPmDNS.h>
 #include "logger.h"
 
-// Default timestamp for time validation (1970-01-01 00:00:00)
-#define ESP_TIME_DEFAULT_TS 0
-
 // Custom CSS for WiFi manager portal
 extern const char *WIFI_MANAGER_CUSTOM_CSS;
 
@@ -19,8 +16,8 @@ public:
     void begin(const char *device, const char *defaultPASS, const char *prefixSSID);
     bool isConnected() const;
     void resetStoredWiFi();
-    void resetSettings();
-    bool setupTime();
+    void resetSettings();   // Forget the network, then restart once settings and records are saved
+    void clearStoredWiFi(); // Forget the network without restarting
     const char *getSSID() const;
     IPAddress getLocalIP() const;
     IPAddress getGatewayIP() const;
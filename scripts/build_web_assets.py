@@ -0,0 +1,311 @@
+"""Build the web UI into the firmware image.
+
+PlatformIO runs this before every build (see extra_scripts in
+platformio.ini). It turns data/www into src/web_assets_data.cpp, a table
+of const byte arrays that the linker places in flash and the server sends
+straight from the memory-mapped image, ready for the browser:
+
+  * HTML, CSS and JS are minified (whitespace and comments only; template
+    literals and <pre> blocks are left alone)
+  * CSS, JS and images get a content hash in their name and every
+    reference to them is rewritten, so the server can mark them immutable
+  * text assets and icons are stored gzipped and sent with
+    Content-Encoding: gzip
+  * every asset gets an ETag computed here, so the device never hashes
+
+For `buildfs`/`uploadfs` it also points the filesystem image at a copy of
+data/ without the web UI, leaving LittleFS to captured data.
+
+Run it directly to regenerate the table and print transfer sizes per page:
+
+  python scripts/build_web_assets.py [--link-kbps 256]
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import posixpath
+import re
+import shutil
+
+# Hashed and cached forever; HTML keeps its name and is revalidated
+FINGERPRINT_EXTS = {".css", ".js", ".png", ".ico"}
+GZIP_EXTS = {".html", ".css", ".js", ".ico"}
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+}
+
+# Not part of the UI: files that stay on LittleFS (read once by a
+# migration), and files nothing references
+FILESYSTEM_FILES = {"cards.csv"}
+EXCLUDE = {"img/favicon_old.ico"}
+
+GENERATED_SOURCE = os.path.join("src", "web_assets_data.cpp")
+
+HASH_LENGTH = 8
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Line based, so automatic semicolon insertion is unaffected
+    out = []
+    in_template = False
+    for line in text.splitlines():
+        if in_template:
+            out.append(line)
+        else:
+            stripped = line.strip()
+            if stripped and not stripped.startswith("//"):
+                out.append(stripped)
+        if len(re.findall(r"(?<!\\)`", line)) % 2 == 1:
+            in_template = not in_template
+    return "\n".join(out) + "\n"
+
+
+def minify_html(text):
+    out = []
+    in_pre = False
+    for line in text.splitlines():
+        if in_pre:
+            out.append(line)
+        else:
+            stripped = line.strip()
+            if stripped:
+                out.append(stripped)
+        opened = len(re.findall(r"<pre\b", line))
+        closed = len(re.findall(r"</pre>", line))
+        if opened != closed:
+            in_pre = opened > closed
+    return "\n".join(out) + "\n"
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html}
+
+
+def fingerprinted_name(path, data):
+    digest = hashlib.sha256(data).hexdigest()[:HASH_LENGTH]
+    stem, ext = posixpath.splitext(path)
+    return "%s.%s%s" % (stem, digest, ext)
+
+
+def rewrite_references(text, path, renames):
+    # CSS resolves URLs against its own directory; HTML and the scripts it
+    # loads resolve them against the page, which is always at the root
+    base = posixpath.dirname(path) if path.endswith(".css") else ""
+    for old, new in renames.items():
+        ref = posixpath.relpath(old, base or ".")
+        new_ref = posixpath.relpath(new, base or ".")
+        pattern = r"(?<![\w.\-/])((?:\./|/)?)" + re.escape(ref) + r"(?![\w.\-])"
+        text = re.sub(pattern, lambda m: m.group(1) + new_ref, text)
+    return text
+
+
+def build_order(src_dir, files):
+    """Files ordered so each is built after every asset it references."""
+    pending = sorted(files)
+    ordered = []
+    while pending:
+        for path in pending:
+            text = ""
+            if posixpath.splitext(path)[1] in MINIFIERS:
+                with open(os.path.join(src_dir, path), encoding="utf-8") as f:
+                    text = f.read()
+            # Conservative: any mention of a pending asset's name counts
+            if not any(other != path and posixpath.splitext(other)[1] in FINGERPRINT_EXTS
+                       and posixpath.basename(other) in text for other in pending):
+                break
+        else:
+            raise SystemExit("Circular references between web assets: %s" % ", ".join(pending))
+        pending.remove(path)
+        ordered.append(path)
+    return ordered
+
+
+class Asset:
+    def __init__(self, path, source, raw_size, data, gzipped):
+        self.path = path  # As requested, e.g. "/css/style.4a1bc7da.css"
+        self.source = source
+        self.raw_size = raw_size
+        self.data = data
+        self.gzipped = gzipped
+        self.immutable = posixpath.splitext(source)[1] in FINGERPRINT_EXTS
+        self.content_type = CONTENT_TYPES[posixpath.splitext(source)[1]]
+        self.etag = '"%s"' % hashlib.sha256(data).hexdigest()[:16]
+
+    def text(self):
+        return (gzip.decompress(self.data) if self.gzipped else self.data).decode("utf-8")
+
+
+def build_www(src_dir):
+    """The browser-ready UI from src_dir, keyed by request path."""
+    files = []
+    for root, _, names in os.walk(src_dir):
+        for name in names:
+            full = os.path.join(root, name)
+            path = posixpath.normpath(os.path.relpath(full, src_dir).replace(os.sep, "/"))
+            if path not in EXCLUDE and path not in FILESYSTEM_FILES:
+                files.append(path)
+
+    renames = {}
+    assets = {}
+    for path in build_order(src_dir, files):
+        ext = posixpath.splitext(path)[1]
+        if ext not in CONTENT_TYPES:
+            raise SystemExit("No content type for web asset %s" % path)
+        with open(os.path.join(src_dir, path), "rb") as f:
+            data = f.read()
+        raw_size = len(data)
+        target = path
+
+        if ext in MINIFIERS:
+            text = rewrite_references(data.decode("utf-8"), path, renames)
+            data = MINIFIERS[ext](text).encode("utf-8")
+        if ext in FINGERPRINT_EXTS:
+            target = fingerprinted_name(path, data)
+            renames[path] = target
+        gzipped = ext in GZIP_EXTS
+        if gzipped:
+            data = gzip.compress(data, compresslevel=9, mtime=0)
+
+        assets["/" + target] = Asset("/" + target, path, raw_size, data, gzipped)
+    return assets
+
+
+def c_string(text):
+    return '"%s"' % text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def generate_source(assets):
+    lines = [
+        "// Generated by scripts/build_web_assets.py from data/www - do not edit",
+        '#include "web_assets.h"',
+        "",
+    ]
+    ordered = sorted(assets.values(), key=lambda asset: asset.path)
+    for index, asset in enumerate(ordered):
+        lines.append("// %s (%d bytes from %s)" % (asset.path, asset.raw_size, asset.source))
+        lines.append("static const uint8_t ASSET_%d[] = {" % index)
+        for offset in range(0, len(asset.data), 16):
+            chunk = asset.data[offset:offset + 16]
+            lines.append("    " + ", ".join("0x%02x" % byte for byte in chunk) + ",")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("const WebAsset WEB_ASSETS[] = {")
+    for index, asset in enumerate(ordered):
+        lines.append("    {%s, %s, ASSET_%d, sizeof(ASSET_%d), %s, %s, %s}," % (
+            c_string(asset.path), c_string(asset.content_type), index, index, c_string(asset.etag),
+            "true" if asset.gzipped else "false", "true" if asset.immutable else "false"))
+    lines.append("};")
+    lines.append("")
+    lines.append("const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    return "\n".join(lines) + "\n"
+
+
+def write_source(project_dir, assets):
+    """Write the generated table; untouched when unchanged so nothing rebuilds."""
+    path = os.path.join(project_dir, GENERATED_SOURCE)
+    source = generate_source(assets)
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as f:
+            if f.read() == source:
+                return False
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(source)
+    return True
+
+
+def stage_filesystem(project_dir, out_dir):
+    """Copy data/ for the LittleFS image, without the UI now in the firmware."""
+    data_dir = os.path.join(project_dir, "data")
+    if os.path.isdir(out_dir):
+        shutil.rmtree(out_dir)
+    shutil.copytree(data_dir, out_dir, ignore=shutil.ignore_patterns("www"))
+    for path in sorted(FILESYSTEM_FILES):
+        source = os.path.join(data_dir, "www", *path.split("/"))
+        if os.path.exists(source):
+            target = os.path.join(out_dir, "www", *path.split("/"))
+            os.makedirs(os.path.dirname(target), exist_ok=True)
+            shutil.copy2(source, target)
+
+
+def page_assets(assets, page):
+    """Request paths a first visit to page fetches (stylesheets, scripts, images)."""
+    found = [page]
+    pending = [page]
+    while pending:
+        path = pending.pop()
+        if path not in assets or not path.endswith((".html", ".css")):
+            continue
+        base = posixpath.dirname(path)
+        for ref in re.findall(r"""(?:href|src)="([^"#?]+)"|url\("([^"]+)"\)""", assets[path].text()):
+            ref = ref[0] or ref[1]
+            if ref.startswith(("http", "/", "data:")) or ref.endswith(".html"):
+                continue
+            ref = posixpath.normpath(posixpath.join(base, ref))
+            if ref not in found:
+                found.append(ref)
+                pending.append(ref)
+    return found
+
+
+def report(assets, link_kbps):
+    # Six parallel connections, one round trip per request plus the bytes;
+    # 300 ms is typical of a weak 2.4 GHz link at the edge of range
+    rtt_ms = 300
+
+    def estimate(requests, size):
+        return ((requests + 5) // 6 * rtt_ms + size * 8 / link_kbps) / 1000
+
+    print("%d assets, %d bytes of flash" % (len(assets), sum(len(a.data) for a in assets.values())))
+    print("Estimated over %g kbit/s with %d ms round trips" % (link_kbps, rtt_ms))
+    print("%-13s %8s %16s %16s %14s" % ("page", "requests", "first (before)", "first (after)", "repeat"))
+    for page in sorted(p for p in assets if p.endswith(".html")):
+        fetched = [assets[a] for a in page_assets(assets, page) if a in assets]
+        raw = sum(a.raw_size for a in fetched)
+        sent = sum(len(a.data) for a in fetched)
+        # Uncached, every asset used to be revalidated on each visit; now only the page
+        print("%-13s %8d %7d B %5.1f s %7d B %5.1f s %5.1f s -> %.1f s" % (
+            page, len(fetched), raw, estimate(len(fetched), raw), sent, estimate(len(fetched), sent),
+            estimate(len(fetched), 0), estimate(1, 0)))
+
+
+def main():
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--link-kbps", type=float, default=256, help="link rate for the estimate")
+    args = parser.parse_args()
+
+    assets = build_www(os.path.join(project_dir, "data", "www"))
+    write_source(project_dir, assets)
+    report(assets, args.link_kbps)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    from SCons.Script import COMMAND_LINE_TARGETS  # noqa: E402
+
+    project = env.subst("$PROJECT_DIR")  # noqa: F821
+    if write_source(project, build_www(os.path.join(project, "data", "www"))):
+        print("Web assets: regenerated %s" % GENERATED_SOURCE)
+
+    if {"buildfs", "uploadfs", "uploadfsota"} & set(COMMAND_LINE_TARGETS):
+        out = os.path.join(env.subst("$BUILD_DIR"), "data")  # noqa: F821
+        stage_filesystem(project, out)
+        env.Replace(PROJECT_DATA_DIR=out)  # noqa: F821
@@ -0,0 +1,270 @@
+#include "boot_profiler.h"
+#include <LittleFS.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include "clock_manager.h"
+#include "crc32.h"
+#include "storage_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_BOOT
+
+// Indexed by BootPhase
+static const char *const PHASE_NAMES[] = {
+    "fs_mount",
+    "fs_format",
+    "config",
+    "debug",
+    "gpio",
+    "reader",
+    "card_log",
+    "credentials",
+    "stats",
+    "storage",
+    "clock",
+    "wifi",
+    "mdns",
+    "ntp",
+    "email",
+    "web",
+};
+
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == BOOT_PHASE_COUNT, "One name per boot phase");
+
+// Indexed by esp_reset_reason_t
+static const char *const RESET_REASON_NAMES[] = {
+    "unknown",
+    "power-on",
+    "external",
+    "software",
+    "panic",
+    "interrupt-watchdog",
+    "task-watchdog",
+    "watchdog",
+    "deep-sleep",
+    "brownout",
+    "sdio",
+};
+
+BootProfiler &bootProfiler = BootProfiler::getInstance();
+
+BootProfiler::BootProfiler() : phaseStartUs{}, firstReadUs(0), finished(false), history{}, historyCount(0)
+{
+    memset(&current, 0, sizeof(current));
+    current.resetReason = (uint8_t)esp_reset_reason();
+}
+
+BootProfiler &BootProfiler::getInstance()
+{
+    static BootProfiler instance;
+    return instance;
+}
+
+uint32_t BootProfiler::nowUs()
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+const char *BootProfiler::phaseName(uint8_t phase)
+{
+    return phase < BOOT_PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+const char *BootProfiler::resetReasonName(uint8_t reason)
+{
+    return reason < sizeof(RESET_REASON_NAMES) / sizeof(RESET_REASON_NAMES[0]) ? RESET_REASON_NAMES[reason]
+                                                                                : "unknown";
+}
+
+void BootProfiler::begin()
+{
+    File file = LittleFS.open(BOOT_HISTORY_FILE, "r");
+    if (!file)
+    {
+        return;
+    }
+
+    HistoryHeader header;
+    BootRecord loaded[BOOT_HISTORY_LENGTH];
+    bool valid = file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                 header.version == BOOT_HISTORY_VERSION && header.length <= sizeof(loaded) &&
+                 header.length % sizeof(BootRecord) == 0 &&
+                 file.read((uint8_t *)loaded, header.length) == header.length &&
+                 crc32Update(0, loaded, header.length) == header.crc;
+    file.close();
+
+    if (!valid)
+    {
+        LOG_W("[BOOT] Boot history is damaged or from another version - starting over");
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    historyCount = header.length / sizeof(BootRecord);
+    memcpy(history, loaded, header.length);
+    current.bootNumber = historyCount > 0 ? history[0].bootNumber + 1 : 0;
+}
+
+void BootProfiler::start(BootPhase phase)
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    phaseStartUs[phase] = nowUs();
+}
+
+void BootProfiler::end(BootPhase phase)
+{
+    bool late;
+    {
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        uint32_t elapsed = nowUs() - phaseStartUs[phase];
+        current.phaseUs[phase] = elapsed > 0 ? elapsed : 1;
+        late = finished;
+        // SNTP has set the clock by the time it ends its phase
+        uint32_t wall = clockManager.now();
+        if (late && current.wallTime == 0 && ClockManager::isWallTime(wall))
+        {
+            current.wallTime = wall;
+        }
+    }
+
+    // A phase that outlasts the network task (the first SNTP sync) is
+    // saved again so the history records it
+    if (late)
+    {
+        LOG_I("[BOOT] %s finished after boot, took %lu ms", phaseName(phase),
+              (unsigned long)(current.phaseUs[phase] / 1000));
+        storageManager.run(saveJob);
+    }
+}
+
+void BootProfiler::markCaptureReady()
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    current.captureReadyUs = nowUs();
+    LOG_I("[BOOT] Capture ready %lu ms after boot", (unsigned long)(current.captureReadyUs / 1000));
+}
+
+void BootProfiler::markFirstRead()
+{
+    if (firstReadUs != 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    firstReadUs = nowUs();
+    LOG_I("[BOOT] First read %lu ms after boot", (unsigned long)(firstReadUs / 1000));
+}
+
+void BootProfiler::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        current.networkReadyUs = nowUs();
+        current.wallTime = clockManager.isSynced() ? clockManager.now() : 0;
+        finished = true;
+    }
+
+    LOG_SEPARATOR();
+    LOG_I("[BOOT] Boot #%lu (%s reset): capture ready at %lu ms, network at %lu ms",
+          (unsigned long)current.bootNumber, resetReasonName(current.resetReason),
+          (unsigned long)(current.captureReadyUs / 1000), (unsigned long)(current.networkReadyUs / 1000));
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+    {
+        if (current.phaseUs[phase] != 0)
+        {
+            LOG_I("[BOOT]   %-12s at %6lu ms took %6lu.%lu ms", phaseName(phase),
+                  (unsigned long)(phaseStartUs[phase] / 1000), (unsigned long)(current.phaseUs[phase] / 1000),
+                  (unsigned long)(current.phaseUs[phase] % 1000 / 100));
+        }
+    }
+
+    storageManager.run(saveJob);
+}
+
+void BootProfiler::saveJob(const uint8_t *data, size_t length)
+{
+    getInstance().save();
+}
+
+bool BootProfiler::save()
+{
+    // This boot first, then the newest earlier boots that still fit
+    BootRecord records[BOOT_HISTORY_LENGTH];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        records[0] = current;
+        count = historyCount < BOOT_HISTORY_LENGTH ? historyCount + 1 : BOOT_HISTORY_LENGTH;
+        memcpy(&records[1], history, (count - 1) * sizeof(BootRecord));
+    }
+
+    HistoryHeader header;
+    header.version = BOOT_HISTORY_VERSION;
+    header.length = count * sizeof(BootRecord);
+    header.crc = crc32Update(0, records, header.length);
+
+    File file = LittleFS.open(BOOT_HISTORY_TMP_FILE, "w");
+    if (!file)
+    {
+        LOG_E("[BOOT] Failed to open boot history file");
+        return false;
+    }
+    bool written = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                   file.write((const uint8_t *)records, header.length) == header.length;
+    file.close();
+
+    if (!written || !LittleFS.rename(BOOT_HISTORY_TMP_FILE, BOOT_HISTORY_FILE))
+    {
+        LittleFS.remove(BOOT_HISTORY_TMP_FILE);
+        LOG_E("[BOOT] Failed to save boot history");
+        return false;
+    }
+    return true;
+}
+
+void BootProfiler::writeRecordJson(const BootRecord &record, JsonObject out)
+{
+    out["bootNumber"] = record.bootNumber;
+    out["resetReason"] = resetReasonName(record.resetReason);
+    if (record.wallTime != 0)
+    {
+        out["time"] = record.wallTime;
+    }
+    out["captureReadyMs"] = record.captureReadyUs / 1000;
+    if (record.networkReadyUs != 0)
+    {
+        out["networkReadyMs"] = record.networkReadyUs / 1000;
+    }
+    JsonObject phases = out["phasesUs"].to<JsonObject>();
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+    {
+        if (record.phaseUs[phase] != 0)
+        {
+            phases[phaseName(phase)] = record.phaseUs[phase];
+        }
+    }
+}
+
+void BootProfiler::writeJson(JsonObject out) const
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+
+    writeRecordJson(current, out);
+    out["firstReadMs"] = firstReadUs / 1000;
+    out["complete"] = finished;
+
+    JsonObject starts = out["phaseStartsUs"].to<JsonObject>();
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+    {
+        if (current.phaseUs[phase] != 0)
+        {
+            starts[phaseName(phase)] = phaseStartUs[phase];
+        }
+    }
+
+    JsonArray earlier = out["history"].to<JsonArray>();
+    for (uint8_t i = 0; i < historyCount; i++)
+    {
+        writeRecordJson(history[i], earlier.add<JsonObject>());
+    }
+}
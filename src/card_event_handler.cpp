@@ -1,6 +1,10 @@
 #include "card_event_handler.h"
+#include "card_stream.h"
 #include "wifi_setup_manager.h"
 #include "keypad_processor.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_CREDENTIALS
 
 extern ReaderManager &readerManager;
 
@@ -40,7 +44,21 @@ void CardEventHandler::handleKeypadEvent(CardProcessor &cardProcessor)
 
 void CardEventHandler::processHIDCardData(CardProcessor &cardProcessor)
 {
-    logger.writeCardLog();
+    CredentialSighting sighting = recordCredential(cardProcessor);
+    if (sighting.log)
+    {
+        logger.writeCardLog();
+    }
+    else
+    {
+        LOG_D("[CREDENTIALS] Repeat read #%lu of a known credential - counters updated",
+              (unsigned long)sighting.count);
+        cardStream.publishRepeat();
+    }
+    if (!sighting.notify)
+    {
+        return;
+    }
 
     String cardData = String(cardProcessor.getBitCount()) + "," +
                       String(cardProcessor.getFacilityCode()) + "," +
@@ -52,7 +70,21 @@ void CardEventHandler::processHIDCardData(CardProcessor &cardProcessor)
 
 void CardEventHandler::processNet2CardData(CardProcessor &cardProcessor)
 {
-    logger.writeCardLog();
+    CredentialSighting sighting = recordCredential(cardProcessor);
+    if (sighting.log)
+    {
+        logger.writeCardLog();
+    }
+    else
+    {
+        LOG_D("[CREDENTIALS] Repeat read #%lu of a known credential - counters updated",
+              (unsigned long)sighting.count);
+        cardStream.publishRepeat();
+    }
+    if (!sighting.notify)
+    {
+        return;
+    }
 
     String cardData = String(cardProcessor.getBitCount()) + "," +
                       String(cardProcessor.getFacilityCode()) + "," +
@@ -81,6 +113,28 @@ void CardEventHandler::processKeypadData(CardProcessor &cardProcessor)
     notificationManager.handlePinRead(keypadData.c_str());
 }
 
+CredentialSighting CardEventHandler::recordCredential(CardProcessor &cardProcessor)
+{
+    char id[CREDENTIAL_ID_LENGTH];
+
+    if (cardProcessor.isNet2Card())
+    {
+        snprintf(id, sizeof(id), "%lu", cardProcessor.getCardNumber());
+        return credentialIndex.record(75, 0, id, cardProcessor.getNet2HexEM410x().c_str(), true);
+    }
+
+    unsigned int bits = cardProcessor.getBitCount();
+    if (bits == 32 && cardProcessor.getFacilityCode() >= 512)
+    {
+        // PIV/MF credentials are identified by their UID
+        return credentialIndex.record(bits, 0, cardProcessor.getReversedPairsUID().c_str(),
+                                      cardProcessor.getCsvHEX().c_str(), false);
+    }
+
+    snprintf(id, sizeof(id), "%lu", cardProcessor.getCardNumber());
+    return credentialIndex.record(bits, cardProcessor.getFacilityCode(), id, cardProcessor.getCsvHEX().c_str(), false);
+}
+
 String CardEventHandler::formatPinCode(CardProcessor &cardProcessor)
 {
     if ((cardProcessor.getBitHolder1() == 10) && cardProcessor.getBitCount() == 4)
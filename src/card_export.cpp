@@ -0,0 +1,70 @@
+#include "card_export.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_CARDLOG
+
+std::atomic<uint8_t> CardExport::active(0);
+
+CardExport *CardExport::create(CardLogLineFormat format)
+{
+    uint8_t running = active.load();
+    do
+    {
+        if (running >= CARD_EXPORT_MAX_ACTIVE)
+        {
+            return nullptr;
+        }
+    } while (!active.compare_exchange_weak(running, running + 1));
+
+    CardExport *exporter = new (std::nothrow) CardExport(format);
+    if (!exporter)
+    {
+        active--;
+    }
+    return exporter;
+}
+
+CardExport::CardExport(CardLogLineFormat format)
+    : inputLen(0), inputPos(0), sourceDone(false), startTime(millis())
+{
+    cursor.format = format;
+}
+
+CardExport::~CardExport()
+{
+    uint32_t bytesIn = deflate.getTotalIn();
+    uint32_t bytesOut = deflate.getTotalOut();
+    LOG_I("[EXPORT] %s: %lu bytes -> %lu bytes gzip (%lu%%) in %lu ms",
+          deflate.isDone() ? "Complete" : "Aborted", (unsigned long)bytesIn, (unsigned long)bytesOut,
+          bytesIn ? (unsigned long)((uint64_t)bytesOut * 100 / bytesIn) : 0UL,
+          (unsigned long)(millis() - startTime));
+    active--;
+}
+
+size_t CardExport::read(uint8_t *buffer, size_t maxLen)
+{
+    size_t produced = 0;
+    while (produced < maxLen)
+    {
+        size_t n = deflate.read(buffer + produced, maxLen - produced);
+        if (n > 0)
+        {
+            produced += n;
+            continue;
+        }
+        if (deflate.isDone())
+        {
+            break;
+        }
+
+        // Compressed output is drained - feed the compressor more log lines
+        if (inputPos == inputLen && !sourceDone)
+        {
+            inputLen = cardLogManager.read(cursor, input, sizeof(input));
+            inputPos = 0;
+            sourceDone = (inputLen == 0);
+        }
+        inputPos += deflate.process(input + inputPos, inputLen - inputPos, sourceDone);
+    }
+    return produced;
+}
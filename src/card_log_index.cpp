@@ -0,0 +1,215 @@
+#include "card_log_index.h"
+
+// Format names as reported by CardProcessor::getCardFormat(); the position
+// in this table is the format ID stored in the index, so only append to it
+static const char *const FORMAT_NAMES[] = {
+    nullptr, // CARD_INDEX_FORMAT_OTHER
+    "PIN",
+    "Unknown",
+    "H10301/Ind26/AWID26",
+    "H10307/Ind27",
+    "2804W",
+    "Ind29",
+    "ATSW30",
+    "ADT31",
+    "PIV/MiFare/FASC-N",
+    "WIE32/EM",
+    "D10202",
+    "H10306",
+    "C1k35s (C-1000)",
+    "S12906",
+    "H10304",
+    "BQT38/ISCS",
+    "PW39",
+    "P10001/Casi40/Verkada40/BC40/AWID40",
+    "H800002",
+    "C1k48s (C-1000)",
+    "AWID50",
+    "Avig56",
+    "H10309",
+    "Net2/EM",
+};
+
+static const uint8_t FORMAT_COUNT = sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0]);
+
+static_assert(sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0]) <= 32, "Format IDs must fit in a 32-bit mask");
+
+static uint32_t fcBloomBits(uint32_t facilityCode)
+{
+    uint32_t hash = facilityCode * 2654435761UL;
+    return (1UL << (hash >> 27)) | (1UL << ((hash >> 22) & 31));
+}
+
+uint8_t cardIndexFormatId(const char *format, size_t length)
+{
+    for (uint8_t id = 1; id < FORMAT_COUNT; id++)
+    {
+        if (strlen(FORMAT_NAMES[id]) == length && strncmp(FORMAT_NAMES[id], format, length) == 0)
+        {
+            return id;
+        }
+    }
+    return CARD_INDEX_FORMAT_OTHER;
+}
+
+const char *cardIndexFormatName(uint8_t id)
+{
+    return (id > CARD_INDEX_FORMAT_OTHER && id < FORMAT_COUNT) ? FORMAT_NAMES[id] : "Other";
+}
+
+uint32_t cardIndexFormatMask(const char *query)
+{
+    size_t queryLength = strlen(query);
+    uint32_t mask = 0;
+    for (uint8_t id = 1; id < FORMAT_COUNT; id++)
+    {
+        const char *name = FORMAT_NAMES[id];
+        for (size_t start = 0; name[start] != '\0'; start++)
+        {
+            if (strncasecmp(name + start, query, queryLength) == 0)
+            {
+                mask |= 1UL << id;
+                break;
+            }
+        }
+    }
+    return mask;
+}
+
+void cardIndexParseRecord(const char *payload, size_t length, CardIndexEntry &entry)
+{
+    entry.format = CARD_INDEX_FORMAT_OTHER;
+    entry.facilityCode = 0;
+    entry.flags = 0;
+
+    // Fields are "Key: Value" separated by ", "
+    size_t i = 0;
+    while (i < length)
+    {
+        size_t keyStart = i;
+        while (i < length && payload[i] != ':')
+        {
+            i++;
+        }
+        size_t keyLength = i - keyStart;
+        i = (i < length) ? i + 1 : i;
+        while (i < length && payload[i] == ' ')
+        {
+            i++;
+        }
+        size_t valueStart = i;
+        while (i < length && !(payload[i] == ',' && i + 1 < length && payload[i + 1] == ' '))
+        {
+            i++;
+        }
+        size_t valueLength = i - valueStart;
+        i = (i < length) ? i + 2 : i;
+
+        const char *key = payload + keyStart;
+        const char *value = payload + valueStart;
+        if (keyLength == 6 && strncmp(key, "Format", 6) == 0)
+        {
+            entry.format = cardIndexFormatId(value, valueLength);
+        }
+        else if (keyLength == 13 && strncmp(key, "Facility_Code", 13) == 0 && valueLength > 0 &&
+                 isdigit((unsigned char)value[0]))
+        {
+            entry.facilityCode = strtoul(value, nullptr, 10);
+            entry.flags |= CARD_INDEX_HAS_FC;
+        }
+    }
+}
+
+void cardIndexClearSummary(CardSegmentSummary &summary)
+{
+    summary.formatMask = 0;
+    summary.fcBloom = 0;
+    summary.minTime = CARD_INDEX_NO_TIME;
+    summary.maxTime = 0;
+}
+
+void cardIndexAddToSummary(CardSegmentSummary &summary, const CardIndexEntry &entry)
+{
+    summary.formatMask |= 1UL << entry.format;
+    if (entry.flags & CARD_INDEX_HAS_FC)
+    {
+        summary.fcBloom |= fcBloomBits(entry.facilityCode);
+    }
+    if (entry.timestamp != 0)
+    {
+        if (entry.timestamp < summary.minTime)
+        {
+            summary.minTime = entry.timestamp;
+        }
+        if (entry.timestamp > summary.maxTime)
+        {
+            summary.maxTime = entry.timestamp;
+        }
+    }
+}
+
+bool cardIndexSummaryMayMatch(const CardSegmentSummary &summary, const CardLogFilter &filter)
+{
+    if (filter.hasFormat && !(summary.formatMask & filter.formatMask))
+    {
+        return false;
+    }
+    if (filter.hasFacilityCode)
+    {
+        uint32_t bits = fcBloomBits(filter.facilityCode);
+        if ((summary.fcBloom & bits) != bits)
+        {
+            return false;
+        }
+    }
+    if (filter.from || filter.to)
+    {
+        if (summary.minTime == CARD_INDEX_NO_TIME)
+        {
+            return false;
+        }
+        if (filter.from && summary.maxTime < filter.from)
+        {
+            return false;
+        }
+        if (filter.to && summary.minTime > filter.to)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool cardIndexEntryMatches(const CardIndexEntry &entry, const CardLogFilter &filter)
+{
+    if (filter.hasFormat && !(filter.formatMask & (1UL << entry.format)))
+    {
+        return false;
+    }
+    if (filter.hasFacilityCode &&
+        (!(entry.flags & CARD_INDEX_HAS_FC) || entry.facilityCode != filter.facilityCode))
+    {
+        return false;
+    }
+    if ((filter.from || filter.to) && entry.timestamp == 0)
+    {
+        return false;
+    }
+    if (filter.from && entry.timestamp < filter.from)
+    {
+        return false;
+    }
+    if (filter.to && entry.timestamp > filter.to)
+    {
+        return false;
+    }
+    if (filter.afterSeq && entry.seq <= filter.afterSeq)
+    {
+        return false;
+    }
+    if (filter.beforeSeq && entry.seq >= filter.beforeSeq)
+    {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,1433 @@
+#include "card_log_manager.h"
+#include <ArduinoJson.h>
+#include "crc32.h"
+#include "clock_manager.h"
+#include "version_config.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_CARDLOG
+
+CardLogManager &cardLogManager = CardLogManager::getInstance();
+
+CardLogManager::CardLogManager()
+    : epoch(0), firstSegment(0), activeSegment(0), activeSize(0), nextSeq(1), headSeq(0), bootFirstSeq(0), wallOffset(0), resolveCount(0),
+      segmentBaseSeq{}, segmentRecords{}, segmentSummary{}, maxBytes(CARD_LOG_DEFAULT_MAX_BYTES), policy(CARD_LOG_EVICT_OLDEST),
+      full(false), gcPending(false)
+{
+}
+
+CardLogManager &CardLogManager::getInstance()
+{
+    static CardLogManager instance;
+    return instance;
+}
+
+void CardLogManager::segmentPath(char *out, size_t outLen, uint32_t segEpoch, uint32_t index)
+{
+    snprintf(out, outLen, "%s/%lu_%lu.seg", CARD_LOG_DIR, (unsigned long)segEpoch, (unsigned long)index);
+}
+
+void CardLogManager::indexPath(char *out, size_t outLen, uint32_t segEpoch, uint32_t index)
+{
+    snprintf(out, outLen, "%s/%lu_%lu.idx", CARD_LOG_DIR, (unsigned long)segEpoch, (unsigned long)index);
+}
+
+uint32_t CardLogManager::frameCrc(const CardLogFrameHeader &header, const uint8_t *payload)
+{
+    CardLogFrameHeader unsealed = header;
+    unsealed.crc = 0;
+
+    // Version 1 headers end where the timestamp starts
+    size_t headerSize = sizeof(unsealed);
+    if (header.version == CARD_LOG_FRAME_V1)
+    {
+        unsealed.timestamp = 0;
+        headerSize = CARD_LOG_FRAME_V1_HEADER_SIZE;
+    }
+    uint32_t crc = crc32Update(0, &unsealed, headerSize);
+    return crc32Update(crc, payload, header.length);
+}
+
+size_t CardLogManager::frameSize(const CardLogFrameHeader &header)
+{
+    return (header.version == CARD_LOG_FRAME_V1 ? CARD_LOG_FRAME_V1_HEADER_SIZE : sizeof(header)) + header.length;
+}
+
+bool CardLogManager::readFrameHeader(File &segment, CardLogFrameHeader &header)
+{
+    if (segment.read((uint8_t *)&header, CARD_LOG_FRAME_V1_HEADER_SIZE) != CARD_LOG_FRAME_V1_HEADER_SIZE ||
+        header.magic != CARD_LOG_FRAME_MAGIC || header.length > CARD_LOG_MAX_RECORD)
+    {
+        return false;
+    }
+    if (header.version == CARD_LOG_FRAME_V1)
+    {
+        // The CRC landed in the timestamp field
+        header.crc = header.timestamp;
+        header.timestamp = 0;
+        return true;
+    }
+    return header.version == CARD_LOG_FRAME_VERSION &&
+           segment.read((uint8_t *)&header.crc, sizeof(header.crc)) == sizeof(header.crc);
+}
+
+bool CardLogManager::readFrame(File &segment, CardLogFrameHeader &header, char *payload)
+{
+    if (!readFrameHeader(segment, header))
+    {
+        return false;
+    }
+    if (segment.read((uint8_t *)payload, header.length) != header.length)
+    {
+        return false;
+    }
+    return frameCrc(header, (const uint8_t *)payload) == header.crc;
+}
+
+void CardLogManager::begin()
+{
+    if (!LittleFS.exists(CARD_LOG_DIR))
+    {
+        LittleFS.mkdir(CARD_LOG_DIR);
+    }
+    if (LittleFS.exists(CARD_LOG_RECOVERY_TMP_FILE))
+    {
+        LittleFS.remove(CARD_LOG_RECOVERY_TMP_FILE);
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    LOG_SEPARATOR();
+    LOG_I("[CARD LOG] Loading card log manifest...");
+
+    if (!loadManifest())
+    {
+        LOG_I("[CARD LOG] No valid manifest found. Starting a new log...");
+        resetManifest(epoch + 1);
+        migrateLegacyLog();
+        saveManifest();
+    }
+
+    unsigned long recoveryStart = millis();
+    recoverActiveSegment();
+    bootFirstSeq = nextSeq.load();
+
+    // Sweep anything left behind by an earlier wipe or eviction
+    gcPending = true;
+
+    LOG_I("[CARD LOG] Epoch %lu, %lu segment(s), %lu of %lu bytes used%s",
+          (unsigned long)epoch, (unsigned long)(activeSegment - firstSegment + 1),
+          (unsigned long)((activeSegment - firstSegment) * CARD_LOG_SEGMENT_SIZE + activeSize),
+          (unsigned long)maxBytes, full ? " (FULL)" : "");
+    LOG_I("[CARD LOG] Next record #%lu (recovery took %lu ms)",
+          (unsigned long)nextSeq.load(), millis() - recoveryStart);
+}
+
+bool CardLogManager::loadManifest()
+{
+    if (!LittleFS.exists(CARD_LOG_MANIFEST_FILE))
+    {
+        // A commit was interrupted between writing the temp file and renaming it
+        if (!LittleFS.exists(CARD_LOG_MANIFEST_TMP_FILE) ||
+            !LittleFS.rename(CARD_LOG_MANIFEST_TMP_FILE, CARD_LOG_MANIFEST_FILE))
+        {
+            return false;
+        }
+    }
+
+    File manifestFile = LittleFS.open(CARD_LOG_MANIFEST_FILE, "r");
+    if (!manifestFile)
+    {
+        return false;
+    }
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, manifestFile);
+    manifestFile.close();
+
+    if (error)
+    {
+        return false;
+    }
+    if ((doc["version"] | 0) != CARD_LOG_MANIFEST_VERSION)
+    {
+        // Older layout - keep counting epochs so its segments are swept as stale
+        epoch = doc["epoch"] | epoch;
+        return false;
+    }
+
+    epoch = doc["epoch"] | 1;
+    firstSegment = doc["first"] | 0;
+    activeSegment = doc["active"] | 0;
+    maxBytes = doc["max_bytes"] | CARD_LOG_DEFAULT_MAX_BYTES;
+    policy = (strcmp(doc["policy"] | "evict", "stop") == 0) ? CARD_LOG_STOP_WHEN_FULL : CARD_LOG_EVICT_OLDEST;
+    full = doc["full"] | false;
+    resolveCount = doc["resolves"] | 0;
+
+    if (maxBytes < CARD_LOG_MIN_MAX_BYTES)
+    {
+        maxBytes = CARD_LOG_MIN_MAX_BYTES;
+    }
+    if (activeSegment < firstSegment || activeSegment - firstSegment >= CARD_LOG_MAX_SEGMENTS)
+    {
+        return false;
+    }
+
+    JsonArray bases = doc["segs"].as<JsonArray>();
+    if (bases.size() != activeSegment - firstSegment + 1)
+    {
+        return false;
+    }
+    uint32_t index = firstSegment;
+    for (JsonVariant base : bases)
+    {
+        segmentBaseSeq[index % CARD_LOG_MAX_SEGMENTS] = base.as<uint32_t>();
+        index++;
+    }
+
+    // Record counts of sealed segments; fall back to the sequence spacing
+    JsonArray counts = doc["counts"].as<JsonArray>();
+    for (index = firstSegment; index < activeSegment; index++)
+    {
+        uint32_t slot = index % CARD_LOG_MAX_SEGMENTS;
+        JsonVariant stored = counts[index - firstSegment];
+        segmentRecords[slot] = stored.is<uint32_t>()
+                                   ? stored.as<uint32_t>()
+                                   : segmentBaseSeq[(index + 1) % CARD_LOG_MAX_SEGMENTS] - segmentBaseSeq[slot];
+    }
+
+    // Index summaries of sealed segments; rebuilt from the segment if missing
+    JsonArray formats = doc["fmt"].as<JsonArray>();
+    JsonArray blooms = doc["fcb"].as<JsonArray>();
+    JsonArray minTimes = doc["tmin"].as<JsonArray>();
+    JsonArray maxTimes = doc["tmax"].as<JsonArray>();
+    for (index = firstSegment; index < activeSegment; index++)
+    {
+        uint32_t position = index - firstSegment;
+        CardSegmentSummary &summary = segmentSummary[index % CARD_LOG_MAX_SEGMENTS];
+        if (formats[position].is<uint32_t>() && blooms[position].is<uint32_t>() &&
+            minTimes[position].is<uint32_t>() && maxTimes[position].is<uint32_t>())
+        {
+            summary.formatMask = formats[position].as<uint32_t>();
+            summary.fcBloom = blooms[position].as<uint32_t>();
+            summary.minTime = minTimes[position].as<uint32_t>();
+            summary.maxTime = maxTimes[position].as<uint32_t>();
+        }
+        else
+        {
+            syncSegmentIndex(index);
+        }
+    }
+
+    nextSeq = segmentBaseSeq[activeSegment % CARD_LOG_MAX_SEGMENTS];
+    return true;
+}
+
+bool CardLogManager::saveManifest()
+{
+    JsonDocument doc;
+    doc["version"] = CARD_LOG_MANIFEST_VERSION;
+    doc["epoch"] = epoch;
+    doc["first"] = firstSegment;
+    doc["active"] = activeSegment;
+    doc["max_bytes"] = maxBytes;
+    doc["policy"] = (policy == CARD_LOG_STOP_WHEN_FULL) ? "stop" : "evict";
+    doc["full"] = full;
+    doc["resolves"] = resolveCount;
+
+    // Base sequence number of every live segment, oldest first
+    JsonArray bases = doc["segs"].to<JsonArray>();
+    JsonArray counts = doc["counts"].to<JsonArray>();
+    JsonArray formats = doc["fmt"].to<JsonArray>();
+    JsonArray blooms = doc["fcb"].to<JsonArray>();
+    JsonArray minTimes = doc["tmin"].to<JsonArray>();
+    JsonArray maxTimes = doc["tmax"].to<JsonArray>();
+    for (uint32_t index = firstSegment; index <= activeSegment; index++)
+    {
+        const CardSegmentSummary &summary = segmentSummary[index % CARD_LOG_MAX_SEGMENTS];
+        bases.add(segmentBaseSeq[index % CARD_LOG_MAX_SEGMENTS]);
+        counts.add(segmentRecords[index % CARD_LOG_MAX_SEGMENTS]);
+        formats.add(summary.formatMask);
+        blooms.add(summary.fcBloom);
+        minTimes.add(summary.minTime);
+        maxTimes.add(summary.maxTime);
+    }
+
+    File manifestFile = LittleFS.open(CARD_LOG_MANIFEST_TMP_FILE, "w");
+    if (!manifestFile)
+    {
+        LOG_E("[CARD LOG] Failed to open manifest for writing");
+        return false;
+    }
+
+    if (serializeJson(doc, manifestFile) == 0)
+    {
+        manifestFile.close();
+        LOG_E("[CARD LOG] Failed to write manifest");
+        return false;
+    }
+    manifestFile.close();
+
+    // Write-then-rename so a reset never leaves a half-written manifest
+    if (!LittleFS.rename(CARD_LOG_MANIFEST_TMP_FILE, CARD_LOG_MANIFEST_FILE))
+    {
+        LittleFS.remove(CARD_LOG_MANIFEST_FILE);
+        if (!LittleFS.rename(CARD_LOG_MANIFEST_TMP_FILE, CARD_LOG_MANIFEST_FILE))
+        {
+            LOG_E("[CARD LOG] Failed to commit manifest");
+            return false;
+        }
+    }
+    return true;
+}
+
+void CardLogManager::resetManifest(uint32_t newEpoch)
+{
+    epoch = newEpoch;
+    firstSegment = 0;
+    activeSegment = 0;
+    activeSize = 0;
+    full = false;
+
+    // Sequence numbers keep increasing across wipes
+    segmentBaseSeq[0] = nextSeq.load();
+    segmentRecords[0] = 0;
+    cardIndexClearSummary(segmentSummary[0]);
+}
+
+void CardLogManager::migrateLegacyLog()
+{
+    if (!LittleFS.exists(CARDS_CSV_FILE))
+    {
+        return;
+    }
+
+    File legacy = LittleFS.open(CARDS_CSV_FILE, "r");
+    if (!legacy)
+    {
+        LOG_E("[CARD LOG] Failed to migrate %s", CARDS_CSV_FILE);
+        return;
+    }
+
+    // Re-frame each legacy line as a record
+    char line[CARD_LOG_MAX_RECORD];
+    uint32_t migrated = 0;
+    while (legacy.available())
+    {
+        size_t length = legacy.readBytesUntil('\n', line, sizeof(line));
+        if (length > 0 && line[length - 1] == '\r')
+        {
+            length--;
+        }
+        if (length > 0 && writeFrame(line, length, reserveSeq(), 0))
+        {
+            migrated++;
+        }
+    }
+    legacy.close();
+    LittleFS.remove(CARDS_CSV_FILE);
+
+    LOG_I("[CARD LOG] Migrated %lu record(s) from %s", (unsigned long)migrated, CARDS_CSV_FILE);
+}
+
+void CardLogManager::recoverActiveSegment()
+{
+    char path[48];
+    segmentPath(path, sizeof(path), epoch, activeSegment);
+    uint32_t recoveredSeq = segmentBaseSeq[activeSegment % CARD_LOG_MAX_SEGMENTS];
+    uint32_t &records = segmentRecords[activeSegment % CARD_LOG_MAX_SEGMENTS];
+    activeSize = 0;
+    records = 0;
+
+    File segment = LittleFS.open(path, "r");
+    if (!segment)
+    {
+        if (recoveredSeq > nextSeq)
+        {
+            nextSeq = recoveredSeq;
+        }
+        if (recoveredSeq - 1 > headSeq)
+        {
+            headSeq = recoveredSeq - 1;
+        }
+        syncSegmentIndex(activeSegment);
+        return;
+    }
+
+    // Walk the frames of the active segment; sealed segments are never torn
+    size_t fileSize = segment.size();
+    CardLogFrameHeader header;
+    char payload[CARD_LOG_MAX_RECORD];
+    while (activeSize < fileSize && readFrame(segment, header, payload))
+    {
+        activeSize += frameSize(header);
+        recoveredSeq = header.seq + 1;
+        records++;
+    }
+    segment.close();
+
+    // Never hand out a number that is already reserved for a queued record
+    if (recoveredSeq > nextSeq)
+    {
+        nextSeq = recoveredSeq;
+    }
+    if (recoveredSeq - 1 > headSeq)
+    {
+        headSeq = recoveredSeq - 1;
+    }
+
+    if (activeSize == fileSize)
+    {
+        syncSegmentIndex(activeSegment);
+        return;
+    }
+
+    LOG_W("[CARD LOG] Dropping %lu torn byte(s) at the end of %s",
+          (unsigned long)(fileSize - activeSize), path);
+
+    // Copy the intact prefix aside and rename it over the segment
+    File source = LittleFS.open(path, "r");
+    File target = LittleFS.open(CARD_LOG_RECOVERY_TMP_FILE, "w");
+    bool copied = source && target;
+    uint8_t chunk[256];
+    size_t remaining = activeSize;
+    while (copied && remaining > 0)
+    {
+        size_t n = source.read(chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+        copied = n > 0 && target.write(chunk, n) == n;
+        remaining -= n;
+    }
+    if (source)
+    {
+        source.close();
+    }
+    if (target)
+    {
+        target.close();
+    }
+
+    if (copied && LittleFS.rename(CARD_LOG_RECOVERY_TMP_FILE, path))
+    {
+        syncSegmentIndex(activeSegment);
+        return;
+    }
+
+    // Leave the torn tail where it is (readers stop at the first bad frame)
+    // and continue in a fresh segment
+    LOG_E("[CARD LOG] Failed to truncate segment - starting a new one");
+    LittleFS.remove(CARD_LOG_RECOVERY_TMP_FILE);
+    syncSegmentIndex(activeSegment);
+    rotate(nextSeq.load());
+}
+
+void CardLogManager::syncSegmentIndex(uint32_t index)
+{
+    uint32_t slot = index % CARD_LOG_MAX_SEGMENTS;
+    CardSegmentSummary &summary = segmentSummary[slot];
+    cardIndexClearSummary(summary);
+
+    char path[48];
+    indexPath(path, sizeof(path), epoch, index);
+    File indexFile = LittleFS.open(path, "r");
+    CardIndexEntry entry;
+
+    if (!indexFile && segmentRecords[slot] == 0)
+    {
+        return;
+    }
+
+    // Normal case: one entry per stored frame - only the summary is rebuilt
+    if (indexFile && indexFile.size() == segmentRecords[slot] * sizeof(CardIndexEntry))
+    {
+        while (indexFile.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry))
+        {
+            cardIndexAddToSummary(summary, entry);
+        }
+        indexFile.close();
+        return;
+    }
+
+    // Index missing or out of step with the segment: re-derive it from the
+    // frames, keeping the entries that still line up (they carry the capture time)
+    char segmentFile[48];
+    segmentPath(segmentFile, sizeof(segmentFile), epoch, index);
+    File segment = LittleFS.open(segmentFile, "r");
+    File target = LittleFS.open(CARD_LOG_INDEX_TMP_FILE, "w");
+    if (!target)
+    {
+        LOG_E("[CARD LOG] Failed to rebuild the index of segment %lu", (unsigned long)index);
+        if (segment)
+        {
+            segment.close();
+        }
+        if (indexFile)
+        {
+            indexFile.close();
+        }
+        return;
+    }
+
+    CardLogFrameHeader header;
+    char payload[CARD_LOG_MAX_RECORD];
+    uint32_t position = 0;
+    uint32_t entries = 0;
+    bool reuse = (bool)indexFile;
+    while (segment && entries < segmentRecords[slot] && readFrame(segment, header, payload))
+    {
+        if (!reuse || indexFile.read((uint8_t *)&entry, sizeof(entry)) != sizeof(entry) ||
+            entry.seq != header.seq || entry.offset != position)
+        {
+            reuse = false;
+            entry.seq = header.seq;
+            entry.timestamp = header.timestamp;
+            entry.offset = (uint16_t)position;
+            cardIndexParseRecord(payload, header.length, entry);
+        }
+        target.write((const uint8_t *)&entry, sizeof(entry));
+        cardIndexAddToSummary(summary, entry);
+        position += frameSize(header);
+        entries++;
+    }
+    target.close();
+    if (segment)
+    {
+        segment.close();
+    }
+    if (indexFile)
+    {
+        indexFile.close();
+    }
+
+    LittleFS.remove(path);
+    if (!LittleFS.rename(CARD_LOG_INDEX_TMP_FILE, path))
+    {
+        LOG_E("[CARD LOG] Failed to commit the index of segment %lu", (unsigned long)index);
+        return;
+    }
+    LOG_I("[CARD LOG] Rebuilt the index of segment %lu (%lu entries)", (unsigned long)index,
+          (unsigned long)entries);
+}
+
+bool CardLogManager::rotate(uint32_t baseSeq)
+{
+    uint32_t maxSegments = maxBytes / CARD_LOG_SEGMENT_SIZE;
+    if (maxSegments > CARD_LOG_MAX_SEGMENTS)
+    {
+        maxSegments = CARD_LOG_MAX_SEGMENTS;
+    }
+
+    if (activeSegment - firstSegment + 1 >= maxSegments)
+    {
+        if (policy == CARD_LOG_STOP_WHEN_FULL)
+        {
+            full = true;
+            saveManifest();
+            LOG_W("[CARD LOG] Card log is full - new reads will not be stored");
+            return false;
+        }
+
+        // Evict the oldest segment(s); the files are deleted from update()
+        firstSegment = activeSegment + 2 - maxSegments;
+        gcPending = true;
+    }
+
+    activeSegment++;
+    activeSize = 0;
+    segmentBaseSeq[activeSegment % CARD_LOG_MAX_SEGMENTS] = baseSeq;
+    segmentRecords[activeSegment % CARD_LOG_MAX_SEGMENTS] = 0;
+    cardIndexClearSummary(segmentSummary[activeSegment % CARD_LOG_MAX_SEGMENTS]);
+    return saveManifest();
+}
+
+bool CardLogManager::append(const char *record, size_t length, uint32_t seq, uint32_t timestamp)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    // Captured before the clock was set but written after
+    if (wallOffset && timestamp && !ClockManager::isWallTime(timestamp))
+    {
+        timestamp += wallOffset;
+    }
+    return writeFrame(record, length, seq, timestamp);
+}
+
+bool CardLogManager::writeFrame(const char *record, size_t length, uint32_t seq, uint32_t timestamp)
+{
+    if (full)
+    {
+        return false;
+    }
+    if (length > CARD_LOG_MAX_RECORD)
+    {
+        length = CARD_LOG_MAX_RECORD;
+    }
+
+    size_t frameLength = sizeof(CardLogFrameHeader) + length;
+    if (activeSize > 0 && activeSize + frameLength > CARD_LOG_SEGMENT_SIZE)
+    {
+        if (!rotate(seq))
+        {
+            return false;
+        }
+    }
+    else if (activeSize == 0)
+    {
+        segmentBaseSeq[activeSegment % CARD_LOG_MAX_SEGMENTS] = seq;
+    }
+
+    CardLogFrameHeader header;
+    header.magic = CARD_LOG_FRAME_MAGIC;
+    header.version = CARD_LOG_FRAME_VERSION;
+    header.length = (uint16_t)length;
+    header.seq = seq;
+    header.timestamp = timestamp;
+    header.crc = frameCrc(header, (const uint8_t *)record);
+
+    // Assemble the whole frame so it reaches the file in a single write
+    uint8_t frame[sizeof(CardLogFrameHeader) + CARD_LOG_MAX_RECORD];
+    memcpy(frame, &header, sizeof(header));
+    memcpy(frame + sizeof(header), record, length);
+
+    char path[48];
+    segmentPath(path, sizeof(path), epoch, activeSegment);
+    File segment = LittleFS.open(path, "a");
+    if (!segment)
+    {
+        LOG_E("[CARD LOG] There was an error opening %s", path);
+        return false;
+    }
+
+    size_t written = segment.write(frame, frameLength);
+    segment.close();
+
+    if (written != frameLength)
+    {
+        LOG_E("[CARD LOG] Short write to %s", path);
+        recoverActiveSegment();
+        return false;
+    }
+
+    CardIndexEntry entry;
+    entry.seq = seq;
+    entry.timestamp = timestamp;
+    entry.offset = (uint16_t)activeSize;
+    cardIndexParseRecord(record, length, entry);
+
+    activeSize += frameLength;
+    segmentRecords[activeSegment % CARD_LOG_MAX_SEGMENTS]++;
+    cardIndexAddToSummary(segmentSummary[activeSegment % CARD_LOG_MAX_SEGMENTS], entry);
+    if (seq > headSeq)
+    {
+        headSeq = seq;
+    }
+
+    // A missing entry only hides the record from filtered queries; the
+    // index is re-derived from the segment at the next boot
+    indexPath(path, sizeof(path), epoch, activeSegment);
+    File indexFile = LittleFS.open(path, "a");
+    if (!indexFile || indexFile.write((const uint8_t *)&entry, sizeof(entry)) != sizeof(entry))
+    {
+        LOG_E("[CARD LOG] Failed to index record in %s", path);
+    }
+    if (indexFile)
+    {
+        indexFile.close();
+    }
+    return true;
+}
+
+void CardLogManager::wipe()
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    resetManifest(epoch + 1);
+    saveManifest();
+    gcPending = true;
+}
+
+void CardLogManager::resolveBootTimes(uint32_t offset)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    wallOffset = offset;
+
+    // Only this boot's records can be resolved; walk back until an older segment
+    uint32_t resolved = 0;
+    uint32_t index = activeSegment + 1;
+    while (index-- > firstSegment)
+    {
+        uint32_t slot = index % CARD_LOG_MAX_SEGMENTS;
+        uint32_t lastSeq = index < activeSegment ? segmentBaseSeq[(index + 1) % CARD_LOG_MAX_SEGMENTS] - 1 : headSeq;
+        if (segmentRecords[slot] == 0)
+        {
+            continue;
+        }
+        if (lastSeq < bootFirstSeq)
+        {
+            break;
+        }
+        resolved += resolveSegmentTimes(index, offset);
+    }
+
+    if (resolved > 0)
+    {
+        // Cached pages still show the boot-relative times
+        resolveCount++;
+        saveManifest();
+    }
+    LOG_I("[CARD LOG] Resolved capture time of %lu record(s)", (unsigned long)resolved);
+}
+
+uint32_t CardLogManager::resolveSegmentTimes(uint32_t index, uint32_t offset)
+{
+    char path[48];
+    segmentPath(path, sizeof(path), epoch, index);
+    File segment = LittleFS.open(path, "r+");
+    if (!segment)
+    {
+        return 0;
+    }
+    indexPath(path, sizeof(path), epoch, index);
+    File indexFile = LittleFS.open(path, "r+");
+
+    // Headers are rewritten in place; LittleFS commits the file atomically on close
+    CardLogFrameHeader header;
+    CardIndexEntry entry;
+    char payload[CARD_LOG_MAX_RECORD];
+    uint32_t position = 0;
+    uint32_t frame = 0;
+    uint32_t resolved = 0;
+    while (segment.seek(position) && readFrame(segment, header, payload))
+    {
+        uint32_t next = position + frameSize(header);
+        if (header.version == CARD_LOG_FRAME_VERSION && header.seq >= bootFirstSeq && header.timestamp != 0 &&
+            !ClockManager::isWallTime(header.timestamp))
+        {
+            header.timestamp += offset;
+            header.crc = frameCrc(header, (const uint8_t *)payload);
+            if (segment.seek(position) && segment.write((const uint8_t *)&header, sizeof(header)) == sizeof(header))
+            {
+                resolved++;
+                if (indexFile && indexFile.seek(frame * sizeof(entry)) &&
+                    indexFile.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry) && entry.seq == header.seq)
+                {
+                    entry.timestamp = header.timestamp;
+                    indexFile.seek(frame * sizeof(entry));
+                    indexFile.write((const uint8_t *)&entry, sizeof(entry));
+                }
+            }
+        }
+        position = next;
+        frame++;
+    }
+    segment.close();
+    if (indexFile)
+    {
+        indexFile.close();
+    }
+
+    if (resolved > 0)
+    {
+        syncSegmentIndex(index);
+    }
+    return resolved;
+}
+
+void CardLogManager::setCapacity(uint32_t newMaxBytes, CardLogFullPolicy newPolicy)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    if (newMaxBytes < CARD_LOG_MIN_MAX_BYTES)
+    {
+        newMaxBytes = CARD_LOG_MIN_MAX_BYTES;
+    }
+    if (newMaxBytes > CARD_LOG_MAX_SEGMENTS * CARD_LOG_SEGMENT_SIZE)
+    {
+        newMaxBytes = CARD_LOG_MAX_SEGMENTS * CARD_LOG_SEGMENT_SIZE;
+    }
+
+    maxBytes = newMaxBytes;
+    policy = newPolicy;
+
+    uint32_t maxSegments = maxBytes / CARD_LOG_SEGMENT_SIZE;
+    uint32_t liveSegments = activeSegment - firstSegment + 1;
+    if (liveSegments > maxSegments)
+    {
+        if (policy == CARD_LOG_EVICT_OLDEST)
+        {
+            firstSegment = activeSegment + 1 - maxSegments;
+            gcPending = true;
+        }
+        else
+        {
+            full = true;
+        }
+    }
+    else if (policy == CARD_LOG_EVICT_OLDEST || liveSegments < maxSegments)
+    {
+        full = false;
+    }
+
+    saveManifest();
+}
+
+void CardLogManager::getEtag(char *out, size_t outLen) const
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    snprintf(out, outLen, "\"%lu-%lu-%lu-%lu\"", (unsigned long)epoch, (unsigned long)firstSegment,
+             (unsigned long)headSeq, (unsigned long)resolveCount);
+}
+
+uint32_t CardLogManager::getRecordCount() const
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    return countRecords();
+}
+
+uint32_t CardLogManager::countRecords() const
+{
+    uint32_t total = 0;
+    for (uint32_t index = firstSegment; index <= activeSegment; index++)
+    {
+        total += segmentRecords[index % CARD_LOG_MAX_SEGMENTS];
+    }
+    return total;
+}
+
+uint32_t CardLogManager::getUsedBytes() const
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    // Sealed segments are counted at their nominal size
+    return (activeSegment - firstSegment) * CARD_LOG_SEGMENT_SIZE + activeSize;
+}
+
+bool CardLogManager::isStaleSegment(const char *name) const
+{
+    const char *base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+
+    // Only "<epoch>_<index>.seg" and its ".idx" sidecar; anything else is left alone
+    unsigned long segEpoch = 0;
+    unsigned long index = 0;
+    int consumed = 0;
+    if (sscanf(base, "%lu_%lu%n", &segEpoch, &index, &consumed) != 2)
+    {
+        return false;
+    }
+    const char *suffix = base + consumed;
+    if (strcmp(suffix, ".seg") != 0 && strcmp(suffix, ".idx") != 0)
+    {
+        return false;
+    }
+    return segEpoch != epoch || index < firstSegment || index > activeSegment;
+}
+
+void CardLogManager::update()
+{
+    if (!gcPending)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    File dir = LittleFS.open(CARD_LOG_DIR);
+    if (!dir || !dir.isDirectory())
+    {
+        gcPending = false;
+        return;
+    }
+
+    char stalePath[48] = "";
+    File entry = dir.openNextFile();
+    while (entry)
+    {
+        if (isStaleSegment(entry.name()))
+        {
+            const char *base = strrchr(entry.name(), '/');
+            snprintf(stalePath, sizeof(stalePath), "%s/%s", CARD_LOG_DIR, base ? base + 1 : entry.name());
+            entry.close();
+            break;
+        }
+        entry.close();
+        entry = dir.openNextFile();
+    }
+    dir.close();
+
+    if (stalePath[0] == '\0')
+    {
+        gcPending = false;
+        return;
+    }
+
+    // One removal per call keeps each loop iteration short
+    LittleFS.remove(stalePath);
+}
+
+size_t CardLogManager::read(CardLogCursor &cursor, uint8_t *buffer, size_t maxLen)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    if (!cursor.started)
+    {
+        cursor.epoch = epoch;
+        cursor.segment = firstSegment;
+        cursor.offset = 0;
+        cursor.pendingLen = 0;
+        cursor.pendingPos = 0;
+        cursor.started = true;
+    }
+
+    // The log was wiped while streaming
+    if (cursor.epoch != epoch)
+    {
+        return 0;
+    }
+
+    // Segments were evicted underneath the reader - skip ahead
+    if (cursor.segment < firstSegment)
+    {
+        cursor.segment = firstSegment;
+        cursor.offset = 0;
+    }
+
+    size_t produced = 0;
+    File segment;
+    uint32_t openSegment = UINT32_MAX;
+    char path[48];
+    char jsonPayload[CARD_LOG_MAX_RECORD];
+    while (produced < maxLen)
+    {
+        // Drain the line carried over from the previous frame first
+        if (cursor.pendingPos < cursor.pendingLen)
+        {
+            size_t n = cursor.pendingLen - cursor.pendingPos;
+            if (n > maxLen - produced)
+            {
+                n = maxLen - produced;
+            }
+            memcpy(buffer + produced, cursor.pending + cursor.pendingPos, n);
+            cursor.pendingPos += n;
+            produced += n;
+            continue;
+        }
+
+        if (cursor.segment > activeSegment)
+        {
+            break;
+        }
+
+        if (openSegment != cursor.segment)
+        {
+            if (segment)
+            {
+                segment.close();
+            }
+            segmentPath(path, sizeof(path), epoch, cursor.segment);
+            segment = LittleFS.open(path, "r");
+            openSegment = cursor.segment;
+            if (segment && !segment.seek(cursor.offset))
+            {
+                segment.close();
+            }
+        }
+
+        CardLogFrameHeader header;
+        char *payload = (cursor.format == CARD_LOG_LINES_JSONL) ? jsonPayload : cursor.pending;
+        if (!segment || !readFrame(segment, header, payload))
+        {
+            // End of segment (or a damaged frame) - move on to the next one
+            cursor.segment++;
+            cursor.offset = 0;
+            continue;
+        }
+
+        cursor.offset += frameSize(header);
+        size_t lineLength = header.length;
+        if (cursor.format == CARD_LOG_LINES_JSONL)
+        {
+            int rendered = renderRecordJson(header.seq, header.timestamp, payload, header.length, cursor.pending,
+                                            sizeof(cursor.pending) - 1);
+            lineLength = (rendered >= (int)sizeof(cursor.pending) - 1) ? sizeof(cursor.pending) - 2 : rendered;
+        }
+        else if (ClockManager::isWallTime(header.timestamp))
+        {
+            time_t captured = header.timestamp;
+            struct tm utc;
+            gmtime_r(&captured, &utc);
+            lineLength += strftime(cursor.pending + lineLength, CARD_LOG_TIME_FIELD_SIZE - 1,
+                                   ", Timestamp: %Y-%m-%dT%H:%M:%SZ", &utc);
+        }
+        else if (header.timestamp != 0)
+        {
+            lineLength += snprintf(cursor.pending + lineLength, CARD_LOG_TIME_FIELD_SIZE - 1,
+                                   ", Timestamp: boot+%lus", (unsigned long)header.timestamp);
+        }
+        cursor.pending[lineLength] = '\n';
+        cursor.pendingLen = lineLength + 1;
+        cursor.pendingPos = 0;
+    }
+
+    if (segment)
+    {
+        segment.close();
+    }
+    return produced;
+}
+
+int CardLogManager::renderRecordJson(uint32_t seq, uint32_t timestamp, const char *payload, size_t length, char *out,
+                                     size_t outLen)
+{
+    size_t pos = 0;
+    auto put = [&](char c)
+    {
+        if (pos + 1 < outLen)
+        {
+            out[pos] = c;
+        }
+        pos++;
+    };
+
+    // Clients treat times below CLOCK_MIN_VALID_TIME as seconds since boot
+    pos = snprintf(out, outLen, "{\"seq\":%lu", (unsigned long)seq);
+    if (timestamp != 0)
+    {
+        pos += snprintf(out + pos, pos < outLen ? outLen - pos : 0, ",\"time\":%lu", (unsigned long)timestamp);
+    }
+
+    // Each field is "Key: Value", separated by ", "
+    size_t i = 0;
+    while (i < length)
+    {
+        size_t keyStart = i;
+        while (i < length && payload[i] != ':')
+        {
+            i++;
+        }
+        size_t keyEnd = i;
+        i = (i < length) ? i + 1 : i;
+        while (i < length && payload[i] == ' ')
+        {
+            i++;
+        }
+        size_t valueStart = i;
+        while (i < length && !(payload[i] == ',' && i + 1 < length && payload[i + 1] == ' '))
+        {
+            i++;
+        }
+        size_t valueEnd = i;
+        i = (i < length) ? i + 2 : i;
+
+        if (keyEnd == keyStart)
+        {
+            continue;
+        }
+
+        put(',');
+        put('"');
+        for (size_t k = keyStart; k < keyEnd; k++)
+        {
+            char c = payload[k];
+            if (isalnum((unsigned char)c) || c == '_')
+            {
+                put(c);
+            }
+        }
+        put('"');
+        put(':');
+        put('"');
+        for (size_t v = valueStart; v < valueEnd; v++)
+        {
+            char c = payload[v];
+            if (c == '"' || c == '\\')
+            {
+                put('\\');
+                put(c);
+            }
+            else if ((unsigned char)c >= 0x20)
+            {
+                put(c);
+            }
+        }
+        put('"');
+    }
+    put('}');
+
+    if (outLen > 0)
+    {
+        out[pos < outLen ? pos : outLen - 1] = '\0';
+    }
+    return (int)pos;
+}
+
+bool CardLogManager::openSegmentAt(File &segment, uint32_t &openSegment, uint32_t index, uint32_t position)
+{
+    if (openSegment != index)
+    {
+        if (segment)
+        {
+            segment.close();
+        }
+        char path[48];
+        segmentPath(path, sizeof(path), epoch, index);
+        segment = LittleFS.open(path, "r");
+        openSegment = index;
+    }
+    return segment && segment.seek(position);
+}
+
+void CardLogManager::startPage(CardPageCursor &cursor)
+{
+    cursor.started = true;
+    cursor.epoch = epoch;
+
+    uint32_t total = countRecords();
+    cursor.remaining = cursor.offset < total ? total - cursor.offset : 0;
+    if (cursor.remaining > cursor.limit)
+    {
+        cursor.remaining = cursor.limit;
+    }
+
+    // Skip whole segments using their record counts
+    uint32_t skip = cursor.offset;
+    if (cursor.filter.active)
+    {
+        // Filtered queries walk the segment indexes and continue by sequence number
+        if (cursor.hasSince)
+        {
+            cursor.order = CARD_PAGE_ASC;
+            cursor.filter.afterSeq = cursor.since;
+        }
+        cursor.segment = cursor.order == CARD_PAGE_ASC ? firstSegment : activeSegment;
+        cursor.inSegment = false;
+        cursor.remaining = cursor.limit;
+    }
+    else if (cursor.hasSince)
+    {
+        // Start in the newest segment whose first record could be newer than `since`
+        cursor.order = CARD_PAGE_ASC;
+        cursor.minSeq = cursor.since + 1;
+        cursor.segment = firstSegment;
+        while (cursor.segment < activeSegment &&
+               segmentBaseSeq[(cursor.segment + 1) % CARD_LOG_MAX_SEGMENTS] <= cursor.minSeq)
+        {
+            cursor.segment++;
+        }
+        cursor.fileOffset = 0;
+        cursor.skip = 0;
+        cursor.remaining = headSeq > cursor.since ? headSeq - cursor.since : 0;
+        if (cursor.remaining > cursor.limit)
+        {
+            cursor.remaining = cursor.limit;
+        }
+    }
+    else if (cursor.order == CARD_PAGE_ASC)
+    {
+        cursor.segment = firstSegment;
+        while (cursor.segment < activeSegment && skip >= segmentRecords[cursor.segment % CARD_LOG_MAX_SEGMENTS])
+        {
+            skip -= segmentRecords[cursor.segment % CARD_LOG_MAX_SEGMENTS];
+            cursor.segment++;
+        }
+        cursor.fileOffset = 0;
+        cursor.skip = skip;
+    }
+    else
+    {
+        cursor.segment = activeSegment;
+        while (cursor.segment > firstSegment && skip >= segmentRecords[cursor.segment % CARD_LOG_MAX_SEGMENTS])
+        {
+            skip -= segmentRecords[cursor.segment % CARD_LOG_MAX_SEGMENTS];
+            cursor.segment--;
+        }
+        cursor.nextIndex = (int32_t)segmentRecords[cursor.segment % CARD_LOG_MAX_SEGMENTS] - 1 - (int32_t)skip;
+        cursor.positionCount = 0;
+    }
+
+    if (cursor.filter.active)
+    {
+        cursor.pendingLen = snprintf(cursor.pending, sizeof(cursor.pending),
+                                     "{\"epoch\":%lu,\"head\":%lu,\"total\":%lu,\"limit\":%u,\"order\":\"%s\","
+                                     "\"filtered\":true,\"records\":[",
+                                     (unsigned long)epoch, (unsigned long)headSeq, (unsigned long)total,
+                                     cursor.limit, cursor.order == CARD_PAGE_ASC ? "asc" : "desc");
+    }
+    else if (cursor.hasSince)
+    {
+        cursor.pendingLen = snprintf(cursor.pending, sizeof(cursor.pending),
+                                     "{\"epoch\":%lu,\"head\":%lu,\"total\":%lu,\"since\":%lu,\"limit\":%u,"
+                                     "\"order\":\"asc\",\"records\":[",
+                                     (unsigned long)epoch, (unsigned long)headSeq, (unsigned long)total,
+                                     (unsigned long)cursor.since, cursor.limit);
+    }
+    else
+    {
+        cursor.pendingLen = snprintf(cursor.pending, sizeof(cursor.pending),
+                                     "{\"epoch\":%lu,\"head\":%lu,\"total\":%lu,\"offset\":%lu,\"limit\":%u,"
+                                     "\"order\":\"%s\",\"records\":[",
+                                     (unsigned long)epoch, (unsigned long)headSeq, (unsigned long)total,
+                                     (unsigned long)cursor.offset, cursor.limit,
+                                     cursor.order == CARD_PAGE_ASC ? "asc" : "desc");
+    }
+    cursor.pendingPos = 0;
+}
+
+bool CardLogManager::nextPageRecord(CardPageCursor &cursor, File &segment, uint32_t &openSegment,
+                                    CardLogFrameHeader &header, char *payload)
+{
+    if (cursor.remaining == 0 || cursor.epoch != epoch || cursor.segment < firstSegment)
+    {
+        return false;
+    }
+
+    if (cursor.order == CARD_PAGE_ASC)
+    {
+        while (cursor.segment <= activeSegment)
+        {
+            if (openSegmentAt(segment, openSegment, cursor.segment, cursor.fileOffset))
+            {
+                // Step over frames by header only until the requested offset
+                while (cursor.skip > 0 && readFrameHeader(segment, header) &&
+                       segment.seek(cursor.fileOffset + frameSize(header)))
+                {
+                    cursor.fileOffset += frameSize(header);
+                    cursor.skip--;
+                }
+
+                while (cursor.skip == 0 && readFrame(segment, header, payload))
+                {
+                    cursor.fileOffset += frameSize(header);
+                    if (header.seq >= cursor.minSeq)
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            cursor.segment++;
+            cursor.fileOffset = 0;
+            cursor.skip = 0;
+        }
+        return false;
+    }
+
+    // Newest first: frames can only be walked forwards, so collect the
+    // positions of the next window of this segment and hand them out in reverse
+    while (cursor.positionCount == 0)
+    {
+        if (cursor.nextIndex < 0)
+        {
+            if (cursor.segment <= firstSegment)
+            {
+                return false;
+            }
+            cursor.segment--;
+            cursor.nextIndex = (int32_t)segmentRecords[cursor.segment % CARD_LOG_MAX_SEGMENTS] - 1;
+            continue;
+        }
+
+        int32_t high = cursor.nextIndex;
+        int32_t low = high - (int32_t)cursor.remaining + 1;
+        if (low < 0)
+        {
+            low = 0;
+        }
+        cursor.nextIndex = low - 1;
+
+        if (!openSegmentAt(segment, openSegment, cursor.segment, 0))
+        {
+            continue;
+        }
+
+        uint32_t position = 0;
+        for (int32_t index = 0; index <= high; index++)
+        {
+            if (!readFrameHeader(segment, header) || !segment.seek(position + frameSize(header)))
+            {
+                break;
+            }
+            if (index >= low)
+            {
+                cursor.positions[cursor.positionCount++] = (uint16_t)position;
+            }
+            position += frameSize(header);
+        }
+    }
+
+    uint16_t position = cursor.positions[--cursor.positionCount];
+    return openSegmentAt(segment, openSegment, cursor.segment, position) && readFrame(segment, header, payload);
+}
+
+bool CardLogManager::segmentMayMatch(uint32_t index, const CardLogFilter &filter) const
+{
+    uint32_t slot = index % CARD_LOG_MAX_SEGMENTS;
+    if (segmentRecords[slot] == 0)
+    {
+        return false;
+    }
+
+    // Sequence range of the segment against the continuation bounds
+    uint32_t lastSeq = index < activeSegment ? segmentBaseSeq[(index + 1) % CARD_LOG_MAX_SEGMENTS] - 1 : headSeq;
+    if (filter.afterSeq && lastSeq <= filter.afterSeq)
+    {
+        return false;
+    }
+    if (filter.beforeSeq && segmentBaseSeq[slot] >= filter.beforeSeq)
+    {
+        return false;
+    }
+    return cardIndexSummaryMayMatch(segmentSummary[slot], filter);
+}
+
+bool CardLogManager::nextFilteredRecord(CardPageCursor &cursor, File &segment, uint32_t &openSegment,
+                                        File &indexFile, uint32_t &openIndex, CardLogFrameHeader &header,
+                                        char *payload)
+{
+    if (cursor.remaining == 0 || cursor.epoch != epoch)
+    {
+        return false;
+    }
+
+    bool ascending = cursor.order == CARD_PAGE_ASC;
+    while (cursor.segment >= firstSegment && cursor.segment <= activeSegment)
+    {
+        if (cursor.inSegment || segmentMayMatch(cursor.segment, cursor.filter))
+        {
+            if (openIndex != cursor.segment)
+            {
+                if (indexFile)
+                {
+                    indexFile.close();
+                }
+                char path[48];
+                indexPath(path, sizeof(path), epoch, cursor.segment);
+                indexFile = LittleFS.open(path, "r");
+                openIndex = cursor.segment;
+            }
+
+            uint32_t entries = indexFile ? indexFile.size() / sizeof(CardIndexEntry) : 0;
+            if (!cursor.inSegment)
+            {
+                cursor.inSegment = true;
+                cursor.segmentsScanned++;
+                cursor.entryIndex = ascending ? 0 : entries;
+            }
+
+            CardIndexEntry entry;
+            while (ascending ? cursor.entryIndex < entries : cursor.entryIndex > 0)
+            {
+                uint32_t position = ascending ? cursor.entryIndex++ : --cursor.entryIndex;
+                if (!indexFile.seek(position * sizeof(entry)) ||
+                    indexFile.read((uint8_t *)&entry, sizeof(entry)) != sizeof(entry))
+                {
+                    break;
+                }
+                if (cardIndexEntryMatches(entry, cursor.filter) &&
+                    openSegmentAt(segment, openSegment, cursor.segment, entry.offset) &&
+                    readFrame(segment, header, payload) && header.seq == entry.seq)
+                {
+                    return true;
+                }
+            }
+        }
+
+        cursor.inSegment = false;
+        if (ascending)
+        {
+            cursor.segment++;
+        }
+        else if (cursor.segment-- == 0)
+        {
+            break;
+        }
+    }
+    return false;
+}
+
+size_t CardLogManager::readPage(CardPageCursor &cursor, uint8_t *buffer, size_t maxLen)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    if (!cursor.started)
+    {
+        startPage(cursor);
+    }
+
+    size_t produced = 0;
+    File segment;
+    File indexFile;
+    uint32_t openSegment = UINT32_MAX;
+    uint32_t openIndex = UINT32_MAX;
+    char payload[CARD_LOG_MAX_RECORD];
+    while (produced < maxLen)
+    {
+        if (cursor.pendingPos < cursor.pendingLen)
+        {
+            size_t n = cursor.pendingLen - cursor.pendingPos;
+            if (n > maxLen - produced)
+            {
+                n = maxLen - produced;
+            }
+            memcpy(buffer + produced, cursor.pending + cursor.pendingPos, n);
+            cursor.pendingPos += n;
+            produced += n;
+            continue;
+        }
+
+        if (cursor.finished)
+        {
+            break;
+        }
+
+        CardLogFrameHeader header;
+        int length;
+        bool found = cursor.filter.active
+                         ? nextFilteredRecord(cursor, segment, openSegment, indexFile, openIndex, header, payload)
+                         : nextPageRecord(cursor, segment, openSegment, header, payload);
+        if (found)
+        {
+            char *out = cursor.pending;
+            size_t outLen = sizeof(cursor.pending);
+            if (cursor.emitted > 0)
+            {
+                *out++ = ',';
+                outLen--;
+            }
+            length = renderRecordJson(header.seq, header.timestamp, payload, header.length, out, outLen);
+            if (length >= (int)outLen)
+            {
+                length = outLen - 1;
+            }
+            length += (cursor.emitted > 0) ? 1 : 0;
+            cursor.emitted++;
+            cursor.remaining--;
+            cursor.lastSeq = header.seq;
+        }
+        else if (cursor.filter.active)
+        {
+            // A full page may have more matches: continue from the last one returned
+            length = snprintf(cursor.pending, sizeof(cursor.pending),
+                              "],\"returned\":%u,\"segments_scanned\":%u,\"next\":%lu}", cursor.emitted,
+                              cursor.segmentsScanned, (unsigned long)(cursor.remaining == 0 ? cursor.lastSeq : 0));
+            cursor.finished = true;
+        }
+        else
+        {
+            // Also reached when the log is wiped or evicted mid-page
+            length = snprintf(cursor.pending, sizeof(cursor.pending), "],\"returned\":%u}", cursor.emitted);
+            cursor.finished = true;
+        }
+
+        cursor.pendingLen = length;
+        cursor.pendingPos = 0;
+    }
+
+    if (segment)
+    {
+        segment.close();
+    }
+    if (indexFile)
+    {
+        indexFile.close();
+    }
+    return produced;
+}
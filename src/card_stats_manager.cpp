@@ -0,0 +1,224 @@
+#include "card_stats_manager.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <algorithm>
+#include "card_log_index.h"
+#include "clock_manager.h"
+#include "crc32.h"
+#include "credential_index.h"
+#include "storage_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_STATS
+
+CardStatsManager &cardStatsManager = CardStatsManager::getInstance();
+
+static_assert(CARD_STATS_FORMATS >= 32, "Every card log format ID needs a counter");
+
+CardStatsManager::CardStatsManager() : counters{}, version(1), savedVersion(1), lastSave(0)
+{
+}
+
+CardStatsManager &CardStatsManager::getInstance()
+{
+    static CardStatsManager instance;
+    return instance;
+}
+
+void CardStatsManager::begin()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+
+    load();
+    LOG_I("[STATS] %lu read(s) counted, %lu bad, %lu facility code(s)", (unsigned long)counters.total,
+          (unsigned long)counters.badReads, (unsigned long)counters.facilityCount);
+}
+
+void CardStatsManager::recordRead(CardProcessor &cardProcessor)
+{
+    String format = cardProcessor.getCardFormat();
+    uint8_t formatId = cardIndexFormatId(format.c_str(), format.length());
+    unsigned int bits = cardProcessor.getBitCount();
+    unsigned long facilityCode = cardProcessor.getFacilityCode();
+    uint32_t now = clockManager.now();
+
+    bool bad = formatId == CARD_INDEX_FORMAT_OTHER || format == "Unknown";
+    // Same cases the card log records with "Facility_Code: N/A"
+    bool hasFacilityCode = !bad && !cardProcessor.isNet2Card() && !cardProcessor.isKeypadPress() && bits != 4 &&
+                           !(bits == 32 && facilityCode >= 512);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+
+    if (counters.total == 0)
+    {
+        counters.since = now;
+    }
+    counters.total++;
+    counters.byFormat[formatId]++;
+    if (bad)
+    {
+        counters.badReads++;
+    }
+
+    if (ClockManager::isWallTime(now))
+    {
+        time_t captured = now;
+        struct tm utc;
+        gmtime_r(&captured, &utc);
+        counters.byHour[utc.tm_hour]++;
+    }
+    else
+    {
+        counters.hourUnknown++;
+    }
+
+    if (hasFacilityCode)
+    {
+        uint32_t i = 0;
+        while (i < counters.facilityCount && counters.facilities[i].facilityCode != facilityCode)
+        {
+            i++;
+        }
+        if (i < counters.facilityCount)
+        {
+            counters.facilities[i].count++;
+        }
+        else if (counters.facilityCount < CARD_STATS_FACILITY_CODES)
+        {
+            counters.facilities[i].facilityCode = facilityCode;
+            counters.facilities[i].count = 1;
+            counters.facilityCount++;
+        }
+        else
+        {
+            counters.facilityOther++;
+        }
+    }
+
+    version++;
+}
+
+void CardStatsManager::clear()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+
+    memset(&counters, 0, sizeof(counters));
+    version++;
+    storageManager.removeFile(CARD_STATS_FILE);
+}
+
+void CardStatsManager::update()
+{
+    if (version == savedVersion || millis() - lastSave < CARD_STATS_SAVE_INTERVAL_MS)
+    {
+        return;
+    }
+    save();
+}
+
+void CardStatsManager::load()
+{
+    File file = LittleFS.open(CARD_STATS_FILE, "r");
+    if (!file)
+    {
+        return;
+    }
+
+    StatsFileHeader header;
+    CardStatsCounters loaded;
+    bool valid = file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                 header.version == CARD_STATS_VERSION && header.length == sizeof(loaded) &&
+                 file.read((uint8_t *)&loaded, sizeof(loaded)) == sizeof(loaded) &&
+                 crc32Update(0, &loaded, sizeof(loaded)) == header.crc &&
+                 loaded.facilityCount <= CARD_STATS_FACILITY_CODES;
+    file.close();
+
+    if (!valid)
+    {
+        LOG_W("[STATS] Saved statistics are damaged or from another version - starting over");
+        return;
+    }
+    counters = loaded;
+}
+
+void CardStatsManager::save()
+{
+    // Runs on the storage task; copy under the lock and write without it
+    static CardStatsCounters snapshot;
+    StatsFileHeader header;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        snapshot = counters;
+        savedVersion = version;
+    }
+    lastSave = millis();
+
+    header.version = CARD_STATS_VERSION;
+    header.length = sizeof(snapshot);
+    header.crc = crc32Update(0, &snapshot, sizeof(snapshot));
+
+    File file = LittleFS.open(CARD_STATS_TMP_FILE, "w");
+    if (!file)
+    {
+        LOG_E("[STATS] Failed to open statistics file");
+        return;
+    }
+    bool written = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                   file.write((const uint8_t *)&snapshot, sizeof(snapshot)) == sizeof(snapshot);
+    file.close();
+
+    if (!written || !LittleFS.rename(CARD_STATS_TMP_FILE, CARD_STATS_FILE))
+    {
+        LittleFS.remove(CARD_STATS_TMP_FILE);
+        LOG_E("[STATS] Failed to save statistics");
+    }
+}
+
+void CardStatsManager::writeJson(Print &out)
+{
+    static CardStatsFacility facilities[CARD_STATS_FACILITY_CODES];
+    JsonDocument doc;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+
+        doc["total"] = counters.total;
+        doc["bad_reads"] = counters.badReads;
+        doc["since"] = counters.since;
+
+        JsonObject formats = doc["formats"].to<JsonObject>();
+        for (uint8_t id = 0; id < CARD_STATS_FORMATS; id++)
+        {
+            if (counters.byFormat[id] > 0)
+            {
+                formats[cardIndexFormatName(id)] = counters.byFormat[id];
+            }
+        }
+
+        JsonArray hours = doc["hours_utc"].to<JsonArray>();
+        for (uint8_t hour = 0; hour < 24; hour++)
+        {
+            hours.add(counters.byHour[hour]);
+        }
+        doc["hours_unknown"] = counters.hourUnknown;
+
+        // Most frequent facility codes first
+        uint32_t facilityCount = counters.facilityCount;
+        memcpy(facilities, counters.facilities, facilityCount * sizeof(CardStatsFacility));
+        std::sort(facilities, facilities + facilityCount, [](const CardStatsFacility &a, const CardStatsFacility &b)
+                  { return a.count > b.count || (a.count == b.count && a.facilityCode < b.facilityCode); });
+        JsonArray codes = doc["facility_codes"].to<JsonArray>();
+        for (uint32_t i = 0; i < facilityCount; i++)
+        {
+            JsonObject code = codes.add<JsonObject>();
+            code["fc"] = facilities[i].facilityCode;
+            code["count"] = facilities[i].count;
+        }
+        doc["facility_codes_other"] = counters.facilityOther;
+    }
+
+    // Distinct credentials come from the de-duplication index
+    doc["unique"] = credentialIndex.getCount();
+    doc["unique_capped"] = credentialIndex.getCount() >= CREDENTIAL_INDEX_MAX_ENTRIES;
+
+    serializeJson(doc, out);
+}
@@ -0,0 +1,221 @@
+#include "card_stream.h"
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include "clock_manager.h"
+#include "websocket_protocol.h"
+
+CardStream &cardStream = CardStream::getInstance();
+
+static_assert((CARD_STREAM_HISTORY & (CARD_STREAM_HISTORY - 1)) == 0,
+              "CARD_STREAM_HISTORY must be a power of two");
+
+CardStream::CardStream() : head(0), activeCount(0), stats{}
+{
+    for (uint8_t i = 0; i < CARD_STREAM_MAX_CLIENTS; i++)
+    {
+        subscribers[i].active = false;
+    }
+}
+
+CardStream &CardStream::getInstance()
+{
+    static CardStream instance;
+    return instance;
+}
+
+void CardStream::publish(uint32_t seq, uint32_t timestamp, const char *record, size_t length)
+{
+    if (activeCount == 0)
+    {
+        return;
+    }
+
+    Event event;
+    event.logged = true;
+    event.seq = seq;
+    event.timestamp = timestamp;
+    event.captureUs = (uint32_t)esp_timer_get_time();
+    event.length = length < sizeof(event.text) ? length : sizeof(event.text);
+    memcpy(event.text, record, event.length);
+    append(event);
+}
+
+void CardStream::publishRepeat()
+{
+    if (activeCount == 0)
+    {
+        return;
+    }
+
+    Event event;
+    event.logged = false;
+    event.seq = 0;
+    event.timestamp = 0;
+    event.captureUs = (uint32_t)esp_timer_get_time();
+    event.length = 0;
+    append(event);
+}
+
+void CardStream::append(const Event &event)
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    history[head & (CARD_STREAM_HISTORY - 1)] = event;
+    head++;
+    stats.published++;
+}
+
+bool CardStream::subscribe(uint32_t client)
+{
+    Subscriber *slot = nullptr;
+    for (uint8_t i = 0; i < CARD_STREAM_MAX_CLIENTS; i++)
+    {
+        if (subscribers[i].active && subscribers[i].client == client)
+        {
+            return true;
+        }
+        if (!subscribers[i].active && !slot)
+        {
+            slot = &subscribers[i];
+        }
+    }
+    if (!slot)
+    {
+        return false;
+    }
+
+    // Earlier reads come from /api/cards; only new ones are pushed
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        slot->nextEvent = head;
+    }
+    slot->active = true;
+    slot->client = client;
+    slot->skipped = 0;
+    activeCount++;
+    return true;
+}
+
+void CardStream::unsubscribe(uint32_t client)
+{
+    for (uint8_t i = 0; i < CARD_STREAM_MAX_CLIENTS; i++)
+    {
+        if (subscribers[i].active && subscribers[i].client == client)
+        {
+            subscribers[i].active = false;
+            activeCount--;
+            return;
+        }
+    }
+}
+
+void CardStream::update()
+{
+    if (activeCount == 0)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < CARD_STREAM_MAX_CLIENTS; i++)
+    {
+        if (!subscribers[i].active)
+        {
+            continue;
+        }
+        // Covers a disconnect that never reached the event queue
+        if (!webSocketProtocol.isConnected(subscribers[i].client))
+        {
+            unsubscribe(subscribers[i].client);
+            continue;
+        }
+        send(subscribers[i]);
+    }
+}
+
+void CardStream::send(Subscriber &subscriber)
+{
+    uint8_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        uint32_t oldest = head > CARD_STREAM_HISTORY ? head - CARD_STREAM_HISTORY : 0;
+        if (subscriber.nextEvent < oldest)
+        {
+            // Overwritten before this client could take them
+            subscriber.skipped += oldest - subscriber.nextEvent;
+            stats.skipped += oldest - subscriber.nextEvent;
+            subscriber.nextEvent = oldest;
+        }
+
+        while (subscriber.nextEvent < head && count < CARD_STREAM_BATCH)
+        {
+            outbox[count++] = history[subscriber.nextEvent & (CARD_STREAM_HISTORY - 1)];
+            subscriber.nextEvent++;
+        }
+    }
+
+    if (count == 0 && subscriber.skipped == 0)
+    {
+        return;
+    }
+
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint32_t latencyUs = 0;
+    uint8_t repeats = 0;
+    JsonDocument doc;
+    doc["source"] = "live";
+    doc["epoch"] = cardLogManager.getEpoch(); // Changes when the log is wiped
+    JsonArray records = doc["records"].to<JsonArray>();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const Event &event = outbox[i];
+        latencyUs = now - event.captureUs;
+        if (!event.logged)
+        {
+            repeats++;
+            continue;
+        }
+
+        // Same object as /api/cards, with the capture-to-send time added;
+        // parsed back so it encodes as MessagePack too. A read captured
+        // before the clock was set is sent with the time it is stored with.
+        char rendered[CARD_PAGE_RENDER_SIZE];
+        int length = CardLogManager::renderRecordJson(event.seq, clockManager.toWallTime(event.timestamp), event.text,
+                                                      event.length, rendered, sizeof(rendered));
+        JsonDocument record;
+        if (length <= 0 || length >= (int)sizeof(rendered) || deserializeJson(record, rendered, length))
+        {
+            continue;
+        }
+        record["age_us"] = latencyUs;
+        records.add(record);
+    }
+    if (repeats > 0)
+    {
+        doc["repeats"] = repeats;
+    }
+    if (subscriber.skipped > 0)
+    {
+        doc["skipped"] = subscriber.skipped;
+    }
+
+    if (webSocketProtocol.send(subscriber.client, doc))
+    {
+        subscriber.skipped = 0;
+        if (count > 0)
+        {
+            std::lock_guard<std::mutex> lock(historyMutex);
+            stats.lastLatencyUs = latencyUs;
+            stats.maxLatencyUs = latencyUs > stats.maxLatencyUs ? latencyUs : stats.maxLatencyUs;
+        }
+    }
+    else
+    {
+        subscriber.skipped += count;
+    }
+}
+
+CardStreamStats CardStream::getStats()
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    CardStreamStats result = stats;
+    result.subscribers = activeCount;
+    return result;
+}
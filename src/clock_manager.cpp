@@ -0,0 +1,160 @@
+#include "clock_manager.h"
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include "boot_profiler.h"
+#include "card_log_manager.h"
+#include "credential_index.h"
+#include "storage_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_CLOCK
+
+ClockManager &clockManager = ClockManager::getInstance();
+
+ClockManager::ClockManager() : wallOffset(0), resolvePending(false), stats{}, lastSyncMonoUs(0), lastSyncWallUs(0)
+{
+}
+
+ClockManager &ClockManager::getInstance()
+{
+    static ClockManager instance;
+    return instance;
+}
+
+void ClockManager::begin()
+{
+    sntp_set_time_sync_notification_cb(sntpSyncCallback);
+
+    // The clock survives a software reset
+    if (isWallTime((uint32_t)time(nullptr)))
+    {
+        onSynced("RTC");
+    }
+}
+
+void ClockManager::startSync()
+{
+    LOG_SEPARATOR();
+    LOG_I("[TIME] Starting background SNTP sync (UTC, every %lu s)",
+          (unsigned long)(CLOCK_SYNC_INTERVAL_MS / 1000));
+    bootProfiler.start(BOOT_PHASE_NTP);
+    sntp_set_sync_interval(CLOCK_SYNC_INTERVAL_MS);
+    configTime(0, 0, CLOCK_NTP_SERVER_1, CLOCK_NTP_SERVER_2);
+}
+
+ClockSyncStats ClockManager::getSyncStats() const
+{
+    std::lock_guard<std::mutex> lock(syncMutex);
+    return stats;
+}
+
+uint32_t ClockManager::secondsSinceBoot()
+{
+    uint32_t seconds = (uint32_t)(esp_timer_get_time() / 1000000);
+    return seconds > 0 ? seconds : 1;
+}
+
+uint32_t ClockManager::now() const
+{
+    uint32_t wall = (uint32_t)time(nullptr);
+    return isWallTime(wall) ? wall : secondsSinceBoot();
+}
+
+void ClockManager::setFromBrowser(uint32_t epochSeconds)
+{
+    if (isSynced() || !isWallTime(epochSeconds))
+    {
+        return;
+    }
+
+    struct timeval tv = {(time_t)epochSeconds, 0};
+    settimeofday(&tv, nullptr);
+    onSynced("browser");
+}
+
+void ClockManager::sntpSyncCallback(struct timeval *tv)
+{
+    clockManager.onSntpSync(tv);
+    clockManager.onSynced("SNTP");
+}
+
+void ClockManager::onSntpSync(const struct timeval *tv)
+{
+    // Runs on the lwIP task right after SNTP set the clock
+    int64_t monoUs = esp_timer_get_time();
+    int64_t wallUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+
+    std::lock_guard<std::mutex> lock(syncMutex);
+    if (stats.syncCount == 0)
+    {
+        bootProfiler.end(BOOT_PHASE_NTP);
+    }
+    else
+    {
+        // Since the last sync the clock ran on the local oscillator alone
+        int64_t elapsedUs = monoUs - lastSyncMonoUs;
+        int64_t offsetUs = wallUs - (lastSyncWallUs + elapsedUs);
+        stats.lastOffsetMs = (int32_t)(offsetUs / 1000);
+        stats.driftPpm = elapsedUs > 0 ? (int32_t)(offsetUs * 1000000 / elapsedUs) : 0;
+        stats.hasDrift = true;
+        LOG_I("[TIME] SNTP re-sync corrected the clock by %ld ms (%ld ppm)", (long)stats.lastOffsetMs,
+              (long)stats.driftPpm);
+    }
+    stats.syncCount++;
+    stats.lastSync = (uint32_t)tv->tv_sec;
+    lastSyncMonoUs = monoUs;
+    lastSyncWallUs = wallUs;
+}
+
+void ClockManager::onSynced(const char *source)
+{
+    uint32_t wall = (uint32_t)time(nullptr);
+    if (wallOffset != 0 || !isWallTime(wall))
+    {
+        return;
+    }
+
+    // Later SNTP corrections are small; records keep the first offset
+    uint32_t offset = wall - secondsSinceBoot();
+    wallOffset = offset;
+    {
+        std::lock_guard<std::mutex> lock(syncMutex);
+        stats.source = source;
+    }
+
+    char timeStr[26];
+    time_t wallTime = wall;
+    ctime_r(&wallTime, timeStr);
+    timeStr[24] = '\0'; // Remove the newline
+    LOG_SEPARATOR();
+    LOG_I("[TIME] Clock set from %s to %s UTC - resolving earlier card records", source, timeStr);
+
+    // Runs after every record already queued, so they are all on flash
+    if (!storageManager.run(resolveJob, &offset, sizeof(offset)))
+    {
+        LOG_W("[TIME] Storage queue full - resolving records once it drains");
+        resolvePending = true;
+    }
+}
+
+void ClockManager::update()
+{
+    if (!resolvePending)
+    {
+        return;
+    }
+
+    // The queue is empty here, so every earlier record is already on flash
+    resolvePending = false;
+    cardLogManager.resolveBootTimes(wallOffset);
+    credentialIndex.resolveBootTimes(wallOffset);
+}
+
+void ClockManager::resolveJob(const uint8_t *data, size_t length)
+{
+    uint32_t offset;
+    memcpy(&offset, data, sizeof(offset));
+    cardLogManager.resolveBootTimes(offset);
+    credentialIndex.resolveBootTimes(offset);
+}
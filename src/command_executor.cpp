@@ -0,0 +1,461 @@
+#include "command_executor.h"
+#include "card_stats_manager.h"
+#include "console_log.h"
+#include "credential_index.h"
+#include "debug_manager.h"
+#include "email_manager.h"
+#include "gpio_manager.h"
+#include "reader_manager.h"
+#include "reset_card_manager.h"
+#include "storage_manager.h"
+#include "websocket_protocol.h"
+#include "wifi_setup_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_COMMAND
+
+extern ReaderManager &readerManager;
+extern WiFiSetupManager &wifiSetupManager;
+extern EmailManager emailManager;
+extern ResetCardManager resetCardManager;
+extern DebugManager debugManager;
+
+// Indexed by CommandType
+static const char *const COMMAND_NAMES[] = {
+    "debug",
+    "reader_type",
+    "gpio",
+    "card_log_capacity",
+    "credential_options",
+    "reset_gpio",
+    "wipe_cards",
+    "restore_notifications",
+    "reset_card_defaults",
+    "wipe_wifi",
+    "factory_reset",
+    "notifications",
+    "reset_card",
+    "paxton_reset_card",
+};
+
+static_assert(sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]) == COMMAND_TYPE_COUNT, "One name per command");
+
+CommandExecutor &commandExecutor = CommandExecutor::getInstance();
+
+// Card log changes run on the storage task, after any records already queued
+static void wipeCardLogJob(const uint8_t *data, size_t length)
+{
+    cardLogManager.wipe();
+}
+
+static void setCardLogCapacityJob(const uint8_t *data, size_t length)
+{
+    CardLogCapacityCommand request;
+    memcpy(&request, data, sizeof(request));
+    cardLogManager.setCapacity(request.maxBytes, request.policy);
+}
+
+static void clearCardData()
+{
+    storageManager.run(wipeCardLogJob);
+    credentialIndex.clear();
+    cardStatsManager.clear();
+}
+
+CommandExecutor::CommandExecutor()
+    : queue(nullptr), commandTaskHandle(nullptr), restartTimer(nullptr), restartRequestedAt(0), nextId(1),
+      executed(0), failed(0), dropped(0), lastDurationUs(0), maxDurationUs(0)
+{
+}
+
+CommandExecutor &CommandExecutor::getInstance()
+{
+    static CommandExecutor instance;
+    return instance;
+}
+
+const char *CommandExecutor::commandName(CommandType type)
+{
+    return type < COMMAND_TYPE_COUNT ? COMMAND_NAMES[type] : "unknown";
+}
+
+void CommandExecutor::begin()
+{
+    if (queue)
+    {
+        return;
+    }
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = restartTimerCallback;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "CommandRestart";
+    esp_timer_create(&timerArgs, &restartTimer);
+
+    queue = xQueueCreateStatic(COMMAND_QUEUE_LENGTH, sizeof(Command), queueStorage, &queueControl);
+    if (!queue)
+    {
+        LOG_E("[COMMAND] Failed to create the command queue - executing inline");
+        return;
+    }
+
+    xTaskCreatePinnedToCore(
+        commandTaskFunction,
+        "CommandTask",
+        COMMAND_TASK_STACK,
+        this,
+        COMMAND_TASK_PRIORITY,
+        &commandTaskHandle,
+        COMMAND_TASK_CORE);
+}
+
+uint32_t CommandExecutor::submit(Command &command)
+{
+    command.id = nextId++;
+    if (nextId == 0)
+    {
+        nextId = 1;
+    }
+
+    // Before begin() there is no task to hand the work to
+    if (!queue)
+    {
+        JsonDocument response;
+        complete(command, execute(command, response), response);
+        return command.id;
+    }
+
+    JsonDocument ack;
+    ack["source"] = "command";
+    ack["command"] = commandName(command.type);
+
+    if (xQueueSend(queue, &command, 0) != pdTRUE)
+    {
+        dropped++;
+        LOG_W("[COMMAND] Queue full; refused %s from client %lu", commandName(command.type),
+              (unsigned long)command.client);
+        ack["state"] = "refused";
+        ack["status"] = "error";
+        ack["message"] = "The device is busy; try again";
+        webSocketProtocol.send(command.client, ack);
+        return 0;
+    }
+
+    LOG_D("[COMMAND] Queued #%lu %s", (unsigned long)command.id, commandName(command.type));
+    ack["id"] = command.id;
+    ack["state"] = "queued";
+    webSocketProtocol.send(command.client, ack);
+    return command.id;
+}
+
+bool CommandExecutor::execute(const Command &command, JsonDocument &response)
+{
+    switch (command.type)
+    {
+    case COMMAND_DEBUG:
+    {
+        // Debug state changes apply without a restart
+        bool saved = true;
+        if (command.debug.setEnabled)
+        {
+            saved = debugManager.updateDebugState(command.debug.enabled);
+        }
+        saved = debugManager.updateLogLevel(command.debug.logLevel) && saved;
+
+        if (!saved)
+        {
+            LOG_E("[DEBUG] Failed to update debug settings");
+            response["status"] = "error";
+            response["message"] = "Failed to update debug settings";
+            return false;
+        }
+        LOG_D("[DEBUG] Debug settings updated successfully");
+        response["status"] = "success";
+        response["debug"] = debugManager.isDebugEnabled();
+        response["log_level"] = consoleLogLevelName(debugManager.getLogLevel());
+        return true;
+    }
+
+    case COMMAND_READER_TYPE:
+    {
+        const char *name = command.readerType == READER_PAXTON ? "PAXTON" : "HID";
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Changing reader type to: %s", name);
+
+        readerManager.switchMode((ReaderType)command.readerType);
+
+        LOG_I("[WEBSOCKET] Reader configuration updated successfully.");
+        response["status"] = "success";
+        response["reader_type"] = name;
+        return true;
+    }
+
+    case COMMAND_GPIO:
+    {
+        // One commit for all four settings; GPIOManager applies it
+        DeviceConfig config = configManager.get();
+        config.gpio = command.gpio;
+        configManager.commit(config, CONFIG_GPIO);
+
+        response["status"] = "success";
+        return true;
+    }
+
+    case COMMAND_CARD_LOG_CAPACITY:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Setting card log capacity to %lu KB (%s when full)",
+              (unsigned long)(command.cardLog.maxBytes / 1024),
+              command.cardLog.policy == CARD_LOG_STOP_WHEN_FULL ? "stop" : "evict oldest");
+
+        response["source"] = "card_log";
+        if (!storageManager.run(setCardLogCapacityJob, &command.cardLog, sizeof(command.cardLog)))
+        {
+            response["status"] = "error";
+            response["message"] = "Storage queue is full";
+            return false;
+        }
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_CREDENTIAL_OPTIONS:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Setting credential re-notify window to %lu min (repeats %s)",
+              (unsigned long)(command.credentials.renotifySeconds / 60),
+              command.credentials.logRepeats ? "logged" : "counted only");
+
+        credentialIndex.setOptions(command.credentials.renotifySeconds, command.credentials.logRepeats);
+
+        response["source"] = "card_log";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_RESET_GPIO:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Resetting GPIO settings to factory defaults...");
+        GPIOManager::getInstance().resetToDefaults();
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] GPIO settings have been restored to factory defaults.");
+
+        response["source"] = "gpio";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_WIPE_CARDS:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Clearing stored cards from the device...");
+        clearCardData();
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Stored card data has been cleared.");
+
+        response["source"] = "cards";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_RESTORE_NOTIFICATIONS:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Restoring notification configuration to factory defaults...");
+        configManager.restoreDefaults(CONFIG_NOTIFICATIONS);
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Notification preferences have been restored to defaults.");
+        emailManager.readConfig();
+
+        response["source"] = "notifications";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_RESET_CARD_DEFAULTS:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Restoring the Reset Card to the default values...");
+        resetCardManager.setDefaultResetCard();
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Reset Card default values have been restored.");
+
+        response["source"] = "reset_card";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_WIPE_WIFI:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Removing stored wireless credentials...");
+        wifiSetupManager.clearStoredWiFi();
+        scheduleRestart();
+
+        response["source"] = "wireless";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_FACTORY_RESET:
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Restoring factory defaults...");
+
+        clearCardData();
+        LOG_I("[WEBSOCKET] Stored card data has been cleared.");
+
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Resetting notification settings to factory defaults...");
+        configManager.restoreDefaults(CONFIG_NOTIFICATIONS);
+        emailManager.readConfig();
+        LOG_I("[WEBSOCKET] Notification settings have been restored.");
+
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Resetting GPIO settings to factory defaults...");
+        GPIOManager::getInstance().resetToDefaults();
+        LOG_I("[WEBSOCKET] GPIO settings have been restored to factory defaults.");
+
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Restoring the Reset Card to default values...");
+        resetCardManager.setDefaultResetCard();
+        LOG_I("[WEBSOCKET] Reset Card default values have been restored.");
+
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Removing stored WiFi credentials...");
+        wifiSetupManager.clearStoredWiFi();
+
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Reset device to factory defaults. Restarting the device.");
+        scheduleRestart();
+
+        response["source"] = "system";
+        response["status"] = "success";
+        return true;
+
+    case COMMAND_NOTIFICATIONS:
+    {
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Saving notification configuration...");
+
+        DeviceConfig config = configManager.get();
+        config.notifications = command.notifications;
+        configManager.commit(config, CONFIG_NOTIFICATIONS);
+
+        response["status"] = "success";
+        return true;
+    }
+
+    case COMMAND_RESET_CARD:
+    {
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Updating Reset Card...");
+
+        // The Paxton half is kept from the current configuration
+        DeviceConfig config = configManager.get();
+        config.resetCard.bitLength = command.resetCard.bitLength;
+        config.resetCard.facilityCode = command.resetCard.facilityCode;
+        config.resetCard.cardNumber = command.resetCard.cardNumber;
+        configManager.commit(config, CONFIG_RESET_CARD);
+        LOG_I("[RESET] Reset Card updated to: %u/%lu/%lu", command.resetCard.bitLength,
+              (unsigned long)command.resetCard.facilityCode, (unsigned long)command.resetCard.cardNumber);
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Successfully updated Reset Card");
+
+        response["status"] = "success";
+        return true;
+    }
+
+    case COMMAND_PAXTON_RESET_CARD:
+    {
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Updating Paxton Reset Card...");
+
+        // The HID half is kept from the current configuration
+        DeviceConfig config = configManager.get();
+        strlcpy(config.resetCard.paxtonHex, command.paxtonHex, sizeof(config.resetCard.paxtonHex));
+        configManager.commit(config, CONFIG_RESET_CARD);
+        LOG_I("[RESET] Paxton Reset Card HEX updated to: %s", command.paxtonHex);
+        LOG_SEPARATOR();
+        LOG_I("[WEBSOCKET] Successfully updated Paxton Reset Card");
+
+        response["status"] = "success";
+        return true;
+    }
+
+    default:
+        response["status"] = "error";
+        response["message"] = "Unknown command";
+        return false;
+    }
+}
+
+void CommandExecutor::complete(const Command &command, bool ok, JsonDocument &response)
+{
+    response["id"] = command.id;
+    response["command"] = commandName(command.type);
+    response["state"] = ok ? "done" : "failed";
+    webSocketProtocol.send(command.client, response);
+}
+
+void CommandExecutor::scheduleRestart()
+{
+    // The timer fires once the completion has gone out; a second request
+    // while it is armed changes nothing
+    configManager.flush();
+    if (restartRequestedAt == 0)
+    {
+        restartRequestedAt = esp_timer_get_time();
+        esp_timer_start_once(restartTimer, (uint64_t)COMMAND_RESTART_DELAY_MS * 1000);
+    }
+}
+
+void CommandExecutor::restartTimerCallback(void *arg)
+{
+    CommandExecutor *executor = static_cast<CommandExecutor *>(arg);
+    int64_t waitedMs = (esp_timer_get_time() - executor->restartRequestedAt) / 1000;
+
+    // Let the storage task finish the configuration save and card log wipe,
+    // including a write it has already taken off the queue
+    if (!storageManager.isIdle() && waitedMs < COMMAND_RESTART_MAX_WAIT_MS)
+    {
+        esp_timer_start_once(executor->restartTimer, (uint64_t)COMMAND_RESTART_POLL_MS * 1000);
+        return;
+    }
+
+    LOG_I("[COMMAND] Restarting the device");
+    ESP.restart();
+}
+
+void CommandExecutor::commandTaskFunction(void *parameter)
+{
+    CommandExecutor *executor = static_cast<CommandExecutor *>(parameter);
+
+    while (true)
+    {
+        if (xQueueReceive(executor->queue, &executor->current, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        const Command &command = executor->current;
+        int64_t start = esp_timer_get_time();
+        JsonDocument response;
+        bool ok = executor->execute(command, response);
+        uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+
+        executor->lastDurationUs = duration;
+        if (duration > executor->maxDurationUs)
+        {
+            executor->maxDurationUs = duration;
+        }
+        executor->executed++;
+        if (!ok)
+        {
+            executor->failed++;
+        }
+        LOG_D("[COMMAND] #%lu %s %s in %lu us", (unsigned long)command.id, commandName(command.type),
+              ok ? "done" : "failed", (unsigned long)duration);
+
+        executor->complete(command, ok, response);
+    }
+}
+
+CommandStats CommandExecutor::getStats() const
+{
+    CommandStats stats;
+    stats.depth = queue ? uxQueueMessagesWaiting(queue) : 0;
+    stats.executed = executed;
+    stats.failed = failed;
+    stats.dropped = dropped;
+    stats.lastDurationUs = lastDurationUs;
+    stats.maxDurationUs = maxDurationUs;
+    return stats;
+}
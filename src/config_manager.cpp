@@ -0,0 +1,613 @@
+#include "config_manager.h"
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <LittleFS.h>
+#include <esp_timer.h>
+#include "console_log.h"
+#include "credential_index.h"
+#include "crc32.h"
+#include "reader_manager.h"
+#include "reset_card_manager.h"
+#include "storage_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_CONFIG
+
+#define CONFIG_DEFAULT_PULSE_MS 1000
+
+// Stored fields. An ID is never renumbered or reused: a new field gets the
+// next free ID, and a removed one just leaves its ID out of the table.
+struct ConfigField
+{
+    uint8_t id;
+    uint16_t offset;
+    uint8_t size;
+    bool text; // NUL-terminated; a longer stored value is cut short
+};
+
+#define CONFIG_FIELD(id, member) {id, offsetof(DeviceConfig, member), sizeof(((DeviceConfig *)0)->member), false}
+#define CONFIG_TEXT_FIELD(id, member) {id, offsetof(DeviceConfig, member), sizeof(((DeviceConfig *)0)->member), true}
+
+static const ConfigField CONFIG_FIELDS[] = {
+    CONFIG_FIELD(1, readerType),
+    CONFIG_FIELD(2, debugEnabled),
+    CONFIG_FIELD(3, logLevel),
+    CONFIG_FIELD(4, gpio.pin35Enabled),
+    CONFIG_FIELD(5, gpio.pin36Enabled),
+    CONFIG_FIELD(6, gpio.pin35DefaultHigh),
+    CONFIG_FIELD(7, gpio.pin36DefaultHigh),
+    CONFIG_FIELD(8, gpio.pin35PulseMs),
+    CONFIG_FIELD(9, gpio.pin36PulseMs),
+    CONFIG_FIELD(10, notifications.enableEmail),
+    CONFIG_TEXT_FIELD(11, notifications.smtpHost),
+    CONFIG_TEXT_FIELD(12, notifications.smtpPort),
+    CONFIG_TEXT_FIELD(13, notifications.smtpUser),
+    CONFIG_TEXT_FIELD(14, notifications.smtpPass),
+    CONFIG_TEXT_FIELD(15, notifications.smtpRecipient),
+    CONFIG_FIELD(16, resetCard.bitLength),
+    CONFIG_FIELD(17, resetCard.facilityCode),
+    CONFIG_FIELD(18, resetCard.cardNumber),
+    CONFIG_TEXT_FIELD(19, resetCard.paxtonHex),
+    CONFIG_FIELD(20, credentialRenotifySeconds),
+    CONFIG_FIELD(21, credentialLogRepeats),
+};
+
+static const size_t CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+
+ConfigManager &configManager = ConfigManager::getInstance();
+
+ConfigManager::ConfigManager()
+    : listenerCount(0), mainLoopSections(0), mainLoopTask(nullptr), loadMicros(0), dirtySections(0), firstDirty(0),
+      lastDirty(0), pendingSections(0)
+{
+    // Zeroed first so every byte is defined
+    memset(&config, 0, sizeof(config));
+    setDefaults(config, CONFIG_ALL);
+}
+
+ConfigManager &ConfigManager::getInstance()
+{
+    static ConfigManager instance;
+    return instance;
+}
+
+void ConfigManager::begin()
+{
+    int64_t start = esp_timer_get_time();
+    mainLoopTask = xTaskGetCurrentTaskHandle();
+
+    LOG_SEPARATOR();
+    LOG_I("[CONFIG] Loading device configuration...");
+
+    bool loaded;
+    bool upgraded = false;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        loaded = load(upgraded);
+    }
+    if (!loaded)
+    {
+        migrate();
+    }
+    else if (upgraded)
+    {
+        LOG_I("[CONFIG] Rewriting configuration in the current format");
+        save();
+    }
+
+    loadMicros = (uint32_t)(esp_timer_get_time() - start);
+    LOG_I("[CONFIG] Configuration %s in %lu us", loaded ? "loaded" : "migrated",
+          (unsigned long)loadMicros);
+}
+
+void ConfigManager::setDefaults(DeviceConfig &config, uint32_t sections)
+{
+    if (sections & CONFIG_READER)
+    {
+        config.readerType = READER_HID;
+    }
+    if (sections & CONFIG_DEBUG)
+    {
+        config.debugEnabled = true;
+        config.logLevel = LOG_LEVEL_VERBOSE;
+    }
+    if (sections & CONFIG_GPIO)
+    {
+        config.gpio.pin35Enabled = false;
+        config.gpio.pin36Enabled = false;
+        config.gpio.pin35DefaultHigh = false;
+        config.gpio.pin36DefaultHigh = false;
+        config.gpio.pin35PulseMs = CONFIG_DEFAULT_PULSE_MS;
+        config.gpio.pin36PulseMs = CONFIG_DEFAULT_PULSE_MS;
+    }
+    if (sections & CONFIG_NOTIFICATIONS)
+    {
+        memset(&config.notifications, 0, sizeof(config.notifications));
+        config.notifications.enableEmail = false;
+    }
+    if (sections & CONFIG_RESET_CARD)
+    {
+        memset(&config.resetCard, 0, sizeof(config.resetCard));
+        config.resetCard.bitLength = RESET_CARD_DEFAULT_BL;
+        config.resetCard.facilityCode = RESET_CARD_DEFAULT_FC;
+        config.resetCard.cardNumber = RESET_CARD_DEFAULT_CN;
+        strlcpy(config.resetCard.paxtonHex, RESET_CARD_DEFAULT_PAXTON_HEX, sizeof(config.resetCard.paxtonHex));
+    }
+    if (sections & CONFIG_CREDENTIALS)
+    {
+        config.credentialRenotifySeconds = CREDENTIAL_DEFAULT_RENOTIFY_SECONDS;
+        config.credentialLogRepeats = false;
+    }
+}
+
+void ConfigManager::copySections(DeviceConfig &to, const DeviceConfig &from, uint32_t sections)
+{
+    if (sections & CONFIG_READER)
+    {
+        to.readerType = from.readerType;
+    }
+    if (sections & CONFIG_DEBUG)
+    {
+        to.debugEnabled = from.debugEnabled;
+        to.logLevel = from.logLevel;
+    }
+    if (sections & CONFIG_GPIO)
+    {
+        to.gpio = from.gpio;
+    }
+    if (sections & CONFIG_NOTIFICATIONS)
+    {
+        to.notifications = from.notifications;
+    }
+    if (sections & CONFIG_RESET_CARD)
+    {
+        to.resetCard = from.resetCard;
+    }
+    if (sections & CONFIG_CREDENTIALS)
+    {
+        to.credentialRenotifySeconds = from.credentialRenotifySeconds;
+        to.credentialLogRepeats = from.credentialLogRepeats;
+    }
+}
+
+DeviceConfig ConfigManager::get() const
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    return config;
+}
+
+void ConfigManager::commit(const DeviceConfig &newConfig, uint32_t sections)
+{
+    bool onMainLoop = xTaskGetCurrentTaskHandle() == mainLoopTask;
+    DeviceConfig current;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        if (!onMainLoop)
+        {
+            pendingSections |= sections & mainLoopSections;
+        }
+        DeviceConfig previous = config;
+        copySections(config, newConfig, sections);
+        current = config;
+
+        // Settings written back unchanged need no flash write
+        if (memcmp(&previous, &current, sizeof(current)) != 0)
+        {
+            unsigned long now = millis();
+            if (dirtySections == 0)
+            {
+                firstDirty = now;
+            }
+            dirtySections |= sections;
+            lastDirty = now;
+        }
+    }
+
+    for (uint8_t i = 0; i < listenerCount; i++)
+    {
+        if ((listeners[i].sections & sections) && (onMainLoop || !listeners[i].onMainLoop))
+        {
+            listeners[i].callback(sections, current);
+        }
+    }
+}
+
+void ConfigManager::applyPending()
+{
+    uint32_t sections;
+    DeviceConfig current;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        if (pendingSections == 0)
+        {
+            return;
+        }
+        sections = pendingSections;
+        pendingSections = 0;
+        current = config;
+    }
+
+    for (uint8_t i = 0; i < listenerCount; i++)
+    {
+        if (listeners[i].onMainLoop && (listeners[i].sections & sections))
+        {
+            listeners[i].callback(sections, current);
+        }
+    }
+}
+
+void ConfigManager::restoreDefaults(uint32_t sections)
+{
+    DeviceConfig defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    setDefaults(defaults, sections);
+    commit(defaults, sections);
+}
+
+void ConfigManager::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        if (dirtySections == 0)
+        {
+            return;
+        }
+        unsigned long now = millis();
+        if (now - lastDirty < CONFIG_SAVE_DELAY_MS && now - firstDirty < CONFIG_SAVE_MAX_DELAY_MS)
+        {
+            return;
+        }
+    }
+    flush();
+}
+
+bool ConfigManager::flush()
+{
+    uint32_t sections;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        sections = dirtySections;
+        dirtySections = 0;
+    }
+    if (sections == 0)
+    {
+        return true;
+    }
+
+    // The job snapshots the configuration when it runs, so commits made
+    // after this point are saved by it or by the next flush
+    if (!storageManager.run(saveJob))
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        if (dirtySections == 0)
+        {
+            firstDirty = millis();
+        }
+        dirtySections |= sections;
+        lastDirty = millis();
+        LOG_W("[CONFIG] Storage queue full, configuration save deferred");
+        return false;
+    }
+    LOG_D("[CONFIG] Saving configuration (sections 0x%02lx)", (unsigned long)sections);
+    return true;
+}
+
+void ConfigManager::subscribe(uint32_t sections, ConfigListener listener, bool onMainLoop)
+{
+    if (listenerCount < CONFIG_MAX_LISTENERS)
+    {
+        listeners[listenerCount].sections = sections;
+        listeners[listenerCount].callback = listener;
+        listeners[listenerCount].onMainLoop = onMainLoop;
+        listenerCount++;
+        if (onMainLoop)
+        {
+            mainLoopSections |= sections;
+        }
+    }
+}
+
+size_t ConfigManager::encode(const DeviceConfig &config, uint8_t *out, size_t outLen)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++)
+    {
+        const ConfigField &field = CONFIG_FIELDS[i];
+        if (length + 2 + field.size > outLen)
+        {
+            return 0;
+        }
+        out[length++] = field.id;
+        out[length++] = field.size;
+        memcpy(out + length, (const uint8_t *)&config + field.offset, field.size);
+        length += field.size;
+    }
+    return length;
+}
+
+bool ConfigManager::decode(const uint8_t *data, size_t length, DeviceConfig &config)
+{
+    size_t position = 0;
+    while (position + 2 <= length)
+    {
+        uint8_t id = data[position];
+        uint8_t size = data[position + 1];
+        position += 2;
+        if (position + size > length)
+        {
+            return false;
+        }
+
+        // Unknown IDs are fields a later firmware added
+        for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++)
+        {
+            const ConfigField &field = CONFIG_FIELDS[i];
+            if (field.id != id)
+            {
+                continue;
+            }
+            // Numbers of another width are zero-extended or cut (little endian)
+            uint8_t *target = (uint8_t *)&config + field.offset;
+            memset(target, 0, field.size);
+            memcpy(target, data + position, size < field.size ? size : field.size);
+            if (field.text)
+            {
+                target[field.size - 1] = '\0';
+            }
+            break;
+        }
+        position += size;
+    }
+    return position == length;
+}
+
+bool ConfigManager::load(bool &upgraded)
+{
+    File file = LittleFS.open(CONFIG_FILE, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    ConfigFileHeader header;
+    uint8_t body[CONFIG_FILE_MAX_BODY];
+    bool valid = file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) && header.length <= sizeof(body) &&
+                 file.read(body, header.length) == header.length && crc32Update(0, body, header.length) == header.crc;
+    file.close();
+
+    // Fields missing from the file keep their defaults
+    DeviceConfig loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    setDefaults(loaded, CONFIG_ALL);
+
+    if (valid && header.version == CONFIG_VERSION)
+    {
+        valid = decode(body, header.length, loaded);
+    }
+    else if (valid && header.version == CONFIG_VERSION_RAW && header.length == sizeof(loaded))
+    {
+        // Written by the firmware that introduced this file
+        memcpy(&loaded, body, sizeof(loaded));
+        upgraded = true;
+    }
+    else
+    {
+        valid = false;
+    }
+
+    if (!valid)
+    {
+        LOG_W("[CONFIG] Saved configuration is damaged or from an unknown version");
+        return false;
+    }
+
+    // Strings come from flash; never trust their terminators
+    loaded.notifications.smtpHost[CONFIG_SMTP_FIELD_SIZE - 1] = '\0';
+    loaded.notifications.smtpPort[CONFIG_SMTP_PORT_SIZE - 1] = '\0';
+    loaded.notifications.smtpUser[CONFIG_SMTP_FIELD_SIZE - 1] = '\0';
+    loaded.notifications.smtpPass[CONFIG_SMTP_FIELD_SIZE - 1] = '\0';
+    loaded.notifications.smtpRecipient[CONFIG_SMTP_FIELD_SIZE - 1] = '\0';
+    loaded.resetCard.paxtonHex[CONFIG_PAXTON_HEX_LENGTH] = '\0';
+    config = loaded;
+    return true;
+}
+
+static bool readLegacyFile(const char *path, JsonDocument &doc)
+{
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error)
+    {
+        LOG_W("[CONFIG] Ignoring unreadable %s", path);
+        return false;
+    }
+    return true;
+}
+
+void ConfigManager::migrate()
+{
+    // Start from defaults and take whatever the old files still hold
+    DeviceConfig migrated;
+    memset(&migrated, 0, sizeof(migrated));
+    setDefaults(migrated, CONFIG_ALL);
+
+    JsonDocument doc;
+    if (readLegacyFile(CONFIG_LEGACY_READER_FILE, doc))
+    {
+        migrated.readerType = strcmp(doc["READER_TYPE"] | "HID", "PAXTON") == 0 ? READER_PAXTON : READER_HID;
+    }
+
+    doc.clear();
+    if (readLegacyFile(CONFIG_LEGACY_DEBUG_FILE, doc))
+    {
+        migrated.debugEnabled = doc["DEBUG"] | true;
+        uint8_t level;
+        if (consoleLogLevelFromName(doc["LOG_LEVEL"] | "verbose", level))
+        {
+            migrated.logLevel = level;
+        }
+    }
+
+    doc.clear();
+    if (readLegacyFile(CONFIG_LEGACY_GPIO_FILE, doc))
+    {
+        migrated.gpio.pin35Enabled = doc["pin35_enabled"] | false;
+        migrated.gpio.pin36Enabled = doc["pin36_enabled"] | false;
+        migrated.gpio.pin35DefaultHigh = doc["pin35_default_high"] | false;
+        migrated.gpio.pin36DefaultHigh = doc["pin36_default_high"] | false;
+        migrated.gpio.pin35PulseMs = doc["pin35_pulse_duration"] | CONFIG_DEFAULT_PULSE_MS;
+        migrated.gpio.pin36PulseMs = doc["pin36_pulse_duration"] | CONFIG_DEFAULT_PULSE_MS;
+    }
+
+    doc.clear();
+    if (readLegacyFile(CONFIG_LEGACY_NOTIFICATION_FILE, doc))
+    {
+        // Stored as a boolean or as the string "true"
+        NotificationConfig &notifications = migrated.notifications;
+        notifications.enableEmail = doc["enable_email"].is<bool>() ? doc["enable_email"].as<bool>()
+                                                                   : strcmp(doc["enable_email"] | "false", "true") == 0;
+        strlcpy(notifications.smtpHost, doc["smtp_host"] | "", sizeof(notifications.smtpHost));
+        strlcpy(notifications.smtpPort, doc["smtp_port"] | "", sizeof(notifications.smtpPort));
+        strlcpy(notifications.smtpUser, doc["smtp_user"] | "", sizeof(notifications.smtpUser));
+        strlcpy(notifications.smtpPass, doc["smtp_pass"] | "", sizeof(notifications.smtpPass));
+        strlcpy(notifications.smtpRecipient, doc["smtp_recipient"] | "", sizeof(notifications.smtpRecipient));
+    }
+
+    doc.clear();
+    if (readLegacyFile(CONFIG_LEGACY_RESET_CARD_FILE, doc))
+    {
+        migrated.resetCard.bitLength = doc["RBL"] | RESET_CARD_DEFAULT_BL;
+        migrated.resetCard.facilityCode = doc["RFC"] | RESET_CARD_DEFAULT_FC;
+        migrated.resetCard.cardNumber = doc["RCN"] | RESET_CARD_DEFAULT_CN;
+        const char *hex = doc["PAXTON_RESET_HEX"] | RESET_CARD_DEFAULT_PAXTON_HEX;
+        size_t i = 0;
+        for (; i < CONFIG_PAXTON_HEX_LENGTH && hex[i] != '\0'; i++)
+        {
+            migrated.resetCard.paxtonHex[i] = toupper((unsigned char)hex[i]);
+        }
+        migrated.resetCard.paxtonHex[i] = '\0';
+    }
+
+    doc.clear();
+    if (readLegacyFile(CONFIG_LEGACY_CREDENTIAL_FILE, doc))
+    {
+        migrated.credentialRenotifySeconds = doc["RENOTIFY_SECONDS"] | CREDENTIAL_DEFAULT_RENOTIFY_SECONDS;
+        migrated.credentialLogRepeats = doc["LOG_REPEATS"] | false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        config = migrated;
+    }
+
+    // The old files go only once the blob is safely written; until then the
+    // next boot migrates again
+    if (!save())
+    {
+        return;
+    }
+    const char *legacyFiles[] = {CONFIG_LEGACY_READER_FILE, CONFIG_LEGACY_DEBUG_FILE, CONFIG_LEGACY_GPIO_FILE,
+                                 CONFIG_LEGACY_GPIO_COPY_FILE, CONFIG_LEGACY_NOTIFICATION_FILE,
+                                 CONFIG_LEGACY_RESET_CARD_FILE, CONFIG_LEGACY_CREDENTIAL_FILE};
+    for (const char *path : legacyFiles)
+    {
+        if (LittleFS.exists(path))
+        {
+            LittleFS.remove(path);
+            LOG_I("[CONFIG] Migrated and removed %s", path);
+        }
+    }
+}
+
+void ConfigManager::saveJob(const uint8_t *data, size_t length)
+{
+    getInstance().save();
+}
+
+bool ConfigManager::save()
+{
+    // Runs on the storage task (or inline during boot)
+    DeviceConfig snapshot;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        snapshot = config;
+    }
+
+    uint8_t body[CONFIG_FILE_MAX_BODY];
+    ConfigFileHeader header;
+    header.version = CONFIG_VERSION;
+    header.length = encode(snapshot, body, sizeof(body));
+    header.crc = crc32Update(0, body, header.length);
+    if (header.length == 0)
+    {
+        LOG_E("[CONFIG] Configuration does not fit CONFIG_FILE_MAX_BODY");
+        return false;
+    }
+
+    File file = LittleFS.open(CONFIG_TMP_FILE, "w");
+    if (!file)
+    {
+        LOG_E("[CONFIG] Failed to open configuration file");
+        return false;
+    }
+    bool written = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                   file.write(body, header.length) == header.length;
+    file.close();
+
+    if (!written || !LittleFS.rename(CONFIG_TMP_FILE, CONFIG_FILE))
+    {
+        LittleFS.remove(CONFIG_TMP_FILE);
+        LOG_E("[CONFIG] Failed to save configuration");
+        return false;
+    }
+    return true;
+}
+
+void ConfigManager::writeJson(uint32_t section, Print &out) const
+{
+    DeviceConfig current = get();
+    JsonDocument doc;
+
+    switch (section)
+    {
+    case CONFIG_READER:
+        doc["READER_TYPE"] = current.readerType == READER_PAXTON ? "PAXTON" : "HID";
+        break;
+    case CONFIG_DEBUG:
+        doc["DEBUG"] = current.debugEnabled;
+        doc["LOG_LEVEL"] = consoleLogLevelName(current.logLevel);
+        break;
+    case CONFIG_GPIO:
+        doc["pin35_enabled"] = current.gpio.pin35Enabled;
+        doc["pin36_enabled"] = current.gpio.pin36Enabled;
+        doc["pin35_default_high"] = current.gpio.pin35DefaultHigh;
+        doc["pin36_default_high"] = current.gpio.pin36DefaultHigh;
+        doc["pin35_pulse_duration"] = current.gpio.pin35PulseMs;
+        doc["pin36_pulse_duration"] = current.gpio.pin36PulseMs;
+        break;
+    case CONFIG_NOTIFICATIONS:
+        // The SMTP password is write-only
+        doc["enable_email"] = current.notifications.enableEmail ? "true" : "false";
+        doc["smtp_host"] = current.notifications.smtpHost;
+        doc["smtp_port"] = current.notifications.smtpPort;
+        doc["smtp_user"] = current.notifications.smtpUser;
+        doc["smtp_recipient"] = current.notifications.smtpRecipient;
+        break;
+    case CONFIG_RESET_CARD:
+        doc["RBL"] = current.resetCard.bitLength;
+        doc["RFC"] = current.resetCard.facilityCode;
+        doc["RCN"] = current.resetCard.cardNumber;
+        doc["PAXTON_RESET_HEX"] = current.resetCard.paxtonHex;
+        break;
+    case CONFIG_CREDENTIALS:
+        doc["RENOTIFY_SECONDS"] = current.credentialRenotifySeconds;
+        doc["LOG_REPEATS"] = current.credentialLogRepeats;
+        break;
+    }
+    serializeJson(doc, out);
+}
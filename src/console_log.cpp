@@ -0,0 +1,257 @@
+#include "console_log.h"
+
+ConsoleLog &consoleLog = ConsoleLog::getInstance();
+
+static_assert((CONSOLE_LOG_SLOTS & (CONSOLE_LOG_SLOTS - 1)) == 0, "CONSOLE_LOG_SLOTS must be a power of two");
+
+ConsoleLog::ConsoleLog()
+    : enqueuePos(0), dequeuePos(0), drainTaskHandle(nullptr), runtimeLevel(LOG_LEVEL_VERBOSE),
+      serialLevel(LOG_LEVEL_VERBOSE), streamLevel(LOG_LEVEL_NONE), tap(nullptr), written(0), dropped(0), truncated(0), highWater(0)
+{
+    for (uint32_t i = 0; i < CONSOLE_LOG_SLOTS; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+ConsoleLog &ConsoleLog::getInstance()
+{
+    static ConsoleLog instance;
+    return instance;
+}
+
+void ConsoleLog::begin()
+{
+    if (drainTaskHandle)
+    {
+        return;
+    }
+
+    xTaskCreatePinnedToCore(
+        drainTaskFunction,
+        "ConsoleLog",
+        CONSOLE_LOG_TASK_STACK,
+        this,
+        CONSOLE_LOG_TASK_PRIORITY,
+        &drainTaskHandle,
+        CONSOLE_LOG_TASK_CORE);
+}
+
+ConsoleLog::Slot *ConsoleLog::claim(uint32_t &position)
+{
+    position = enqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot *slot = &slots[position & (CONSOLE_LOG_SLOTS - 1)];
+        int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - position);
+        if (diff == 0)
+        {
+            // Slot is free for this position - take it unless another producer did
+            if (enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                return slot;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The drain task has not emptied this slot yet: the ring is full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            position = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void ConsoleLog::publish(Slot *slot, uint32_t position)
+{
+    slot->sequence.store(position + 1, std::memory_order_release);
+    written.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t used = position + 1 - dequeuePos.load(std::memory_order_relaxed);
+    uint32_t peak = highWater.load(std::memory_order_relaxed);
+    while (used > peak && !highWater.compare_exchange_weak(peak, used, std::memory_order_relaxed))
+    {
+    }
+
+    if (drainTaskHandle)
+    {
+        xTaskNotifyGive(drainTaskHandle);
+    }
+}
+
+bool ConsoleLog::write(const char *text, size_t length)
+{
+    uint32_t position;
+    Slot *slot = claim(position);
+    if (!slot)
+    {
+        return false;
+    }
+
+    if (length > sizeof(slot->text))
+    {
+        length = sizeof(slot->text);
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    memcpy(slot->text, text, length);
+    slot->length = length;
+    slot->level = LOG_LEVEL_INFO;
+    publish(slot, position);
+    return true;
+}
+
+bool ConsoleLog::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool queued = vlogf(LOG_LEVEL_INFO, format, args);
+    va_end(args);
+    return queued;
+}
+
+bool ConsoleLog::logf(uint8_t level, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool queued = vlogf(level, format, args);
+    va_end(args);
+    return queued;
+}
+
+bool ConsoleLog::vlogf(uint8_t level, const char *format, va_list args)
+{
+    uint32_t position;
+    Slot *slot = claim(position);
+    if (!slot)
+    {
+        return false;
+    }
+
+    // Format straight into the claimed slot
+    int length = vsnprintf(slot->text, sizeof(slot->text), format, args);
+
+    if (length < 0)
+    {
+        length = 0;
+    }
+    else if (length >= (int)sizeof(slot->text))
+    {
+        length = sizeof(slot->text) - 1;
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->length = length;
+    slot->level = level;
+    publish(slot, position);
+    return true;
+}
+
+bool ConsoleLog::drainOne()
+{
+    // Single consumer: only the drain task advances dequeuePos
+    uint32_t position = dequeuePos.load(std::memory_order_relaxed);
+    Slot *slot = &slots[position & (CONSOLE_LOG_SLOTS - 1)];
+    if (slot->sequence.load(std::memory_order_acquire) != position + 1)
+    {
+        return false;
+    }
+
+    if (slot->level <= serialLevel.load(std::memory_order_relaxed))
+    {
+        Serial.write((const uint8_t *)slot->text, slot->length);
+        Serial.write((const uint8_t *)"\r\n", 2);
+    }
+    ConsoleLogTap callback = tap.load(std::memory_order_acquire);
+    if (callback)
+    {
+        callback(slot->level, slot->text, slot->length);
+    }
+
+    dequeuePos.store(position + 1, std::memory_order_relaxed);
+    slot->sequence.store(position + CONSOLE_LOG_SLOTS, std::memory_order_release);
+    return true;
+}
+
+void ConsoleLog::drainTaskFunction(void *parameter)
+{
+    ConsoleLog *console = static_cast<ConsoleLog *>(parameter);
+    uint32_t reportedDrops = 0;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        while (console->drainOne())
+        {
+        }
+
+        uint32_t drops = console->dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops)
+        {
+            char notice[64];
+            int length = snprintf(notice, sizeof(notice), "[CONSOLE] %lu line(s) dropped - console ring was full",
+                                  (unsigned long)(drops - reportedDrops));
+            if (console->serialLevel.load(std::memory_order_relaxed) >= LOG_LEVEL_WARN)
+            {
+                Serial.write((const uint8_t *)notice, length);
+                Serial.write((const uint8_t *)"\r\n", 2);
+            }
+            ConsoleLogTap callback = console->tap.load(std::memory_order_acquire);
+            if (callback)
+            {
+                callback(LOG_LEVEL_WARN, notice, length);
+            }
+            reportedDrops = drops;
+        }
+    }
+}
+
+ConsoleLogStats ConsoleLog::getStats() const
+{
+    ConsoleLogStats stats;
+    stats.written = written.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.truncated = truncated.load(std::memory_order_relaxed);
+    stats.highWater = highWater.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ConsoleLog::setSerialLevel(uint8_t level)
+{
+    serialLevel.store(level, std::memory_order_relaxed);
+    updateRuntimeLevel();
+}
+
+void ConsoleLog::setStreamLevel(uint8_t level)
+{
+    streamLevel.store(level, std::memory_order_relaxed);
+    updateRuntimeLevel();
+}
+
+void ConsoleLog::updateRuntimeLevel()
+{
+    uint8_t serial = serialLevel.load(std::memory_order_relaxed);
+    uint8_t stream = streamLevel.load(std::memory_order_relaxed);
+    runtimeLevel.store(serial > stream ? serial : stream, std::memory_order_relaxed);
+}
+
+static const char *const LEVEL_NAMES[] = {"none", "error", "warn", "info", "debug", "verbose"};
+
+const char *consoleLogLevelName(uint8_t level)
+{
+    return level <= LOG_LEVEL_VERBOSE ? LEVEL_NAMES[level] : "verbose";
+}
+
+bool consoleLogLevelFromName(const char *name, uint8_t &level)
+{
+    for (uint8_t i = 0; i <= LOG_LEVEL_VERBOSE; i++)
+    {
+        if (strcasecmp(name, LEVEL_NAMES[i]) == 0)
+        {
+            level = i;
+            return true;
+        }
+    }
+    return false;
+}
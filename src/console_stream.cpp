@@ -0,0 +1,214 @@
+#include "console_stream.h"
+#include <ArduinoJson.h>
+#include "websocket_protocol.h"
+
+ConsoleStream &consoleStream = ConsoleStream::getInstance();
+
+static_assert((CONSOLE_STREAM_HISTORY & (CONSOLE_STREAM_HISTORY - 1)) == 0,
+              "CONSOLE_STREAM_HISTORY must be a power of two");
+
+ConsoleStream::ConsoleStream() : head(0), activeCount(0)
+{
+    for (uint8_t i = 0; i < CONSOLE_STREAM_MAX_CLIENTS; i++)
+    {
+        subscribers[i].active = false;
+    }
+}
+
+ConsoleStream &ConsoleStream::getInstance()
+{
+    static ConsoleStream instance;
+    return instance;
+}
+
+void ConsoleStream::begin()
+{
+    consoleLog.setTap(onConsoleLine);
+}
+
+void ConsoleStream::onConsoleLine(uint8_t level, const char *text, size_t length)
+{
+    getInstance().append(level, text, length);
+}
+
+void ConsoleStream::append(uint8_t level, const char *text, size_t length)
+{
+    // Runs on the console drain task; the lock is only held for the copy
+    std::lock_guard<std::mutex> lock(historyMutex);
+    Line &line = history[head & (CONSOLE_STREAM_HISTORY - 1)];
+    if (length > CONSOLE_LOG_LINE_SIZE)
+    {
+        length = CONSOLE_LOG_LINE_SIZE;
+    }
+    memcpy(line.text, text, length);
+    line.text[length] = '\0';
+    line.level = level;
+    line.seq = head;
+    head++;
+}
+
+bool ConsoleStream::subscribe(uint32_t client, uint8_t level)
+{
+    if (level == LOG_LEVEL_NONE)
+    {
+        unsubscribe(client);
+        return true;
+    }
+
+    Subscriber *slot = nullptr;
+    for (uint8_t i = 0; i < CONSOLE_STREAM_MAX_CLIENTS; i++)
+    {
+        if (subscribers[i].active && subscribers[i].client == client)
+        {
+            // Level change only; keep the cursor
+            subscribers[i].level = level;
+            updateStreamLevel();
+            return true;
+        }
+        if (!subscribers[i].active && !slot)
+        {
+            slot = &subscribers[i];
+        }
+    }
+    if (!slot)
+    {
+        return false;
+    }
+
+    // New subscribers start with the lines still held in the history
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        slot->nextSeq = head > CONSOLE_STREAM_HISTORY ? head - CONSOLE_STREAM_HISTORY : 0;
+    }
+    slot->active = true;
+    slot->client = client;
+    slot->level = level;
+    slot->skipped = 0;
+    slot->tokens = CONSOLE_STREAM_BURST;
+    slot->lastRefill = millis();
+    activeCount++;
+    updateStreamLevel();
+    return true;
+}
+
+void ConsoleStream::unsubscribe(uint32_t client)
+{
+    for (uint8_t i = 0; i < CONSOLE_STREAM_MAX_CLIENTS; i++)
+    {
+        if (subscribers[i].active && subscribers[i].client == client)
+        {
+            subscribers[i].active = false;
+            activeCount--;
+            updateStreamLevel();
+            return;
+        }
+    }
+}
+
+void ConsoleStream::updateStreamLevel()
+{
+    // Lines above every subscriber's level are not worth formatting
+    uint8_t level = LOG_LEVEL_NONE;
+    for (uint8_t i = 0; i < CONSOLE_STREAM_MAX_CLIENTS; i++)
+    {
+        if (subscribers[i].active && subscribers[i].level > level)
+        {
+            level = subscribers[i].level;
+        }
+    }
+    consoleLog.setStreamLevel(level);
+}
+
+void ConsoleStream::update()
+{
+    if (activeCount == 0)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < CONSOLE_STREAM_MAX_CLIENTS; i++)
+    {
+        if (!subscribers[i].active)
+        {
+            continue;
+        }
+        // Covers a disconnect that never reached the event queue
+        if (!webSocketProtocol.isConnected(subscribers[i].client))
+        {
+            unsubscribe(subscribers[i].client);
+            continue;
+        }
+        send(subscribers[i]);
+    }
+}
+
+void ConsoleStream::send(Subscriber &subscriber)
+{
+    // Token bucket: CONSOLE_STREAM_RATE lines per second, up to CONSOLE_STREAM_BURST
+    unsigned long now = millis();
+    uint32_t earned = (now - subscriber.lastRefill) * CONSOLE_STREAM_RATE / 1000;
+    if (earned > 0)
+    {
+        subscriber.lastRefill += earned * 1000 / CONSOLE_STREAM_RATE;
+        if (subscriber.tokens + earned >= CONSOLE_STREAM_BURST)
+        {
+            subscriber.tokens = CONSOLE_STREAM_BURST;
+            subscriber.lastRefill = now;
+        }
+        else
+        {
+            subscriber.tokens += earned;
+        }
+    }
+
+    uint8_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        uint32_t oldest = head > CONSOLE_STREAM_HISTORY ? head - CONSOLE_STREAM_HISTORY : 0;
+        if (subscriber.nextSeq < oldest)
+        {
+            // Overwritten before this client could take them
+            subscriber.skipped += oldest - subscriber.nextSeq;
+            subscriber.nextSeq = oldest;
+        }
+
+        while (subscriber.nextSeq < head && count < CONSOLE_STREAM_BATCH && count < subscriber.tokens)
+        {
+            const Line &line = history[subscriber.nextSeq & (CONSOLE_STREAM_HISTORY - 1)];
+            subscriber.nextSeq++;
+            if (line.level <= subscriber.level)
+            {
+                outbox[count++] = line;
+            }
+        }
+    }
+
+    // A frame that only reports skipped lines still costs a token
+    if (count == 0 && (subscriber.skipped == 0 || subscriber.tokens == 0))
+    {
+        return;
+    }
+
+    JsonDocument doc;
+    JsonArray lines = doc["console"].to<JsonArray>();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        JsonObject line = lines.add<JsonObject>();
+        line["seq"] = outbox[i].seq;
+        line["level"] = consoleLogLevelName(outbox[i].level);
+        line["text"] = (const char *)outbox[i].text;
+    }
+    if (subscriber.skipped > 0)
+    {
+        doc["skipped"] = subscriber.skipped;
+    }
+
+    if (webSocketProtocol.send(subscriber.client, doc))
+    {
+        subscriber.tokens -= count > 0 ? count : 1;
+        subscriber.skipped = 0;
+    }
+    else
+    {
+        subscriber.skipped += count;
+    }
+}
@@ -0,0 +1,25 @@
+#include "crc32.h"
+
+#if __has_include("esp_rom_crc.h")
+#include "esp_rom_crc.h"
+#define CRC32_USE_ROM 1
+#endif
+
+uint32_t crc32Update(uint32_t crc, const void *data, size_t length)
+{
+#ifdef CRC32_USE_ROM
+    return esp_rom_crc32_le(crc, (const uint8_t *)data, length);
+#else
+    const uint8_t *bytes = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+#endif
+}
@@ -0,0 +1,378 @@
+#include "credential_index.h"
+#include "crc32.h"
+#include "storage_manager.h"
+#include "clock_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_CREDENTIALS
+
+CredentialIndex &credentialIndex = CredentialIndex::getInstance();
+
+CredentialIndex::CredentialIndex()
+    : table{}, count(0), version(1), journalRecords(0), compactPending(false),
+      renotifySeconds(CREDENTIAL_DEFAULT_RENOTIFY_SECONDS), logRepeats(false)
+{
+}
+
+CredentialIndex &CredentialIndex::getInstance()
+{
+    static CredentialIndex instance;
+    return instance;
+}
+
+void CredentialIndex::begin()
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    LOG_SEPARATOR();
+    LOG_I("[CREDENTIALS] Loading credential index...");
+
+    loadOptions();
+    configManager.subscribe(CONFIG_CREDENTIALS, onConfigChanged);
+    loadJournal();
+
+    LOG_I("[CREDENTIALS] %u unique credential(s), re-notify window %lu s, repeats %s",
+          count, (unsigned long)renotifySeconds, logRepeats ? "logged" : "counted only");
+}
+
+uint32_t CredentialIndex::hashKey(uint8_t bits, uint32_t facilityCode, const char *id)
+{
+    // FNV-1a over the key fields
+    uint32_t hash = 2166136261UL;
+    hash = (hash ^ bits) * 16777619UL;
+    for (int i = 0; i < 4; i++)
+    {
+        hash = (hash ^ ((facilityCode >> (i * 8)) & 0xFF)) * 16777619UL;
+    }
+    for (const char *p = id; *p; p++)
+    {
+        hash = (hash ^ (uint8_t)*p) * 16777619UL;
+    }
+    return hash ? hash : 1;
+}
+
+CredentialEntry *CredentialIndex::find(uint32_t hash, uint8_t bits, uint32_t facilityCode, const char *id, bool insert)
+{
+    uint32_t slot = hash & (CREDENTIAL_INDEX_CAPACITY - 1);
+    for (uint32_t probe = 0; probe < CREDENTIAL_INDEX_CAPACITY; probe++)
+    {
+        CredentialEntry &entry = table[slot];
+        if (entry.hash == 0)
+        {
+            if (!insert || count >= CREDENTIAL_INDEX_MAX_ENTRIES)
+            {
+                return nullptr;
+            }
+            entry.hash = hash;
+            entry.bits = bits;
+            entry.facilityCode = facilityCode;
+            strlcpy(entry.id, id, sizeof(entry.id));
+            count++;
+            return &entry;
+        }
+        if (entry.hash == hash && entry.bits == bits && entry.facilityCode == facilityCode &&
+            strncmp(entry.id, id, sizeof(entry.id) - 1) == 0)
+        {
+            return &entry;
+        }
+        slot = (slot + 1) & (CREDENTIAL_INDEX_CAPACITY - 1);
+    }
+    return nullptr;
+}
+
+CredentialSighting CredentialIndex::record(uint8_t bits, uint32_t facilityCode, const char *id, const char *hex, bool net2)
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    CredentialSighting sighting = {true, true, true, 1};
+    uint32_t now = clockManager.now();
+    uint32_t hash = hashKey(bits, facilityCode, id);
+
+    CredentialEntry *entry = find(hash, bits, facilityCode, id, false);
+    if (!entry)
+    {
+        entry = find(hash, bits, facilityCode, id, true);
+        if (!entry)
+        {
+            // Index is full - treat every read of an unknown credential as new
+            return sighting;
+        }
+        entry->net2 = net2 ? 1 : 0;
+        strlcpy(entry->hex, hex, sizeof(entry->hex));
+        entry->firstSeen = now;
+        entry->lastNotified = now;
+    }
+    else
+    {
+        sighting.firstSeen = false;
+        // A clock that moved backwards (e.g. before SNTP after a reboot) also re-arms
+        sighting.notify = now < entry->lastNotified || now - entry->lastNotified >= renotifySeconds;
+        sighting.log = sighting.notify || logRepeats;
+        if (sighting.notify)
+        {
+            entry->lastNotified = now;
+        }
+    }
+
+    entry->lastSeen = now;
+    entry->count++;
+    sighting.count = entry->count;
+    version++;
+
+    appendJournal(*entry);
+    return sighting;
+}
+
+void CredentialIndex::clear()
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    memset(table, 0, sizeof(table));
+    count = 0;
+    version++;
+    journalRecords = 0;
+    storageManager.removeFile(CREDENTIAL_JOURNAL_FILE);
+}
+
+bool CredentialIndex::resolveTime(uint32_t &timestamp, uint32_t wallOffset)
+{
+    if (timestamp == 0 || ClockManager::isWallTime(timestamp))
+    {
+        return false;
+    }
+    timestamp = wallOffset != 0 ? timestamp + wallOffset : 0;
+    return true;
+}
+
+void CredentialIndex::resolveBootTimes(uint32_t wallOffset)
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    uint32_t resolved = 0;
+    for (uint32_t slot = 0; slot < CREDENTIAL_INDEX_CAPACITY; slot++)
+    {
+        CredentialEntry &entry = table[slot];
+        if (entry.hash == 0)
+        {
+            continue;
+        }
+        bool changed = resolveTime(entry.firstSeen, wallOffset);
+        changed |= resolveTime(entry.lastSeen, wallOffset);
+        changed |= resolveTime(entry.lastNotified, wallOffset);
+        if (changed)
+        {
+            resolved++;
+        }
+    }
+
+    if (resolved > 0)
+    {
+        version++;
+        compactJournal();
+    }
+    LOG_I("[CREDENTIALS] Resolved sighting times of %lu credential(s)", (unsigned long)resolved);
+}
+
+void CredentialIndex::setOptions(uint32_t newRenotifySeconds, bool newLogRepeats)
+{
+    // Applied by onConfigChanged
+    DeviceConfig config = configManager.get();
+    config.credentialRenotifySeconds = newRenotifySeconds;
+    config.credentialLogRepeats = newLogRepeats;
+    configManager.commit(config, CONFIG_CREDENTIALS);
+}
+
+void CredentialIndex::onConfigChanged(uint32_t sections, const DeviceConfig &config)
+{
+    std::lock_guard<std::mutex> lock(credentialIndex.indexMutex);
+    credentialIndex.renotifySeconds = config.credentialRenotifySeconds;
+    credentialIndex.logRepeats = config.credentialLogRepeats;
+}
+
+void CredentialIndex::loadOptions()
+{
+    DeviceConfig config = configManager.get();
+    renotifySeconds = config.credentialRenotifySeconds;
+    logRepeats = config.credentialLogRepeats;
+}
+
+void CredentialIndex::loadJournal()
+{
+    File journal = LittleFS.open(CREDENTIAL_JOURNAL_FILE, "r");
+    if (!journal)
+    {
+        return;
+    }
+
+    // Later records supersede earlier ones for the same credential
+    JournalRecord record;
+    bool torn = false;
+    while (journal.available())
+    {
+        if (journal.read((uint8_t *)&record, sizeof(record)) != sizeof(record) ||
+            crc32Update(0, &record.entry, sizeof(record.entry)) != record.crc)
+        {
+            torn = true;
+            break;
+        }
+        journalRecords++;
+
+        record.entry.id[sizeof(record.entry.id) - 1] = '\0';
+        record.entry.hex[sizeof(record.entry.hex) - 1] = '\0';
+        // Seconds since an earlier boot cannot be resolved any more
+        resolveTime(record.entry.firstSeen, 0);
+        resolveTime(record.entry.lastSeen, 0);
+        resolveTime(record.entry.lastNotified, 0);
+        CredentialEntry *entry = find(record.entry.hash, record.entry.bits, record.entry.facilityCode,
+                                      record.entry.id, true);
+        if (entry)
+        {
+            *entry = record.entry;
+        }
+    }
+    journal.close();
+
+    if (torn)
+    {
+        LOG_W("[CREDENTIALS] Dropping torn journal tail");
+        compactJournal();
+    }
+}
+
+void CredentialIndex::appendJournal(const CredentialEntry &entry)
+{
+    if (!compactPending && journalRecords > 2u * count + 64)
+    {
+        compactPending = storageManager.run(compactJob);
+    }
+
+    JournalRecord record;
+    record.entry = entry;
+    record.crc = crc32Update(0, &record.entry, sizeof(record.entry));
+
+    if (storageManager.appendFile(CREDENTIAL_JOURNAL_FILE, &record, sizeof(record)))
+    {
+        journalRecords++;
+    }
+}
+
+void CredentialIndex::compactJob(const uint8_t *data, size_t length)
+{
+    std::lock_guard<std::mutex> lock(credentialIndex.indexMutex);
+    credentialIndex.compactJournal();
+}
+
+void CredentialIndex::compactJournal()
+{
+    compactPending = false;
+
+    File snapshot = LittleFS.open(CREDENTIAL_JOURNAL_TMP_FILE, "w");
+    if (!snapshot)
+    {
+        LOG_E("[CREDENTIALS] Failed to open journal snapshot");
+        return;
+    }
+
+    // One record per live credential
+    JournalRecord record;
+    uint32_t written = 0;
+    for (uint32_t slot = 0; slot < CREDENTIAL_INDEX_CAPACITY; slot++)
+    {
+        if (table[slot].hash == 0)
+        {
+            continue;
+        }
+        record.entry = table[slot];
+        record.crc = crc32Update(0, &record.entry, sizeof(record.entry));
+        if (snapshot.write((const uint8_t *)&record, sizeof(record)) != sizeof(record))
+        {
+            snapshot.close();
+            LittleFS.remove(CREDENTIAL_JOURNAL_TMP_FILE);
+            LOG_E("[CREDENTIALS] Failed to write journal snapshot");
+            return;
+        }
+        written++;
+    }
+    snapshot.close();
+
+    if (!LittleFS.rename(CREDENTIAL_JOURNAL_TMP_FILE, CREDENTIAL_JOURNAL_FILE))
+    {
+        LittleFS.remove(CREDENTIAL_JOURNAL_TMP_FILE);
+        LOG_E("[CREDENTIALS] Failed to commit journal snapshot");
+        return;
+    }
+    journalRecords = written;
+}
+
+size_t CredentialIndex::readJson(CredentialCursor &cursor, uint8_t *buffer, size_t maxLen)
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    size_t produced = 0;
+    while (produced < maxLen)
+    {
+        if (cursor.pendingPos < cursor.pendingLen)
+        {
+            size_t n = cursor.pendingLen - cursor.pendingPos;
+            if (n > maxLen - produced)
+            {
+                n = maxLen - produced;
+            }
+            memcpy(buffer + produced, cursor.pending + cursor.pendingPos, n);
+            cursor.pendingPos += n;
+            produced += n;
+            continue;
+        }
+
+        if (cursor.finished)
+        {
+            break;
+        }
+
+        int length = 0;
+        if (!cursor.started)
+        {
+            cursor.started = true;
+            length = snprintf(cursor.pending, sizeof(cursor.pending), "[");
+        }
+        else
+        {
+            while (cursor.slot < CREDENTIAL_INDEX_CAPACITY && table[cursor.slot].hash == 0)
+            {
+                cursor.slot++;
+            }
+
+            if (cursor.slot >= CREDENTIAL_INDEX_CAPACITY)
+            {
+                cursor.finished = true;
+                length = snprintf(cursor.pending, sizeof(cursor.pending), "]");
+            }
+            else
+            {
+                const CredentialEntry &entry = table[cursor.slot];
+                length = snprintf(cursor.pending, sizeof(cursor.pending),
+                                  "%s{\"bits\":%u,\"fc\":%lu,\"cn\":\"%s\",\"hex\":\"%s\",\"net2\":%s,"
+                                  "\"first\":%lu,\"last\":%lu,\"count\":%lu}",
+                                  cursor.emitted > 0 ? "," : "", entry.bits, (unsigned long)entry.facilityCode,
+                                  entry.id, entry.hex, entry.net2 ? "true" : "false",
+                                  (unsigned long)entry.firstSeen, (unsigned long)entry.lastSeen,
+                                  (unsigned long)entry.count);
+                cursor.slot++;
+                cursor.emitted++;
+            }
+        }
+
+        if (length < 0)
+        {
+            length = 0;
+        }
+        if ((size_t)length >= sizeof(cursor.pending))
+        {
+            length = sizeof(cursor.pending) - 1;
+        }
+        cursor.pendingLen = length;
+        cursor.pendingPos = 0;
+    }
+
+    return produced;
+}
@@ -1,104 +1,46 @@
 #include "debug_manager.h"
 #include "version_config.h"
 #include "logger.h"
+#include "console_log.h"
+#include "config_manager.h"
 
-const char *DebugManager::DEBUG_CONFIG_FILE = "/www/debug_config.json";
-
-DebugManager::DebugManager() : debugEnabled(true)
+DebugManager::DebugManager() : debugEnabled(true), logLevel(LOG_LEVEL_VERBOSE)
 {
     DEBUG_ENABLED = true;
 }
 
 void DebugManager::begin()
 {
-    if (!LittleFS.exists(DEBUG_CONFIG_FILE))
-    {
-        logger.logDebugStatus("Debug config file not found. Setting defaults...");
-        setDefaultDebug();
-    }
-    else
-    {
-        enableDebug();
-    }
+    enableDebug();
 }
 
 void DebugManager::setDefaultDebug()
 {
-    logger.logDebugStatus("Writing the default debug settings...");
-
-    JsonDocument json;
-    json["DEBUG"] = true;
-
-    File debugFile = LittleFS.open(DEBUG_CONFIG_FILE, "w");
-    if (!debugFile)
-    {
-        logger.logDebugStatus("Failed to open debug config file for writing");
-        // Set debug to true by default if we can't write the file
-        debugEnabled = true;
-        DEBUG_ENABLED = true;
-        return;
-    }
-
-    if (serializeJson(json, debugFile) == 0)
-    {
-        logger.logDebugStatus("Failed to write the data to file");
-    }
-    else
-    {
-        logger.logDebugStatus("Debug config file written successfully");
-    }
-
-    debugFile.close();
-
-    debugEnabled = true;
-    DEBUG_ENABLED = true;
+    logger.logDebugStatus("Restoring the default debug settings...");
+    configManager.restoreDefaults(CONFIG_DEBUG);
+    enableDebug();
 }
 
-bool DebugManager::readDebugConfig()
+void DebugManager::readDebugConfig()
 {
-    File debugFile = LittleFS.open(DEBUG_CONFIG_FILE, "r");
-    if (!debugFile)
-    {
-        logger.logDebugStatus("Failed to open debug config file");
-        // Set debug to true by default if we can't read the file
-        debugEnabled = true;
-        DEBUG_ENABLED = true;
-        return false;
-    }
-
-    // Create JSON document
-    JsonDocument jsonDoc;
-    DeserializationError error = deserializeJson(jsonDoc, debugFile);
-    debugFile.close();
-
-    if (error)
-    {
-        logger.logDebugStatus("Failed to parse debug config file");
-        // Set debug to true by default if we can't parse the file
-        debugEnabled = true;
-        DEBUG_ENABLED = true;
-        return false;
-    }
-
-    debugEnabled = jsonDoc["DEBUG"].as<bool>();
+    DeviceConfig config = configManager.get();
+    debugEnabled = config.debugEnabled;
     DEBUG_ENABLED = debugEnabled;
-    return true;
+    logLevel = config.logLevel;
 }
 
 void DebugManager::enableDebug()
 {
-    if (!readDebugConfig())
-    {
-        return;
-    }
+    readDebugConfig();
 
     if (!debugEnabled)
     {
         logger.logDebugStatus("Debug mode disabled");
-        Serial.end();
+        applyConsoleLevel();
     }
     else
     {
+        applyConsoleLevel();
         logger.logDebugStatus("Debug mode enabled");
     }
 }
@@ -111,48 +53,49 @@ bool DebugManager::updateDebugState(bool newState)
     debugEnabled = newState;
     DEBUG_ENABLED = newState;
 
+    // Serial stays open: the console drain task may be writing to it from
+    // the other core, so output is only gated by the console level
     if (newState)
     {
-        Serial.begin(115200);
+        applyConsoleLevel();
         logger.logDebugStatus("Debug mode enabled");
     }
     else
     {
         logger.logDebugStatus("Debug mode disabled");
-        Serial.end();
+        applyConsoleLevel();
     }
 
-    // Update config file with new state
-    return writeDebugConfig(newState);
+    writeDebugConfig();
+    return true;
 }
 
-bool DebugManager::writeDebugConfig(bool state)
+bool DebugManager::updateLogLevel(uint8_t level)
 {
-    if (!LittleFS.begin())
-    {
-        logger.logDebugStatus("Failed to mount LittleFS");
-        return false;
-    }
+    if (level == logLevel)
+        return true; // No change needed
 
-    JsonDocument json;
-    json["DEBUG"] = state;
+    logLevel = level;
+    applyConsoleLevel();
+    logger.logDebugStatus(debugEnabled ? "Serial log level changed" : "Serial log level saved for when debug is enabled");
 
-    File debugFile = LittleFS.open(DEBUG_CONFIG_FILE, "w");
-    if (!debugFile)
-    {
-        logger.logDebugStatus("Failed to open debug config file for writing");
-        return false;
-    }
+    writeDebugConfig();
+    return true;
+}
 
-    if (serializeJson(json, debugFile) == 0)
-    {
-        logger.logDebugStatus("Failed to write debug config to file");
-        debugFile.close();
-        return false;
-    }
+void DebugManager::applyConsoleLevel()
+{
+    // With debug off nothing reads the serial console, so it takes no lines;
+    // the web console stream sets its own level
+    consoleLog.setSerialLevel(debugEnabled ? logLevel : LOG_LEVEL_NONE);
+}
 
-    debugFile.close();
-    return true;
+void DebugManager::writeDebugConfig()
+{
+    DeviceConfig config = configManager.get();
+    config.debugEnabled = debugEnabled;
+    config.logLevel = logLevel;
+    configManager.commit(config, CONFIG_DEBUG);
 }
 
 DebugManager debugManager;
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "deflate_stream.h"
+#include "crc32.h"
+
+#define DEFLATE_NIL 0xFFFF
+#define DEFLATE_END_OF_BLOCK 256
+
+// Length codes 257..285 and distance codes 0..29 (RFC 1951 section 3.2.5)
+static const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                         3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                           193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                           6145, 8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                           6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static_assert((DEFLATE_WINDOW_SIZE & (DEFLATE_WINDOW_SIZE - 1)) == 0, "Window size must be a power of two");
+static_assert((DEFLATE_HASH_SIZE & (DEFLATE_HASH_SIZE - 1)) == 0, "Hash size must be a power of two");
+static_assert(DEFLATE_WINDOW_SIZE >= DEFLATE_MAX_MATCH && DEFLATE_WINDOW_SIZE <= 32768, "Invalid window size");
+
+DeflateStream::DeflateStream()
+{
+    begin();
+}
+
+void DeflateStream::begin()
+{
+    for (uint16_t i = 0; i < DEFLATE_HASH_SIZE; i++)
+    {
+        head[i] = DEFLATE_NIL;
+    }
+    pos = 0;
+    end = 0;
+    outLen = 0;
+    outPos = 0;
+    bitBuffer = 0;
+    bitCount = 0;
+    crc = 0;
+    totalIn = 0;
+    totalOut = 0;
+    done = false;
+
+    // gzip member header: deflate, no name, no mtime, unknown OS
+    static const uint8_t GZIP_HEADER[10] = {0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF};
+    for (uint8_t i = 0; i < sizeof(GZIP_HEADER); i++)
+    {
+        putByte(GZIP_HEADER[i]);
+    }
+
+    // One fixed-Huffman block carries the whole stream (BFINAL = 0, BTYPE = 01)
+    putBits(0, 1);
+    putBits(1, 2);
+}
+
+void DeflateStream::putBits(uint32_t value, uint8_t count)
+{
+    bitBuffer |= value << bitCount;
+    bitCount += count;
+    while (bitCount >= 8)
+    {
+        out[outLen++] = (uint8_t)bitBuffer;
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void DeflateStream::putCode(uint16_t code, uint8_t length)
+{
+    // Huffman codes are sent most significant bit first
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(reversed, length);
+}
+
+void DeflateStream::putByte(uint8_t value)
+{
+    out[outLen++] = value;
+}
+
+void DeflateStream::alignToByte()
+{
+    if (bitCount > 0)
+    {
+        out[outLen++] = (uint8_t)bitBuffer;
+    }
+    bitBuffer = 0;
+    bitCount = 0;
+}
+
+void DeflateStream::putLiteral(uint16_t symbol)
+{
+    // Fixed literal/length code (RFC 1951 section 3.2.6)
+    if (symbol <= 143)
+    {
+        putCode(0x30 + symbol, 8);
+    }
+    else if (symbol <= 255)
+    {
+        putCode(0x190 + symbol - 144, 9);
+    }
+    else if (symbol <= 279)
+    {
+        putCode(symbol - 256, 7);
+    }
+    else
+    {
+        putCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void DeflateStream::putMatch(uint16_t length, uint16_t distance)
+{
+    uint8_t code = 28;
+    while (LENGTH_BASE[code] > length)
+    {
+        code--;
+    }
+    putLiteral(257 + code);
+    putBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+    code = 29;
+    while (DISTANCE_BASE[code] > distance)
+    {
+        code--;
+    }
+    putCode(code, 5);
+    putBits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+}
+
+uint16_t DeflateStream::hashAt(uint16_t position) const
+{
+    uint32_t key = ((uint32_t)window[position] << 16) | ((uint32_t)window[position + 1] << 8) | window[position + 2];
+    return (uint16_t)((key * 2654435761UL) >> 22) & (DEFLATE_HASH_SIZE - 1);
+}
+
+void DeflateStream::insert(uint16_t position)
+{
+    if (position + DEFLATE_MIN_MATCH > end)
+    {
+        return;
+    }
+    uint16_t hash = hashAt(position);
+    prev[position & (DEFLATE_WINDOW_SIZE - 1)] = head[hash];
+    head[hash] = position;
+}
+
+uint16_t DeflateStream::findMatch(uint16_t &distance) const
+{
+    uint16_t available = end - pos;
+    if (available < DEFLATE_MIN_MATCH)
+    {
+        return 0;
+    }
+    uint16_t maxLength = available < DEFLATE_MAX_MATCH ? available : DEFLATE_MAX_MATCH;
+
+    uint16_t bestLength = 0;
+    uint16_t candidate = head[hashAt(pos)];
+    for (uint8_t chain = 0; chain < DEFLATE_MAX_CHAIN; chain++)
+    {
+        if (candidate == DEFLATE_NIL || candidate >= pos || pos - candidate > DEFLATE_WINDOW_SIZE)
+        {
+            break;
+        }
+
+        uint16_t length = 0;
+        while (length < maxLength && window[candidate + length] == window[pos + length])
+        {
+            length++;
+        }
+        if (length > bestLength)
+        {
+            bestLength = length;
+            distance = pos - candidate;
+            if (length == maxLength)
+            {
+                break;
+            }
+        }
+
+        uint16_t next = prev[candidate & (DEFLATE_WINDOW_SIZE - 1)];
+        if (next >= candidate)
+        {
+            break;
+        }
+        candidate = next;
+    }
+    return bestLength >= DEFLATE_MIN_MATCH ? bestLength : 0;
+}
+
+void DeflateStream::slide()
+{
+    // Keep the last window of history; positions move down by one window
+    memmove(window, window + DEFLATE_WINDOW_SIZE, end - DEFLATE_WINDOW_SIZE);
+    pos -= DEFLATE_WINDOW_SIZE;
+    end -= DEFLATE_WINDOW_SIZE;
+
+    for (uint16_t i = 0; i < DEFLATE_HASH_SIZE; i++)
+    {
+        head[i] = (head[i] != DEFLATE_NIL && head[i] >= DEFLATE_WINDOW_SIZE) ? head[i] - DEFLATE_WINDOW_SIZE
+                                                                             : DEFLATE_NIL;
+    }
+    for (uint16_t i = 0; i < DEFLATE_WINDOW_SIZE; i++)
+    {
+        prev[i] = (prev[i] != DEFLATE_NIL && prev[i] >= DEFLATE_WINDOW_SIZE) ? prev[i] - DEFLATE_WINDOW_SIZE
+                                                                             : DEFLATE_NIL;
+    }
+}
+
+void DeflateStream::finishStream()
+{
+    // Close the data block and add an empty final block
+    putLiteral(DEFLATE_END_OF_BLOCK);
+    putBits(1, 1);
+    putBits(1, 2);
+    putLiteral(DEFLATE_END_OF_BLOCK);
+    alignToByte();
+
+    // gzip trailer: CRC32 and length of the uncompressed data, little endian
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        putByte((uint8_t)(crc >> (8 * i)));
+    }
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        putByte((uint8_t)(totalIn >> (8 * i)));
+    }
+    done = true;
+}
+
+size_t DeflateStream::process(const uint8_t *data, size_t length, bool finish)
+{
+    size_t consumed = 0;
+    while (!done)
+    {
+        // Top up the window, dropping history older than one window
+        if (consumed < length)
+        {
+            if (end == sizeof(window) && pos >= DEFLATE_WINDOW_SIZE)
+            {
+                slide();
+            }
+            size_t n = sizeof(window) - end;
+            if (n > length - consumed)
+            {
+                n = length - consumed;
+            }
+            memcpy(window + end, data + consumed, n);
+            crc = crc32Update(crc, data + consumed, n);
+            totalIn += n;
+            end += n;
+            consumed += n;
+        }
+
+        // Room for the largest step: a match (up to 41 bits) or the trailer
+        if (sizeof(out) - outLen < 16)
+        {
+            break;
+        }
+
+        bool lastInput = finish && consumed == length;
+        uint16_t lookahead = end - pos;
+        if (lookahead < DEFLATE_MAX_MATCH && !lastInput)
+        {
+            break; // Wait for more input so matches are not cut short
+        }
+        if (lookahead == 0)
+        {
+            finishStream();
+            break;
+        }
+
+        uint16_t distance = 0;
+        uint16_t matchLength = findMatch(distance);
+        if (matchLength > 0)
+        {
+            putMatch(matchLength, distance);
+            for (uint16_t i = 0; i < matchLength; i++)
+            {
+                insert(pos + i);
+            }
+            pos += matchLength;
+        }
+        else
+        {
+            putLiteral(window[pos]);
+            insert(pos);
+            pos++;
+        }
+    }
+    return consumed;
+}
+
+size_t DeflateStream::read(uint8_t *buffer, size_t maxLen)
+{
+    size_t n = outLen - outPos;
+    if (n > maxLen)
+    {
+        n = maxLen;
+    }
+    memcpy(buffer, out + outPos, n);
+    outPos += n;
+    totalOut += n;
+    if (outPos == outLen)
+    {
+        outPos = 0;
+        outLen = 0;
+    }
+    return n;
+}
@@ -1,9 +1,11 @@
 #include "email_manager.h"
 #include "logger.h"
 #include <base64.h>
-#include <LittleFS.h>
-#include <ArduinoJson.h>
 #include <WiFiClientSecure.h>
+#include "config_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_EMAIL
 
 // Define static members
 bool EmailManager::enable_email = false;
@@ -450,61 +452,25 @@ void EmailManager::flushPinBuffer(const String &ssid)
 
 void EmailManager::readConfig()
 {
-    Serial.println("======================================================================");
-    Serial.println("[NOTIFICATION CONFIG] Loading notification preferences...");
-    File file = LittleFS.open(NOTIFICATION_CONFIG_FILE, "r");
-    if (!file)
+    LOG_SEPARATOR();
+    LOG_I("[NOTIFICATION CONFIG] Loading notification preferences...");
+    NotificationConfig config = configManager.get().notifications;
+
+    if (config.enableEmail)
     {
-        Serial.println("[NOTIFICATION CONFIG] Failed to open configuration file");
-        is_configured = false;
+        strlcpy(smtp_host, config.smtpHost, sizeof(smtp_host));
+        strlcpy(smtp_port, config.smtpPort, sizeof(smtp_port));
+        strlcpy(smtp_user, config.smtpUser, sizeof(smtp_user));
+        strlcpy(smtp_pass, config.smtpPass, sizeof(smtp_pass));
+        strlcpy(smtp_recipient, config.smtpRecipient, sizeof(smtp_recipient));
+
+        LOG_I("[NOTIFICATION CONFIG] Email notifications enabled");
+        is_configured = true;
     }
     else
     {
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, file);
-        file.close();
-
-        if (error)
-        {
-            Serial.println("[NOTIFICATION CONFIG] Failed to parse configuration file");
-            is_configured = false;
-        }
-        else
-        {
-            // Handle both string and boolean values for enable_email
-            bool enable_email = false;
-            if (doc["enable_email"].is<bool>())
-            {
-                enable_email = doc["enable_email"].as<bool>();
-            }
-            else if (doc["enable_email"].is<const char *>())
-            {
-                enable_email = strcmp(doc["enable_email"].as<const char *>(), "true") == 0;
-            }
-
-            if (enable_email)
-            {
-                strncpy(smtp_host, doc["smtp_host"], sizeof(smtp_host) - 1);
-                strncpy(smtp_port, doc["smtp_port"], sizeof(smtp_port) - 1);
-                strncpy(smtp_user, doc["smtp_user"], sizeof(smtp_user) - 1);
-                strncpy(smtp_pass, doc["smtp_pass"], sizeof(smtp_pass) - 1);
-                strncpy(smtp_recipient, doc["smtp_recipient"], sizeof(smtp_recipient) - 1);
-
-                smtp_host[sizeof(smtp_host) - 1] = '\0';
-                smtp_port[sizeof(smtp_port) - 1] = '\0';
-                smtp_user[sizeof(smtp_user) - 1] = '\0';
-                smtp_pass[sizeof(smtp_pass) - 1] = '\0';
-                smtp_recipient[sizeof(smtp_recipient) - 1] = '\0';
-
-                Serial.println("[NOTIFICATION CONFIG] Email notifications enabled");
-                is_configured = true;
-            }
-            else
-            {
-                Serial.println("[NOTIFICATION CONFIG] Email notifications disabled");
-                is_configured = false;
-            }
-        }
+        LOG_I("[NOTIFICATION CONFIG] Email notifications disabled");
+        is_configured = false;
     }
 }
 
@@ -44,124 +44,53 @@ void GPIOManager::begin()
         // Initialize GPIO hardware first
         initializeGPIO();
 
-        // Load and apply saved settings
-        if (!loadConfig())
-        {
-            // If loading fails, apply safe defaults
-            pin35Enabled = false;
-            pin36Enabled = false;
-            pin35DefaultHigh = false;
-            pin36DefaultHigh = false;
-            pin35PulseDuration = 1000;
-            pin36PulseDuration = 1000;
-
-            // Save these defaults
-            saveConfig();
-        }
+        // Apply saved settings and follow later changes
+        applyConfig(configManager.get().gpio);
+        configManager.subscribe(CONFIG_GPIO, onConfigChanged, true);
 
         initialized = true;
     }
 }
 
-bool GPIOManager::loadConfig()
+void GPIOManager::onConfigChanged(uint32_t sections, const DeviceConfig &config)
 {
-    if (!LittleFS.exists(CONFIG_FILE))
-    {
-        // Create default config file if it doesn't exist
-        JsonDocument doc;
-        doc["pin35_enabled"] = false;
-        doc["pin36_enabled"] = false;
-        doc["pin35_default_high"] = false;
-        doc["pin36_default_high"] = false;
-        doc["pin35_pulse_duration"] = 1000;
-        doc["pin36_pulse_duration"] = 1000;
-
-        File file = LittleFS.open(CONFIG_FILE, "w");
-        if (!file || serializeJson(doc, file) == 0)
-        {
-            if (file)
-                file.close();
-            return false;
-        }
-        file.close();
-    }
-
-    File file = LittleFS.open(CONFIG_FILE, "r");
-    if (!file)
-    {
-        return false;
-    }
-
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-
-    if (error)
-    {
-        return false;
-    }
+    getInstance().applyConfig(config.gpio);
+}
 
-    // Load settings from file
-    pin35Enabled = doc["pin35_enabled"] | false;
-    pin36Enabled = doc["pin36_enabled"] | false;
-    pin35DefaultHigh = doc["pin35_default_high"] | false;
-    pin36DefaultHigh = doc["pin36_default_high"] | false;
-    pin35PulseDuration = doc["pin35_pulse_duration"] | 1000;
-    pin36PulseDuration = doc["pin36_pulse_duration"] | 1000;
+void GPIOManager::applyConfig(const GpioConfig &config)
+{
+    pin35Enabled = config.pin35Enabled;
+    pin36Enabled = config.pin36Enabled;
+    pin35DefaultHigh = config.pin35DefaultHigh;
+    pin36DefaultHigh = config.pin36DefaultHigh;
+    pin35PulseDuration = config.pin35PulseMs;
+    pin36PulseDuration = config.pin36PulseMs;
+    pin35Pulsing = false; // Reset pulse state
+    pin36Pulsing = false;
 
-    // Apply loaded settings to the card processor
+    // Apply settings to the card processor
     cardProcessor.setPin35OnCardRead(pin35Enabled);
     cardProcessor.setPin36OnCardRead(pin36Enabled);
 
-    // Apply loaded settings to GPIO pins
+    // Apply settings to GPIO pins
     gpio_set_level(GPIO_PIN_35, pin35Enabled && pin35DefaultHigh ? 1 : 0);
     gpio_set_level(GPIO_PIN_36, pin36Enabled && pin36DefaultHigh ? 1 : 0);
-
-    return true;
-}
-
-bool GPIOManager::saveConfig()
-{
-    JsonDocument doc;
-    doc["pin35_enabled"] = pin35Enabled;
-    doc["pin36_enabled"] = pin36Enabled;
-    doc["pin35_default_high"] = pin35DefaultHigh;
-    doc["pin36_default_high"] = pin36DefaultHigh;
-    doc["pin35_pulse_duration"] = pin35PulseDuration;
-    doc["pin36_pulse_duration"] = pin36PulseDuration;
-
-    File file = LittleFS.open(CONFIG_FILE, "w");
-    if (!file)
-    {
-        return false;
-    }
-
-    if (serializeJson(doc, file) == 0)
-    {
-        file.close();
-        return false;
-    }
-
-    file.close();
-    return true;
 }
 
 void GPIOManager::setPin35Enabled(bool enabled, bool defaultHigh)
 {
-    pin35Enabled = enabled;
-    pin35DefaultHigh = defaultHigh;
-    pin35Pulsing = false; // Reset pulse state
-    gpio_set_level(GPIO_PIN_35, enabled && defaultHigh ? 1 : 0);
-    saveConfig();
+    DeviceConfig config = configManager.get();
+    config.gpio.pin35Enabled = enabled;
+    config.gpio.pin35DefaultHigh = defaultHigh;
+    configManager.commit(config, CONFIG_GPIO);
 }
 
 void GPIOManager::setPin36Enabled(bool enabled, bool defaultHigh)
 {
-    pin36Enabled = enabled;
-    pin36DefaultHigh = defaultHigh;
-    pin36Pulsing = false; // Reset pulse state
-    gpio_set_level(GPIO_PIN_36, enabled && defaultHigh ? 1 : 0);
-    saveConfig();
+    DeviceConfig config = configManager.get();
+    config.gpio.pin36Enabled = enabled;
+    config.gpio.pin36DefaultHigh = defaultHigh;
+    configManager.commit(config, CONFIG_GPIO);
 }
 
 bool GPIOManager::isPin35Enabled() const
@@ -186,14 +115,16 @@ bool GPIOManager::getPin36DefaultHigh() const
 
 void GPIOManager::setPin35PulseDuration(int duration)
 {
-    pin35PulseDuration = duration;
-    saveConfig();
+    DeviceConfig config = configManager.get();
+    config.gpio.pin35PulseMs = duration;
+    configManager.commit(config, CONFIG_GPIO);
 }
 
 void GPIOManager::setPin36PulseDuration(int duration)
 {
-    pin36PulseDuration = duration;
-    saveConfig();
+    DeviceConfig config = configManager.get();
+    config.gpio.pin36PulseMs = duration;
+    configManager.commit(config, CONFIG_GPIO);
 }
 
 int GPIOManager::getPin35PulseDuration() const
@@ -278,15 +209,7 @@ void GPIOManager::loop()
 
 void GPIOManager::resetToDefaults()
 {
-    pin35Enabled = false;
-    pin36Enabled = false;
-    pin35DefaultHigh = false;
-    pin36DefaultHigh = false;
-    pin35PulseDuration = 1000;
-    pin36PulseDuration = 1000;
-    gpio_set_level(GPIO_PIN_35, 0);
-    gpio_set_level(GPIO_PIN_36, 0);
-    saveConfig();
+    configManager.restoreDefaults(CONFIG_GPIO);
 }
 
 bool GPIOManager::isInitialized() const
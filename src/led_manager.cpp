@@ -42,31 +42,52 @@ bool LEDManager::getCurrentState() const
     return currentState;
 }
 
+// Startup pattern: off, three quick blinks, a pause, then one long blink
+static const struct
+{
+    uint8_t level;
+    uint16_t durationMs;
+} STARTUP_STEPS[] = {
+    {LED_OFF, 2000},
+    {LED_ON, 100},
+    {LED_OFF, 100},
+    {LED_ON, 100},
+    {LED_OFF, 100},
+    {LED_ON, 100},
+    {LED_OFF, 600},
+    {LED_ON, 1000},
+    {LED_OFF, 0},
+};
+
+static const int STARTUP_STEP_COUNT = sizeof(STARTUP_STEPS) / sizeof(STARTUP_STEPS[0]);
+
 void LEDManager::runStartupSequence()
 {
-    // Initial state - LED off
-    digitalWrite(C_PIN_LED, LED_OFF);
-    delay(2000);
+    // Played by update() so boot does not wait on it
+    startupStep = 0;
+    startupStepTime = millis();
+    digitalWrite(C_PIN_LED, STARTUP_STEPS[0].level);
+}
 
-    // Three quick blinks
-    for (int i = 0; i < 3; i++)
+void LEDManager::updateStartupSequence()
+{
+    unsigned long currentTime = millis();
+    while (startupStep >= 0 && currentTime - startupStepTime >= STARTUP_STEPS[startupStep].durationMs)
     {
-        digitalWrite(C_PIN_LED, LED_ON);
-        delay(100);
-        digitalWrite(C_PIN_LED, LED_OFF);
-        delay(100);
+        startupStepTime += STARTUP_STEPS[startupStep].durationMs;
+        startupStep++;
+        if (startupStep >= STARTUP_STEP_COUNT)
+        {
+            startupStep = -1;
+            return;
+        }
+        digitalWrite(C_PIN_LED, STARTUP_STEPS[startupStep].level);
     }
-
-    delay(500);
-
-    // Final state - LED on for 1 second then off
-    digitalWrite(C_PIN_LED, LED_ON);
-    delay(1000);
-    digitalWrite(C_PIN_LED, LED_OFF);
 }
 
 void LEDManager::signalResetArmed()
 {
+    startupStep = -1; // Cut the startup pattern short
     sequenceStartTime = millis();
     sequenceStep = 0;
     inSequence = true;
@@ -76,6 +97,7 @@ void LEDManager::signalResetArmed()
 
 void LEDManager::signalResetExecuted()
 {
+    startupStep = -1; // Cut the startup pattern short
     sequenceStartTime = millis();
     sequenceStep = 0;
     inSequence = true;
@@ -85,6 +107,7 @@ void LEDManager::signalResetExecuted()
 
 void LEDManager::signalResetTimeout()
 {
+    startupStep = -1; // Cut the startup pattern short
     sequenceStartTime = millis();
     sequenceStep = 0;
     inSequence = true;
@@ -94,6 +117,12 @@ void LEDManager::signalResetTimeout()
 
 void LEDManager::update()
 {
+    if (startupStep >= 0)
+    {
+        updateStartupSequence();
+        return;
+    }
+
     if (!inSequence)
         return;
 
@@ -1,9 +1,15 @@
 #include "logger.h"
-#include <LittleFS.h>
 #include <time.h>
-#include <ArduinoJson.h>
 #include "wiegand_interface.h" // For accessing raw databits in debug
 #include "keypad_processor.h"
+#include "card_log_manager.h"
+#include "card_stream.h"
+#include "storage_manager.h"
+#include "clock_manager.h"
+#include "reset_card_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_LOGGER
 
 enum class MessageType
 {
@@ -38,8 +44,7 @@ Logger &logger = Logger::getInstance();
 
 void Logger::log(const char *message)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    Serial.println(message);
+    LOG_I("%s", message);
 }
 
 const char *Logger::getCurrentTime()
@@ -58,7 +63,7 @@ const char *Logger::getCurrentTime()
 
 void Logger::consoleLog()
 {
-    Serial.println("======================================================================");
+    LOG_SEPARATOR();
 
     unsigned int bits = cardProcessor.getBitCount();
 
@@ -94,237 +99,159 @@ void Logger::consoleLog()
 
 void Logger::logCardDataNet2()
 {
-    Serial.print("[CARD READ] Format: ");
-    Serial.print(cardProcessor.getCardFormat());
-    Serial.print(", FC = ");
-    Serial.print(cardProcessor.getFacilityCode());
-    Serial.print(", CN = ");
-    Serial.print(cardProcessor.getCardNumber());
-    Serial.print(", HEX = ");
-    Serial.print(cardProcessor.getNet2HexEM410x());
-    Serial.print(", BIN = ");
-    Serial.println(cardProcessor.getDataStreamBIN());
+    LOG_I("[CARD READ] Format: %s, FC = %lu, CN = %lu, HEX = %s, BIN = %s",
+          cardProcessor.getCardFormat().c_str(), cardProcessor.getFacilityCode(),
+          cardProcessor.getCardNumber(), cardProcessor.getNet2HexEM410x().c_str(),
+          cardProcessor.getDataStreamBIN().c_str());
 }
 
 void Logger::logCardDataStandard()
 {
-    Serial.print("[CARD READ] Format: ");
-    Serial.print(cardProcessor.getCardFormat());
-    Serial.print(", Bits: ");
-    Serial.print(cardProcessor.getBitCount());
-    Serial.print(", FC = ");
-    Serial.print(cardProcessor.getFacilityCode());
-    Serial.print(", CN = ");
-    Serial.print(cardProcessor.getCardNumber());
-    Serial.print(", HEX = ");
-    Serial.print(cardProcessor.getCsvHEX());
-    Serial.print(", BIN = ");
-    Serial.println(cardProcessor.getDataStreamBIN());
+    LOG_I("[CARD READ] Format: %s, Bits: %u, FC = %lu, CN = %lu, HEX = %s, BIN = %s",
+          cardProcessor.getCardFormat().c_str(), cardProcessor.getBitCount(),
+          cardProcessor.getFacilityCode(), cardProcessor.getCardNumber(),
+          cardProcessor.getCsvHEX().c_str(), cardProcessor.getDataStreamBIN().c_str());
 }
 
 void Logger::logCardDataPIV()
 {
-    Serial.print("[CARD READ] Format: ");
-    Serial.print(cardProcessor.getCardFormat());
-    Serial.print(", Bits: ");
     if (cardProcessor.getFacilityCode() >= 512)
     {
-        Serial.print("PIV/MF");
-        Serial.print(", FC = UID");
-        Serial.print(", CN = ");
-        Serial.print(cardProcessor.getReversedPairsUID());
-        Serial.print(", HEX = ");
-        Serial.print(cardProcessor.getCsvHEX());
-        Serial.print(", BIN = ");
-        Serial.println(cardProcessor.getDataStreamBIN());
+        LOG_I("[CARD READ] Format: %s, Bits: PIV/MF, FC = UID, CN = %s, HEX = %s, BIN = %s",
+              cardProcessor.getCardFormat().c_str(), cardProcessor.getReversedPairsUID().c_str(),
+              cardProcessor.getCsvHEX().c_str(), cardProcessor.getDataStreamBIN().c_str());
     }
     else
     {
-        Serial.print(cardProcessor.getBitCount());
-        Serial.print(", FC = ");
-        Serial.print(cardProcessor.getFacilityCode());
-        Serial.print(", CN = ");
-        Serial.print(cardProcessor.getCardNumber());
-        Serial.print(", HEX = ");
-        Serial.print(cardProcessor.getCsvHEX());
-        Serial.print(", BIN = ");
-        Serial.println(cardProcessor.getDataStreamBIN());
+        logCardDataStandard();
     }
 }
 
 void Logger::logCardDataKeypad()
 {
     int keyNum = cardProcessor.getKeypadNumber();
-    Serial.print("[PAXTON PIN] Format: ");
-    Serial.print(cardProcessor.getCardFormat());
-    Serial.print(", Key = ");
-    Serial.print(keypadProcessor.getKeyChar(keyNum));
-    Serial.print(", HEX = ");
-    Serial.print(cardProcessor.getCsvHEX());
-    Serial.print(", BIN = ");
-    Serial.println(cardProcessor.getDataStreamBIN());
+    LOG_I("[PAXTON PIN] Format: %s, Key = %s, HEX = %s, BIN = %s",
+          cardProcessor.getCardFormat().c_str(), keypadProcessor.getKeyChar(keyNum).c_str(),
+          cardProcessor.getCsvHEX().c_str(), cardProcessor.getDataStreamBIN().c_str());
 }
 
 void Logger::logCardDataPIN()
 {
-    Serial.print("[PIN READ] Format: ");
-    Serial.print(cardProcessor.getCardFormat());
-    Serial.print(", Code = ");
-    if (cardProcessor.getBitHolder1() == 10)
+    char code[12] = "";
+    unsigned long key = cardProcessor.getBitHolder1();
+    if (key == 10)
     {
-        Serial.print("*");
+        strcpy(code, "*");
     }
-    else if (cardProcessor.getBitHolder1() == 11)
+    else if (key == 11)
     {
-        Serial.print("#");
+        strcpy(code, "#");
     }
-    else if (cardProcessor.getBitHolder1() >= 0 && cardProcessor.getBitHolder1() <= 9)
+    else if (key <= 9)
     {
-        Serial.print(cardProcessor.getBitHolder1());
+        snprintf(code, sizeof(code), "%lu", key);
     }
-    Serial.print(", BIN = ");
-    Serial.println(cardProcessor.getDataStreamBIN());
+    LOG_I("[PIN READ] Format: %s, Code = %s, BIN = %s", cardProcessor.getCardFormat().c_str(), code,
+          cardProcessor.getDataStreamBIN().c_str());
 }
 
 void Logger::logCardDataError()
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    Serial.println("[CARD READ] ERROR: Bad Card Read! Card data won't be displayed in the web log, but the data will be stored within the CSV file.");
-    Serial.println("[CARD READ] POSSIBLE ISSUES:");
-    Serial.println("[CARD READ]    (1) Card passed through the reader too quickly");
-    Serial.println("[CARD READ]    (2) Loose GPIO connection(s)");
-    Serial.println("[CARD READ]    (3) Electromagnetic interference (EMI)");
-    Serial.println("[CARD READ]    (4) No available parser for card.");
-    Serial.println("[CARD READ] Below is the bad data:");
-    Serial.print("[CARD READ] Card Bits: ");
-    Serial.print(cardProcessor.getBitCount());
-    Serial.print(", FC = ");
-    Serial.print(cardProcessor.getFacilityCode());
-    Serial.print(", CN = ");
-    Serial.print(cardProcessor.getCardNumber());
-    Serial.print(", HEX = ");
-    Serial.print(cardProcessor.getCsvHEX());
-    Serial.print(", BIN = ");
-    Serial.println(cardProcessor.getDataStreamBIN());
-
-    File csvCards = LittleFS.open(CARDS_CSV_FILE, "a");
-    if (!csvCards)
+    LOG_E("[CARD READ] ERROR: Bad Card Read! Card data won't be displayed in the web log, but the data will be stored within the CSV file.");
+    LOG_W("[CARD READ] POSSIBLE ISSUES:");
+    LOG_W("[CARD READ]    (1) Card passed through the reader too quickly");
+    LOG_W("[CARD READ]    (2) Loose GPIO connection(s)");
+    LOG_W("[CARD READ]    (3) Electromagnetic interference (EMI)");
+    LOG_W("[CARD READ]    (4) No available parser for card.");
+    LOG_W("[CARD READ] Below is the bad data:");
+    LOG_W("[CARD READ] Card Bits: %u, FC = %lu, CN = %lu, HEX = %s, BIN = %s",
+          cardProcessor.getBitCount(), cardProcessor.getFacilityCode(), cardProcessor.getCardNumber(),
+          cardProcessor.getCsvHEX().c_str(), cardProcessor.getDataStreamBIN().c_str());
+
+    char record[CARD_LOG_MAX_RECORD];
+    int length = snprintf(record, sizeof(record),
+                          "DATA_TYPE: NO_PARSER, Bit_Length: %u, Hex_Value: N/A, Facility_Code: N/A, Card_Number: N/A, BIN: %s",
+                          cardProcessor.getBitCount(), cardProcessor.getDataStreamBIN().c_str());
+    appendCardRecord(record, length);
+}
+
+void Logger::appendCardRecord(const char *record, int length)
+{
+    if (length < 0)
     {
-        Serial.print("[LOG] There was an error opening ");
-        Serial.println(CARDS_CSV_FILE);
         return;
     }
+    if (length >= CARD_LOG_MAX_RECORD)
+    {
+        length = CARD_LOG_MAX_RECORD - 1;
+    }
 
-    csvCards.print("DATA_TYPE: NO_PARSER");
-    csvCards.print(", Bit_Length: ");
-    csvCards.print(cardProcessor.getBitCount());
-    csvCards.print(", Hex_Value: N/A");
-    csvCards.print(", Facility_Code: N/A");
-    csvCards.print(", Card_Number: N/A");
-    csvCards.print(", BIN: ");
-    csvCards.print(cardProcessor.getDataStreamBIN());
-    csvCards.print("\n");
-    csvCards.close();
+    // Queued for the storage task - the flash write happens off the capture path.
+    // The capture time is taken now, as the frame has just completed.
+    uint32_t timestamp = clockManager.now();
+    uint32_t seq = storageManager.appendCardRecord(record, length, timestamp);
+    if (seq == 0)
+    {
+        LOG_E("[LOG] There was an error queuing the card record");
+        return;
+    }
+    cardStream.publish(seq, timestamp, record, length);
 }
 
 void Logger::writeCardLog()
 {
-    Serial.print("[LOG] Logging card data to ");
-    Serial.println(CARDS_CSV_FILE);
-    File csvCards = LittleFS.open(CARDS_CSV_FILE, "a");
+    LOG_D("[LOG] Logging card data to the card log");
 
-    if (!csvCards)
-    {
-        Serial.print("[LOG] There was an error opening ");
-        Serial.println(CARDS_CSV_FILE);
-        return;
-    }
+    char record[CARD_LOG_MAX_RECORD];
+    int length;
+    unsigned int bits = cardProcessor.getBitCount();
 
     if (cardProcessor.isNet2Card())
     {
-        csvCards.print("DATA_TYPE: PAXTON");
-        csvCards.print(", Format: ");
-        csvCards.print(cardProcessor.getCardFormat());
-        csvCards.print(", Bit_Length: 75");
-        csvCards.print(", Hex_Value: ");
-        csvCards.print(cardProcessor.getNet2HexEM410x());
-        csvCards.print(", Facility_Code: N/A");
-        csvCards.print(", Card_Number: ");
-        csvCards.print(cardProcessor.getCardNumber(), DEC);
-        csvCards.print(", BIN: ");
-        csvCards.print(cardProcessor.getDataStreamBIN());
+        length = snprintf(record, sizeof(record),
+                          "DATA_TYPE: PAXTON, Format: %s, Bit_Length: 75, Hex_Value: %s, Facility_Code: N/A, Card_Number: %lu, BIN: %s",
+                          cardProcessor.getCardFormat().c_str(), cardProcessor.getNet2HexEM410x().c_str(),
+                          cardProcessor.getCardNumber(), cardProcessor.getDataStreamBIN().c_str());
     }
-    else if ((cardProcessor.getBitCount() == 26 || cardProcessor.getBitCount() == 27 ||
-              cardProcessor.getBitCount() == 28 || cardProcessor.getBitCount() == 29 ||
-              cardProcessor.getBitCount() == 30 || cardProcessor.getBitCount() == 31 ||
-              cardProcessor.getBitCount() == 33 || cardProcessor.getBitCount() == 34 ||
-              cardProcessor.getBitCount() == 35 || cardProcessor.getBitCount() == 36 ||
-              cardProcessor.getBitCount() == 37 || cardProcessor.getBitCount() == 46 ||
-              cardProcessor.getBitCount() == 48 || cardProcessor.getBitCount() == 50 ||
-              cardProcessor.getBitCount() == 56) &&
-             cardProcessor.getBitCount() != 32)
+    else if ((bits == 26 || bits == 27 || bits == 28 || bits == 29 || bits == 30 ||
+              bits == 31 || bits == 33 || bits == 34 || bits == 35 || bits == 36 ||
+              bits == 37 || bits == 46 || bits == 48 || bits == 50 || bits == 56) &&
+             bits != 32)
     {
-        csvCards.print("DATA_TYPE: CARD");
-        csvCards.print(", Format: ");
-        csvCards.print(cardProcessor.getCardFormat());
-        csvCards.print(", Bit_Length: ");
-        csvCards.print(cardProcessor.getBitCount());
-        csvCards.print(", Hex_Value: ");
-        csvCards.print(cardProcessor.getCsvHEX());
-        csvCards.print(", Facility_Code: ");
-        csvCards.print(cardProcessor.getFacilityCode(), DEC);
-        csvCards.print(", Card_Number: ");
-        csvCards.print(cardProcessor.getCardNumber(), DEC);
-        csvCards.print(", BIN: ");
-        csvCards.print(cardProcessor.getDataStreamBIN());
+        length = snprintf(record, sizeof(record),
+                          "DATA_TYPE: CARD, Format: %s, Bit_Length: %u, Hex_Value: %s, Facility_Code: %lu, Card_Number: %lu, BIN: %s",
+                          cardProcessor.getCardFormat().c_str(), bits, cardProcessor.getCsvHEX().c_str(),
+                          cardProcessor.getFacilityCode(), cardProcessor.getCardNumber(),
+                          cardProcessor.getDataStreamBIN().c_str());
     }
-    else if (cardProcessor.getBitCount() == 32)
+    else if (bits == 32)
     {
-        csvCards.print("DATA_TYPE: CARD");
-        csvCards.print(", Format: ");
-        csvCards.print(cardProcessor.getCardFormat());
-        csvCards.print(", Bit_Length: ");
         if (cardProcessor.getFacilityCode() >= 512)
         {
-            csvCards.print("PIV/MF");
-            csvCards.print(", Hex_Value: ");
-            csvCards.print(cardProcessor.getCsvHEX());
-            csvCards.print(", Facility_Code: N/A");
-            csvCards.print(", Card_Number: ");
-            csvCards.print(cardProcessor.getReversedPairsUID());
+            length = snprintf(record, sizeof(record),
+                              "DATA_TYPE: CARD, Format: %s, Bit_Length: PIV/MF, Hex_Value: %s, Facility_Code: N/A, Card_Number: %s, BIN: %s",
+                              cardProcessor.getCardFormat().c_str(), cardProcessor.getCsvHEX().c_str(),
+                              cardProcessor.getReversedPairsUID().c_str(), cardProcessor.getDataStreamBIN().c_str());
         }
         else
         {
-            csvCards.print(cardProcessor.getBitCount());
-            csvCards.print(", Hex_Value: ");
-            csvCards.print(cardProcessor.getCsvHEX());
-            csvCards.print(", Facility_Code: ");
-            csvCards.print(cardProcessor.getFacilityCode(), DEC);
-            csvCards.print(", Card_Number: ");
-            csvCards.print(cardProcessor.getCardNumber(), DEC);
+            length = snprintf(record, sizeof(record),
+                              "DATA_TYPE: CARD, Format: %s, Bit_Length: %u, Hex_Value: %s, Facility_Code: %lu, Card_Number: %lu, BIN: %s",
+                              cardProcessor.getCardFormat().c_str(), bits, cardProcessor.getCsvHEX().c_str(),
+                              cardProcessor.getFacilityCode(), cardProcessor.getCardNumber(),
+                              cardProcessor.getDataStreamBIN().c_str());
         }
-        csvCards.print(", BIN: ");
-        csvCards.print(cardProcessor.getDataStreamBIN());
     }
     else
     {
-        csvCards.print("DATA_TYPE: UNKNOWN_FORMAT");
-        csvCards.print(", Format: ");
-        csvCards.print(cardProcessor.getCardFormat());
-        csvCards.print(", Bit_Length: ");
-        csvCards.print(cardProcessor.getBitCount());
-        csvCards.print(", Hex_Value: ");
-        csvCards.print(cardProcessor.getCsvHEX());
-        csvCards.print(", Facility_Code: ");
-        csvCards.print(cardProcessor.getFacilityCode(), DEC);
-        csvCards.print(", Card_Number: ");
-        csvCards.print(cardProcessor.getCardNumber(), DEC);
-        csvCards.print(", BIN: ");
-        csvCards.print(cardProcessor.getDataStreamBIN());
+        length = snprintf(record, sizeof(record),
+                          "DATA_TYPE: UNKNOWN_FORMAT, Format: %s, Bit_Length: %u, Hex_Value: %s, Facility_Code: %lu, Card_Number: %lu, BIN: %s",
+                          cardProcessor.getCardFormat().c_str(), bits, cardProcessor.getCsvHEX().c_str(),
+                          cardProcessor.getFacilityCode(), cardProcessor.getCardNumber(),
+                          cardProcessor.getDataStreamBIN().c_str());
     }
 
-    csvCards.print("\n");
-    csvCards.close();
+    appendCardRecord(record, length);
 }
 
 void Logger::writePinLog()
@@ -345,170 +272,107 @@ void Logger::writePinLog()
     }
     else
     {
-        Serial.println("[LOG] ERROR: PIN code not read");
+        LOG_E("[LOG] ERROR: PIN code not read");
     }
 
-    Serial.print("[LOG] Logging PIN code to ");
-    Serial.println(CARDS_CSV_FILE);
-    File csvCards = LittleFS.open(CARDS_CSV_FILE, "a");
-
-    if (!csvCards)
-    {
-        Serial.print("[LOG] There was an error opening ");
-        Serial.println(CARDS_CSV_FILE);
-        return;
-    }
+    LOG_D("[LOG] Logging PIN code to the card log");
 
-    csvCards.print("DATA_TYPE: KEYPAD");
-    csvCards.print(", Format: ");
-    csvCards.print(cardProcessor.getCardFormat());
-    csvCards.print(", Bit_Length: PIN");
-    csvCards.print(", Hex_Value: N/A");
-    csvCards.print(", Facility_Code: N/A");
-    csvCards.print(", Card_Number: ");
-    csvCards.print(pinCode);
-    csvCards.print(", BIN: ");
-    csvCards.print(cardProcessor.getDataStreamBIN());
-    csvCards.print("\n");
-    csvCards.close();
+    char record[CARD_LOG_MAX_RECORD];
+    int length = snprintf(record, sizeof(record),
+                          "DATA_TYPE: KEYPAD, Format: %s, Bit_Length: PIN, Hex_Value: N/A, Facility_Code: N/A, Card_Number: %s, BIN: %s",
+                          cardProcessor.getCardFormat().c_str(), pinCode.c_str(),
+                          cardProcessor.getDataStreamBIN().c_str());
+    appendCardRecord(record, length);
 }
 
 void Logger::writeKeypadLog()
 {
-    File csvCards = LittleFS.open(CARDS_CSV_FILE, "a");
-
-    if (!csvCards)
-    {
-        Serial.println("[LOG] Error: Unable to open cards.csv for Paxton keypad logging");
-        return;
-    }
-
     int keyNum = cardProcessor.getKeypadNumber();
     String keyChar = keypadProcessor.getKeyChar(keyNum);
 
-    csvCards.print("DATA_TYPE: PAXTON_KEYPAD");
-    csvCards.print(", Format: ");
-    csvCards.print(cardProcessor.getCardFormat());
-    csvCards.print(", Bit_Length: ");
-    csvCards.print(cardProcessor.getBitCount());
-    csvCards.print(", Hex_Value: ");
-    csvCards.print(cardProcessor.getCsvHEX());
-    csvCards.print(", Facility_Code: N/A");
-    csvCards.print(", Key_Press: ");
-    csvCards.print(keyChar);
-    csvCards.print(", BIN: ");
-    csvCards.print(cardProcessor.getDataStreamBIN());
-    csvCards.print("\n");
-    csvCards.close();
+    char record[CARD_LOG_MAX_RECORD];
+    int length = snprintf(record, sizeof(record),
+                          "DATA_TYPE: PAXTON_KEYPAD, Format: %s, Bit_Length: %u, Hex_Value: %s, Facility_Code: N/A, Key_Press: %s, BIN: %s",
+                          cardProcessor.getCardFormat().c_str(), cardProcessor.getBitCount(),
+                          cardProcessor.getCsvHEX().c_str(), keyChar.c_str(),
+                          cardProcessor.getDataStreamBIN().c_str());
+    appendCardRecord(record, length);
 }
 
 void Logger::logStartupBanner(const char *device, const char *version, const char *builddate, const char *hardware)
 {
-    Serial.println("======================================================================");
-    Serial.println(device);
-    Serial.println("Copyright (c) 2025: Mayweather Group, LLC");
-    Serial.print("Firmware Version: ");
-    Serial.println(version);
-    Serial.print("Build Date: ");
-    Serial.println(builddate);
-    Serial.print("Hardware REV: ");
-    Serial.println(hardware);
-    Serial.println("Firmware & Hardware: @tweathers-sec (GitHub) @tweathers_sec (X.com)");
-    Serial.println("======================================================================");
-    Serial.println("LEGAL DISCLAIMER:");
-    Serial.println("This device is intended for professional penetration testing only.");
-    Serial.println("Unauthorized or illegal use/possession of this device is the sole");
-    Serial.println("responsibility of the user. Mayweather Group LLC, Practical Physical");
-    Serial.println("Exploitation, and the creator are not liable for illegal application");
-    Serial.println("of this device.");
+    ::consoleLog.println("======================================================================");
+    ::consoleLog.println(device);
+    ::consoleLog.println("Copyright (c) 2025: Mayweather Group, LLC");
+    ::consoleLog.printf("Firmware Version: %s", version);
+    ::consoleLog.printf("Build Date: %s", builddate);
+    ::consoleLog.printf("Hardware REV: %s", hardware);
+    ::consoleLog.println("Firmware & Hardware: @tweathers-sec (GitHub) @tweathers_sec (X.com)");
+    ::consoleLog.println("======================================================================");
+    ::consoleLog.println("LEGAL DISCLAIMER:");
+    ::consoleLog.println("This device is intended for professional penetration testing only.");
+    ::consoleLog.println("Unauthorized or illegal use/possession of this device is the sole");
+    ::consoleLog.println("responsibility of the user. Mayweather Group LLC, Practical Physical");
+    ::consoleLog.println("Exploitation, and the creator are not liable for illegal application");
+    ::consoleLog.println("of this device.");
     lastMessageType = MessageType::STARTUP;
 }
 
 void Logger::logWiFiInfo(const char *ssid, IPAddress ip, IPAddress gateway, const char *mac, int rssi)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    Serial.print("[WIFI] Successfully connected to WiFi");
-    Serial.println("======================================================================");
+    LOG_I("[WIFI] Successfully connected to WiFi");
+    LOG_SEPARATOR();
 }
 
-void Logger::logResetCardInfo(const char *filePath)
+void Logger::logResetCardInfo()
 {
-    Serial.println("======================================================================");
-    Serial.println("[RESET CARD] Current Reset Card information:");
-    File file = LittleFS.open(filePath, "r");
-    if (file)
-    {
-        // Read the file content
-        String content = "";
-        while (file.available())
-        {
-            content += (char)file.read();
-        }
-        file.close();
-
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, content);
-        if (!error)
-        {
-            serializeJson(doc, Serial);
-            Serial.println(); // Add a single newline after the JSON
-        }
-        else
-        {
-            // If parsing fails, print the raw content
-            Serial.println(content);
-        }
-    }
-    Serial.println("======================================================================");
+    LOG_SEPARATOR();
+    LOG_I("[RESET CARD] Current Reset Card information:");
+    const ResetCardConfig &key = resetCardManager.getKey();
+    LOG_I("{\"RBL\":%u,\"RFC\":%lu,\"RCN\":%lu,\"PAXTON_RESET_HEX\":\"%s\"}", key.bitLength,
+          (unsigned long)key.facilityCode, (unsigned long)key.cardNumber, key.paxtonHex);
+    LOG_SEPARATOR();
 }
 
 void Logger::logEmailStatus(bool enabled, const char *recipient)
 {
-    Serial.println("======================================================================");
+    LOG_SEPARATOR();
     if (enabled)
     {
-        Serial.print("[EMAIL] Notifications will be sent to: ");
-        Serial.println(recipient);
+        LOG_I("[EMAIL] Notifications will be sent to: %s", recipient);
     }
     else
     {
-        Serial.println("[EMAIL] Notifications are currently disabled.");
+        LOG_I("[EMAIL] Notifications are currently disabled.");
     }
 }
 
 void Logger::logMDNSStatus(const char *host)
 {
-    Serial.println("======================================================================");
-    Serial.println("[MDNS] MDNS responder started");
-    Serial.print("[MDNS] Device will be reachable at http://");
-    Serial.print(host);
-    Serial.println(".local/");
+    LOG_SEPARATOR();
+    LOG_I("[MDNS] MDNS responder started");
+    LOG_I("[MDNS] Device will be reachable at http://%s.local/", host);
 }
 
 void Logger::logLEDStatus(const char *message)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    Serial.println(message);
+    LOG_I("%s", message);
 }
 
 void Logger::logBootComplete()
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    Serial.println("======================================================================");
-    Serial.println(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
-    Serial.println(">>>>>>>>>>>>>>>>>>>>>>>> BOOT PROCESS COMPLETE <<<<<<<<<<<<<<<<<<<<<<<");
-    Serial.println(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
+    LOG_SEPARATOR();
+    LOG_I(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
+    LOG_I(">>>>>>>>>>>>>>>>>>>>>>>> BOOT PROCESS COMPLETE <<<<<<<<<<<<<<<<<<<<<<<");
+    LOG_I(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
 }
 
 void Logger::logTimeInfo(time_t now)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
     char timeStr[26];
     ctime_r(&now, timeStr);
     timeStr[24] = '\0'; // Remove the newline
-    Serial.print("[NTP] The current time is: ");
-    Serial.print(timeStr);
-    Serial.println(" UTC");
+    LOG_I("[NTP] The current time is: %s UTC", timeStr);
 }
 
 void Logger::logFilesystemStatus(const char *message, bool success)
@@ -516,11 +380,10 @@ void Logger::logFilesystemStatus(const char *message, bool success)
     std::lock_guard<std::mutex> lock(logMutex);
     if (lastMessageType != MessageType::FILESYSTEM)
     {
-        Serial.println("======================================================================");
+        LOG_SEPARATOR();
         lastMessageType = MessageType::FILESYSTEM;
     }
-    Serial.print("[FILESYSTEM] ");
-    Serial.println(message);
+    LOG_I("[FILESYSTEM] %s", message);
 }
 
 void Logger::logGPIOStatus(const char *message)
@@ -528,11 +391,10 @@ void Logger::logGPIOStatus(const char *message)
     std::lock_guard<std::mutex> lock(logMutex);
     if (lastMessageType != MessageType::GPIO)
     {
-        Serial.println("======================================================================");
+        LOG_SEPARATOR();
         lastMessageType = MessageType::GPIO;
     }
-    Serial.print("[GPIO] ");
-    Serial.println(message);
+    LOG_I("[GPIO] %s", message);
 }
 
 void Logger::logWebServerStatus(const char *message)
@@ -540,21 +402,15 @@ void Logger::logWebServerStatus(const char *message)
     std::lock_guard<std::mutex> lock(logMutex);
     if (lastMessageType != MessageType::WEBSERVER)
     {
-        Serial.println("======================================================================");
+        LOG_SEPARATOR();
         lastMessageType = MessageType::WEBSERVER;
     }
-    Serial.print("[WEBSERVER] ");
-    Serial.println(message);
+    LOG_I("[WEBSERVER] %s", message);
 }
 
 void Logger::logWebServerURL(const char *prefix, const char *url)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    Serial.print("[WEBSERVER] ");
-    Serial.print(prefix);
-    Serial.print(": http://");
-    Serial.print(url);
-    Serial.println("/");
+    LOG_I("[WEBSERVER] %s: http://%s/", prefix, url);
 }
 
 void Logger::logDebugStatus(const char *message)
@@ -562,9 +418,8 @@ void Logger::logDebugStatus(const char *message)
     std::lock_guard<std::mutex> lock(logMutex);
     if (lastMessageType != MessageType::DEBUG)
     {
-        Serial.println("======================================================================");
+        LOG_SEPARATOR();
         lastMessageType = MessageType::DEBUG;
     }
-    Serial.print("[DEBUG] ");
-    Serial.println(message);
+    LOG_I("[DEBUG] %s", message);
 }
\ No newline at end of file
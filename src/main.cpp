@@ -11,6 +11,7 @@
 #include <FS.h>
 #include <LittleFS.h>
 #include <Arduino.h>
+#include <atomic>
 #include "card_processor.h"
 #include "logger.h"
 #include "email_manager.h"
@@ -24,16 +25,42 @@
 #include "gpio_manager.h"
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
-#include <WebSocketsServer.h>
 #include <ESPmDNS.h>
 #include "led_manager.h"
 #include "notification_manager.h"
 #include "websocket_handler.h"
 #include "reset_manager.h"
 #include "card_event_handler.h"
+#include "card_log_manager.h"
+#include "credential_index.h"
+#include "storage_manager.h"
+#include "clock_manager.h"
+#include "card_export.h"
+#include "card_stats_manager.h"
+#include "console_log.h"
+#include "console_stream.h"
+#include "card_stream.h"
+#include "websocket_protocol.h"
+#include "command_executor.h"
+#include "config_manager.h"
+#include "boot_profiler.h"
+#include "web_assets.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_MAIN
+
+#define NETWORK_TASK_STACK 8192
+#define NETWORK_TASK_PRIORITY 1
+#define NETWORK_TASK_CORE 0 // With the Wi-Fi stack, away from the capture loop
+
+// Embedded web UI: hashed assets never change; pages keep their names and are revalidated
+#define WEB_ASSET_CACHE_CONTROL "public, max-age=31536000, immutable"
+#define WEB_DEFAULT_PAGE "/index.html"
 
 unsigned long startTime = 0;
 
+static std::atomic<bool> webServicesReady(false);
+
 extern CardProcessor cardProcessor;
 extern EmailManager emailManager;
 extern ResetCardManager resetCardManager;
@@ -52,95 +79,385 @@ WiFiManager wifiManager;
 
 // mDNS Configuration (removed - handled in WiFiSetupManager)
 
-// Web servers
+// Web server, with the WebSocket endpoint on the same port
 AsyncWebServer server(80);
-WebSocketsServer websockets(81);
+AsyncWebSocket websockets(WS_PATH);
 
 ///////////////////////////////////////////////////////
 // Functions start here
 ///////////////////////////////////////////////////////
 /* Core Functions */
-// System initialization
-void setup()
+// Conditional GET: answer 304 with no body when the client already holds this version
+static bool sendIfNotModified(AsyncWebServerRequest *request, const char *etag,
+                              const char *cacheControl = "no-cache")
 {
-  delay(5000);
-  esp_log_level_set("vfs_api", ESP_LOG_NONE);
-
-  Serial.begin(115200);
-  delay(2000);
-  setCpuFrequencyMhz(CPU_FREQ_NORMAL);
+  if (!request->hasHeader("If-None-Match") || request->getHeader("If-None-Match")->value() != etag)
+  {
+    return false;
+  }
 
-  logger.logStartupBanner(device, version, builddate, hardware);
+  AsyncWebServerResponse *response = request->beginResponse(304);
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+  return true;
+}
 
-  logger.logFilesystemStatus("Initializing the filesystem...", true);
-  if (!LittleFS.begin(FORMAT_LITTLEFS_IF_FAILED))
+// Sent straight from the flash mapping; the ETag was computed by the build
+static void sendWebAsset(AsyncWebServerRequest *request, const WebAsset &asset)
+{
+  const char *cacheControl = asset.immutable ? WEB_ASSET_CACHE_CONTROL : "no-cache";
+  if (sendIfNotModified(request, asset.etag, cacheControl))
   {
-    logger.logFilesystemStatus("LittleFS Mount Failed", false);
     return;
   }
 
-  debugManager.begin();
-
-  LEDManager::getInstance().begin();
-
-  GPIOManager::getInstance().begin();
-
-  pinMode(RST, INPUT_PULLUP);
-  ResetManager::getInstance().begin();
+  AsyncWebServerResponse *response = request->beginResponse(200, asset.contentType, asset.data, asset.length);
+  if (asset.gzip)
+  {
+    response->addHeader("Content-Encoding", "gzip");
+  }
+  response->addHeader("ETag", asset.etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+}
 
-  logger.logGPIOStatus("Preparing GPIO configuration...");
-  readerManager.begin();
-  cardProcessor.reset();
-  logger.logGPIOStatus("GPIO configuration complete and ready");
+// Web server, WebSocket endpoint and routes; runs on the network task
+static void startWebServices()
+{
+  logger.logWebServerStatus("Starting web services");
 
-  Serial.println("======================================================================");
-  wifiSetupManager.begin(device, defaultPASS, prefixSSID);
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET");
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "*");
 
-  if (!wifiSetupManager.isConnected())
-  {
-    Serial.println("[WIFI] Operating without WiFi connection");
-  }
-  else
-  {
-    if (wifiSetupManager.setupTime())
+  // Card log is stored in segments; stitch them back together as one CSV
+  server.on("/cards.csv", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    char etag[48];
+    cardLogManager.getEtag(etag, sizeof(etag));
+    if (sendIfNotModified(request, etag))
     {
-      Serial.println("======================================================================");
-      Serial.println("[WIFI] Successfully connected to WiFi");
-      Serial.print("[WIFI] Device IP Address: ");
-      Serial.println(wifiSetupManager.getLocalIP().toString());
-      Serial.print("[WIFI] Access URL: http://");
-      Serial.print(wifiSetupManager.getLocalIP().toString());
-      Serial.println("/");
+      return;
+    }
 
-      emailManager.readConfig();
+    std::shared_ptr<CardLogCursor> cursor = std::make_shared<CardLogCursor>();
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/csv",
+        [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+          return cardLogManager.read(*cursor, buffer, maxLen);
+        });
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response); });
 
-      if (emailManager.isConfigured())
+  // Whole log as a gzip file, compressed on the fly: ?format=csv (default) or jsonl
+  server.on("/api/export", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    CardLogLineFormat format = CARD_LOG_LINES_CSV;
+    if (request->hasParam("format"))
+    {
+      String value = request->getParam("format")->value();
+      if (value == "jsonl")
       {
-        emailManager.begin(EmailManager::smtp_host, EmailManager::smtp_port,
-                           EmailManager::smtp_user, EmailManager::smtp_pass,
-                           EmailManager::smtp_recipient);
-        Serial.println("======================================================================");
+        format = CARD_LOG_LINES_JSONL;
       }
-
-      if (WiFi.status() == WL_CONNECTED)
+      else if (value != "csv")
       {
-        notificationManager.begin();
+        request->send(400, "application/json", "{\"error\":\"format must be csv or jsonl\"}");
+        return;
       }
     }
-  }
 
-  logger.logWebServerStatus("Starting web services");
+    CardExport *exporter = CardExport::create(format);
+    if (!exporter)
+    {
+      AsyncWebServerResponse *busy = request->beginResponse(503, "application/json", "{\"error\":\"export in progress\"}");
+      busy->addHeader("Retry-After", "5");
+      request->send(busy);
+      return;
+    }
 
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "*");
-  DefaultHeaders::Instance().addHeader("Content-Encoding", "identity");
-  DefaultHeaders::Instance().addHeader("Accept-Encoding", "identity");
+    // Served as a .gz download rather than Content-Encoding: gzip so browsers keep the compressed file
+    std::shared_ptr<CardExport> stream(exporter);
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/gzip",
+        [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+          return stream->read(buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition", format == CARD_LOG_LINES_JSONL
+                                                  ? "attachment; filename=\"cards.jsonl.gz\""
+                                                  : "attachment; filename=\"cards.csv.gz\"");
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response); });
 
-  server.serveStatic("/", LittleFS, "/www/")
-      .setDefaultFile("index.html")
-      .setCacheControl("no-cache")
-      .setLastModified("Mon, 20 Jun 2016 14:00:00 GMT");
+  server.on("/card-log", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    JsonDocument doc;
+    doc["records"] = cardLogManager.getRecordCount();
+    doc["used_bytes"] = cardLogManager.getUsedBytes();
+    doc["max_bytes"] = cardLogManager.getMaxBytes();
+    doc["segments"] = cardLogManager.getSegmentCount();
+    doc["segment_size"] = CARD_LOG_SEGMENT_SIZE;
+    doc["policy"] = cardLogManager.getPolicy() == CARD_LOG_STOP_WHEN_FULL ? "stop" : "evict";
+    doc["full"] = cardLogManager.isFull();
+    serializeJson(doc, *response);
+    request->send(response); });
+
+  // ?since=N returns only records newer than sequence number N, oldest first.
+  // format=, fc=, from= and to= (epoch seconds) filter through the segment indexes.
+  server.on("/api/cards", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    char etag[48];
+    cardLogManager.getEtag(etag, sizeof(etag));
+    if (sendIfNotModified(request, etag))
+    {
+      return;
+    }
+
+    std::shared_ptr<CardPageCursor> cursor = std::make_shared<CardPageCursor>();
+    if (request->hasParam("since"))
+    {
+      long since = request->getParam("since")->value().toInt();
+      cursor->since = since > 0 ? since : 0;
+      cursor->hasSince = true;
+    }
+    if (request->hasParam("offset"))
+    {
+      long offset = request->getParam("offset")->value().toInt();
+      cursor->offset = offset > 0 ? offset : 0;
+    }
+    if (request->hasParam("limit"))
+    {
+      long limit = request->getParam("limit")->value().toInt();
+      cursor->limit = limit < 1 ? 1 : (limit > CARD_PAGE_MAX_LIMIT ? CARD_PAGE_MAX_LIMIT : limit);
+    }
+    if (request->hasParam("order"))
+    {
+      cursor->order = request->getParam("order")->value() == "asc" ? CARD_PAGE_ASC : CARD_PAGE_DESC;
+    }
+
+    // Filters are answered from the segment indexes; pages continue with after= / before=
+    CardLogFilter &filter = cursor->filter;
+    if (request->hasParam("format"))
+    {
+      filter.hasFormat = true;
+      filter.formatMask = cardIndexFormatMask(request->getParam("format")->value().c_str());
+    }
+    if (request->hasParam("fc"))
+    {
+      filter.hasFacilityCode = true;
+      filter.facilityCode = strtoul(request->getParam("fc")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("from"))
+    {
+      filter.from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("to"))
+    {
+      filter.to = strtoul(request->getParam("to")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("after"))
+    {
+      filter.afterSeq = strtoul(request->getParam("after")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("before"))
+    {
+      filter.beforeSeq = strtoul(request->getParam("before")->value().c_str(), nullptr, 10);
+    }
+    filter.active = filter.hasFormat || filter.hasFacilityCode || filter.from || filter.to ||
+                    filter.afterSeq || filter.beforeSeq;
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+        [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+          return cardLogManager.readPage(*cursor, buffer, maxLen);
+        });
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response); });
+
+  server.on("/api/credentials", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"c%lu\"", (unsigned long)credentialIndex.getVersion());
+    if (sendIfNotModified(request, etag))
+    {
+      return;
+    }
+
+    std::shared_ptr<CredentialCursor> cursor = std::make_shared<CredentialCursor>();
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+        [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+          return credentialIndex.readJson(*cursor, buffer, maxLen);
+        });
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response); });
+
+  // Aggregate read counters kept in RAM; no log scan
+  server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"s%lu\"", (unsigned long)cardStatsManager.getVersion());
+    if (sendIfNotModified(request, etag))
+    {
+      return;
+    }
+
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    cardStatsManager.writeJson(*response);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response); });
+
+  server.on("/api/storage", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    StorageStats stats = storageManager.getStats();
+    JsonDocument doc;
+    doc["queue_depth"] = stats.depth;
+    doc["queue_high_water"] = stats.highWater;
+    doc["queue_capacity"] = stats.capacity;
+    doc["processed"] = stats.processed;
+    doc["dropped"] = stats.dropped;
+    doc["last_latency_us"] = stats.lastLatencyUs;
+    doc["max_latency_us"] = stats.maxLatencyUs;
+    doc["avg_latency_us"] = stats.avgLatencyUs;
+    doc["config_load_us"] = configManager.getLoadMicros();
+    serializeJson(doc, *response);
+    request->send(response); });
+
+  server.on("/api/live", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    CardStreamStats stats = cardStream.getStats();
+    JsonDocument doc;
+    doc["subscribers"] = stats.subscribers;
+    doc["published"] = stats.published;
+    doc["skipped"] = stats.skipped;
+    doc["last_latency_us"] = stats.lastLatencyUs;
+    doc["max_latency_us"] = stats.maxLatencyUs;
+    WsProtocolStats frames = webSocketProtocol.getStats();
+    JsonObject protocol = doc["protocol"].to<JsonObject>();
+    protocol["version"] = WS_PROTOCOL_VERSION;
+    protocol["frames_json"] = frames.framesJson;
+    protocol["bytes_json"] = frames.bytesJson;
+    protocol["frames_msgpack"] = frames.framesMsgPack;
+    protocol["bytes_msgpack"] = frames.bytesMsgPack;
+    protocol["oversized"] = frames.oversized;
+    protocol["busy"] = frames.busy;
+    WebSocketQueueStats queue = getWebSocketStats();
+    JsonObject connections = doc["websocket"].to<JsonObject>();
+    connections["clients"] = queue.clients;
+    connections["queued"] = queue.queued;
+    connections["dropped"] = queue.dropped;
+    connections["rejected"] = queue.rejected;
+    CommandStats commandStats = commandExecutor.getStats();
+    JsonObject commands = doc["commands"].to<JsonObject>();
+    commands["queued"] = commandStats.depth;
+    commands["executed"] = commandStats.executed;
+    commands["failed"] = commandStats.failed;
+    commands["dropped"] = commandStats.dropped;
+    commands["last_duration_us"] = commandStats.lastDurationUs;
+    commands["max_duration_us"] = commandStats.maxDurationUs;
+    serializeJson(doc, *response);
+    request->send(response); });
+
+  server.on("/api/time", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    ClockSyncStats stats = clockManager.getSyncStats();
+    JsonDocument doc;
+    doc["synced"] = clockManager.isSynced();
+    doc["source"] = stats.source ? stats.source : "none";
+    doc["time"] = clockManager.now();
+    doc["sync_count"] = stats.syncCount;
+    doc["last_sync"] = stats.lastSync;
+    doc["interval_s"] = CLOCK_SYNC_INTERVAL_MS / 1000;
+    if (stats.hasDrift)
+    {
+      doc["offset_ms"] = stats.lastOffsetMs;
+      doc["drift_ppm"] = stats.driftPpm;
+    }
+    serializeJson(doc, *response);
+    request->send(response); });
+
+  server.on("/api/console", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    ConsoleLogStats stats = consoleLog.getStats();
+    JsonDocument doc;
+    doc["written"] = stats.written;
+    doc["dropped"] = stats.dropped;
+    doc["truncated"] = stats.truncated;
+    doc["high_water"] = stats.highWater;
+    doc["capacity"] = CONSOLE_LOG_SLOTS;
+    doc["serial_level"] = consoleLogLevelName(consoleLog.getSerialLevel());
+    doc["level"] = consoleLogLevelName(consoleLog.getLevel());
+    serializeJson(doc, *response);
+    request->send(response); });
+
+  // Settings the UI reads as JSON files, served from the configuration in RAM
+  static const struct
+  {
+    const char *path;
+    uint32_t section;
+  } configFiles[] = {
+      {"/reader_config.json", CONFIG_READER},
+      {"/debug_config.json", CONFIG_DEBUG},
+      {"/gpio_settings.json", CONFIG_GPIO},
+      {"/gpio.json", CONFIG_GPIO},
+      {"/notifications", CONFIG_NOTIFICATIONS},
+      {"/reset_card.json", CONFIG_RESET_CARD},
+      {"/credential_config.json", CONFIG_CREDENTIALS},
+  };
+  for (const auto &configFile : configFiles)
+  {
+    uint32_t section = configFile.section;
+    server.on(configFile.path, HTTP_GET, [section](AsyncWebServerRequest *request)
+              {
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->addHeader("Cache-Control", "no-cache");
+      configManager.writeJson(section, *response);
+      request->send(response); });
+  }
+
+  server.on("/gpio.json", HTTP_POST, [](AsyncWebServerRequest *request)
+            {
+    if (request->hasParam("data", true)) {
+      JsonDocument doc;
+      if (deserializeJson(doc, request->getParam("data", true)->value())) {
+        request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        return;
+      }
+      // Fields left out keep their current values
+      DeviceConfig config = configManager.get();
+      config.gpio.pin35Enabled = doc["pin35_enabled"] | config.gpio.pin35Enabled;
+      config.gpio.pin36Enabled = doc["pin36_enabled"] | config.gpio.pin36Enabled;
+      config.gpio.pin35DefaultHigh = doc["pin35_default_high"] | config.gpio.pin35DefaultHigh;
+      config.gpio.pin36DefaultHigh = doc["pin36_default_high"] | config.gpio.pin36DefaultHigh;
+      config.gpio.pin35PulseMs = doc["pin35_pulse_duration"] | config.gpio.pin35PulseMs;
+      config.gpio.pin36PulseMs = doc["pin36_pulse_duration"] | config.gpio.pin36PulseMs;
+      configManager.commit(config, CONFIG_GPIO);
+      request->send(200, "application/json", "{\"status\":\"success\"}");
+    } else {
+      request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"No data provided\"}");
+    } });
+
+  for (size_t i = 0; i < WEB_ASSET_COUNT; i++)
+  {
+    const WebAsset *asset = &WEB_ASSETS[i];
+    server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest *request)
+              { sendWebAsset(request, *asset); });
+    if (strcmp(asset->path, WEB_DEFAULT_PAGE) == 0)
+    {
+      server.on("/", HTTP_GET, [asset](AsyncWebServerRequest *request)
+                { sendWebAsset(request, *asset); });
+    }
+  }
 
   server.on("/firmware", HTTP_GET, [](AsyncWebServerRequest *request)
             {
@@ -199,71 +516,11 @@ void setup()
     doc["flashSize"] = ESP.getFlashChipSize();
     doc["freeHeap"] = ESP.getFreeHeap();
     doc["heapSize"] = ESP.getHeapSize();
+    bootProfiler.writeJson(doc["boot"].to<JsonObject>());
     
     serializeJson(doc, *response);
     request->send(response); });
 
-  server.on("/notifications", HTTP_GET, [](AsyncWebServerRequest *request)
-            {
-    AsyncResponseStream *response = request->beginResponseStream("application/json");
-    JsonDocument doc;
-    
-    File notificationConfigFile = LittleFS.open(NOTIFICATION_CONFIG_FILE, "r");
-    if (notificationConfigFile) {
-      DeserializationError error = deserializeJson(doc, notificationConfigFile);
-      notificationConfigFile.close();
-      
-      if (!error) {
-        serializeJson(doc, *response);
-      } else {
-        doc["enable_email"] = "false";
-        doc["smtp_host"] = "";
-        doc["smtp_port"] = "";
-        doc["smtp_user"] = "";
-        doc["smtp_recipient"] = "";
-        serializeJson(doc, *response);
-      }
-    } else {
-      doc["enable_email"] = "false";
-      doc["smtp_host"] = "";
-      doc["smtp_port"] = "";
-      doc["smtp_user"] = "";
-      doc["smtp_recipient"] = "";
-      serializeJson(doc, *response);
-    }
-    request->send(response); });
-
-  server.on("/gpio.json", HTTP_GET, [](AsyncWebServerRequest *request)
-            {
-    AsyncResponseStream *response = request->beginResponseStream("application/json");
-    File file = LittleFS.open("/www/gpio.json", "r");
-    if (file) {
-      response->write(file);
-      file.close();
-    } else {
-      JsonDocument doc;
-      doc["pin35"] = false;
-      doc["pin36"] = false;
-      serializeJson(doc, *response);
-    }
-    request->send(response); });
-
-  server.on("/gpio.json", HTTP_POST, [](AsyncWebServerRequest *request)
-            {
-    if (request->hasParam("data", true)) {
-      String data = request->getParam("data", true)->value();
-      File file = LittleFS.open("/www/gpio.json", "w");
-      if (file) {
-        file.print(data);
-        file.close();
-        request->send(200, "application/json", "{\"status\":\"success\"}");
-      } else {
-        request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Failed to write file\"}");
-      }
-    } else {
-      request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"No data provided\"}");
-    } });
-
   server.onNotFound([](AsyncWebServerRequest *request)
                     {
     if (request->method() == HTTP_OPTIONS)
@@ -272,36 +529,169 @@ void setup()
     }
     else
     {
-          Serial.println("[WEBSERVER] 404 sent to client");
+          LOG_D("[WEBSERVER] 404 sent to client");
       request->send(404, "Not Found");
       } });
 
+  beginWebSocket(server);
   server.begin();
   logger.logWebServerStatus("Webserver is running");
-  websockets.begin();
-  websockets.onEvent(webSocketEvent);
-  logger.logWebServerStatus("WebSocket service is running");
+  logger.logWebServerStatus("WebSocket service is running at " WS_PATH);
   if (wifiSetupManager.isConnected())
   {
     logger.logWebServerURL("Doppelgänger", "rfid.local");
     logger.logWebServerURL("Doppelgänger", wifiSetupManager.getLocalIP().toString().c_str());
-    Serial.println("======================================================================");
-    Serial.println("[ANDROID] For Android devices, use IP address directly:");
-    Serial.print("[ANDROID] http://");
-    Serial.print(wifiSetupManager.getLocalIP().toString());
-    Serial.println("/");
+    LOG_SEPARATOR();
+    LOG_I("[ANDROID] For Android devices, use IP address directly:");
+    LOG_I("[ANDROID] http://%s/", wifiSetupManager.getLocalIP().toString().c_str());
+  }
+}
+
+// Everything that waits on the network runs here, so the reader is capturing
+// while Wi-Fi associates (or the setup portal is open)
+static void networkTask(void *parameter)
+{
+  LOG_SEPARATOR();
+  wifiSetupManager.begin(device, defaultPASS, prefixSSID);
+
+  if (!wifiSetupManager.isConnected())
+  {
+    LOG_W("[WIFI] Operating without WiFi connection");
   }
+  else
+  {
+    // SNTP syncs in the background; card records resolve when it does
+    clockManager.startSync();
+    LOG_SEPARATOR();
+    LOG_I("[WIFI] Successfully connected to WiFi");
+    LOG_I("[WIFI] Device IP Address: %s", wifiSetupManager.getLocalIP().toString().c_str());
+    LOG_I("[WIFI] Access URL: http://%s/", wifiSetupManager.getLocalIP().toString().c_str());
+
+    bootProfiler.start(BOOT_PHASE_EMAIL);
+    emailManager.readConfig();
+
+    if (emailManager.isConfigured())
+    {
+      emailManager.begin(EmailManager::smtp_host, EmailManager::smtp_port,
+                         EmailManager::smtp_user, EmailManager::smtp_pass,
+                         EmailManager::smtp_recipient);
+      LOG_SEPARATOR();
+    }
+    bootProfiler.end(BOOT_PHASE_EMAIL);
+
+    if (WiFi.status() == WL_CONNECTED)
+    {
+      notificationManager.begin();
+    }
+  }
+
+  bootProfiler.start(BOOT_PHASE_WEB);
+  startWebServices();
+  bootProfiler.end(BOOT_PHASE_WEB);
+  webServicesReady = true;
 
-  logger.logResetCardInfo(LOGGER_RESET_CARD_FILE);
+  bootProfiler.finish();
+
+  vTaskDelete(NULL);
+}
+
+// System initialization
+// Only what a read needs runs here: the filesystem, the configuration and
+// the reader interrupts come first, and setup() returns as soon as reads
+// can be logged. Network services follow on their own task.
+void setup()
+{
+  esp_log_level_set("vfs_api", ESP_LOG_NONE);
+
+  Serial.begin(115200);
+  consoleLog.begin();
+  consoleStream.begin();
+  setCpuFrequencyMhz(CPU_FREQ_NORMAL);
+
+  logger.logStartupBanner(device, version, builddate, hardware);
+
+  logger.logFilesystemStatus("Initializing the filesystem...", true);
+  // Mount without formatting first, so a repair shows up as its own phase
+  bootProfiler.start(BOOT_PHASE_FS_MOUNT);
+  bool mounted = LittleFS.begin(false);
+  bootProfiler.end(BOOT_PHASE_FS_MOUNT);
+  if (!mounted && FORMAT_LITTLEFS_IF_FAILED)
+  {
+    logger.logFilesystemStatus("Mount failed, formatting the filesystem...", true);
+    bootProfiler.start(BOOT_PHASE_FS_FORMAT);
+    mounted = LittleFS.begin(true);
+    bootProfiler.end(BOOT_PHASE_FS_FORMAT);
+  }
+  if (!mounted)
+  {
+    logger.logFilesystemStatus("LittleFS Mount Failed", false);
+    return;
+  }
+  bootProfiler.begin();
+
+  bootProfiler.start(BOOT_PHASE_CONFIG);
+  configManager.begin();
+  bootProfiler.end(BOOT_PHASE_CONFIG);
+  bootProfiler.start(BOOT_PHASE_DEBUG);
+  debugManager.begin();
+  bootProfiler.end(BOOT_PHASE_DEBUG);
+
+  // Arm capture first; frames that arrive during the rest of setup wait in
+  // the interface buffers until loop() runs
+  bootProfiler.start(BOOT_PHASE_GPIO);
+  GPIOManager::getInstance().begin();
+  bootProfiler.end(BOOT_PHASE_GPIO);
+  logger.logGPIOStatus("Preparing GPIO configuration...");
+  bootProfiler.start(BOOT_PHASE_READER);
+  readerManager.begin();
+  cardProcessor.reset();
+  bootProfiler.end(BOOT_PHASE_READER);
+  logger.logGPIOStatus("GPIO configuration complete and ready");
+
+  bootProfiler.start(BOOT_PHASE_CARD_LOG);
+  cardLogManager.begin();
+  bootProfiler.end(BOOT_PHASE_CARD_LOG);
+  bootProfiler.start(BOOT_PHASE_CREDENTIALS);
+  credentialIndex.begin();
+  bootProfiler.end(BOOT_PHASE_CREDENTIALS);
+  bootProfiler.start(BOOT_PHASE_STATS);
+  cardStatsManager.begin();
+  bootProfiler.end(BOOT_PHASE_STATS);
+
+  // Recovery above runs inline; every later write goes through the storage task
+  bootProfiler.start(BOOT_PHASE_STORAGE);
+  storageManager.begin();
+  bootProfiler.end(BOOT_PHASE_STORAGE);
+  bootProfiler.start(BOOT_PHASE_CLOCK);
+  clockManager.begin();
+  bootProfiler.end(BOOT_PHASE_CLOCK);
+
+  // After the migrations above have read their legacy files from /www
+  storageManager.run([](const uint8_t *data, size_t length)
+                     { removeLegacyWebFiles(); });
+
+  LEDManager::getInstance().begin();
+
+  pinMode(RST, INPUT_PULLUP);
+  ResetManager::getInstance().begin();
+
+  logger.logResetCardInfo();
 
   resetCardManager.begin();
 
   cardEventHandler.begin();
 
+  commandExecutor.begin();
+
+  xTaskCreatePinnedToCore(networkTask, "NetworkTask", NETWORK_TASK_STACK, NULL,
+                          NETWORK_TASK_PRIORITY, NULL, NETWORK_TASK_CORE);
+
   logger.logLEDStatus("[LED] Informing of successful boot");
 
   LEDManager::getInstance().runStartupSequence();
 
+  bootProfiler.markCaptureReady();
+
   logger.logBootComplete();
 }
 
@@ -312,6 +702,9 @@ void loop()
   static unsigned long debounceDelay = 100;
   static bool waitingForSecondPress = false;
 
+  // Reader, GPIO and reset card changes committed by the command executor
+  configManager.applyPending();
+
   LEDManager::getInstance().update();
 
   emailManager.update();
@@ -320,6 +713,8 @@ void loop()
 
   GPIOManager::getInstance().loop();
 
+  configManager.update();
+
   if (readerManager.isPaxtonMode())
   {
     net2Interface.processTimeout();
@@ -329,7 +724,9 @@ void loop()
 
   if (cardProcessor.isReadComplete())
   {
+    bootProfiler.markFirstRead();
     logger.consoleLog();
+    cardStatsManager.recordRead(cardProcessor);
     resetCardManager.checkResetCard(cardProcessor);
 
     if (cardProcessor.isKeypadPress())
@@ -351,5 +748,10 @@ void loop()
     cardProcessor.reset();
   }
 
-  websockets.loop();
+  if (webServicesReady)
+  {
+    processWebSocketEvents();
+    cardStream.update();
+    consoleStream.update();
+  }
 }
\ No newline at end of file
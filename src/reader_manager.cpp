@@ -1,6 +1,9 @@
 #include "reader_manager.h"
 #include "wiegand_interface.h"
 #include "net2_interface.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_READER
 
 ReaderManager &readerManager = ReaderManager::getInstance();
 
@@ -21,98 +24,37 @@ void ReaderManager::begin()
 {
     loadConfig();
     attachInterrupts();
+    configManager.subscribe(CONFIG_READER, onConfigChanged, true);
 }
 
 void ReaderManager::loadConfig()
 {
-    Serial.println("======================================================================");
-    Serial.println("[READER] Loading reader configuration...");
-
-    if (!LittleFS.exists(READER_CONFIG_FILE))
-    {
-        Serial.println("[READER] Config file not found. Creating defaults...");
-        setDefaultConfig();
-        return;
-    }
-
-    File configFile = LittleFS.open(READER_CONFIG_FILE, "r");
-    if (!configFile)
-    {
-        Serial.println("[READER] Failed to open config file");
-        setDefaultConfig();
-        return;
-    }
-
-    JsonDocument jsonDoc;
-    DeserializationError error = deserializeJson(jsonDoc, configFile);
-    configFile.close();
+    LOG_SEPARATOR();
+    LOG_I("[READER] Loading reader configuration...");
 
-    if (error)
-    {
-        Serial.print("[READER] Failed to parse config file: ");
-        Serial.println(error.c_str());
-        setDefaultConfig();
-        return;
-    }
-
-    String readerType = jsonDoc["READER_TYPE"].as<String>();
-
-    if (readerType == "PAXTON")
-    {
-        currentReaderType = READER_PAXTON;
-        Serial.println("[READER] Type: PAXTON");
-    }
-    else
-    {
-        currentReaderType = READER_HID;
-        Serial.println("[READER] Type: HID");
-    }
+    currentReaderType = (ReaderType)configManager.get().readerType;
+    LOG_I("[READER] Type: %s", currentReaderType == READER_PAXTON ? "PAXTON" : "HID");
 }
 
-void ReaderManager::saveConfig(ReaderType type)
+void ReaderManager::onConfigChanged(uint32_t sections, const DeviceConfig &config)
 {
-    JsonDocument json;
-    json["READER_TYPE"] = (type == READER_PAXTON) ? "PAXTON" : "HID";
-
-    File readerFile = LittleFS.open(READER_CONFIG_FILE, "w");
-    if (readerFile)
-    {
-        serializeJson(json, readerFile);
-        readerFile.close();
-        Serial.println("[READER] Configuration saved");
-    }
-    else
+    ReaderType newType = (ReaderType)config.readerType;
+    if (newType != readerManager.currentReaderType)
     {
-        Serial.println("[READER] Failed to save configuration");
+        LOG_SEPARATOR();
+        LOG_I("[READER] Switching to %s", newType == READER_PAXTON ? "PAXTON" : "HID");
+        readerManager.currentReaderType = newType;
+        readerManager.attachInterrupts();
     }
 }
 
-void ReaderManager::setDefaultConfig()
-{
-    Serial.println("[READER] Setting default configuration (HID)");
-
-    JsonDocument json;
-    json["READER_TYPE"] = "HID";
-
-    File readerFile = LittleFS.open(READER_CONFIG_FILE, "w");
-    if (readerFile)
-    {
-        serializeJson(json, readerFile);
-        readerFile.close();
-    }
-
-    currentReaderType = READER_HID;
-}
-
 void ReaderManager::switchMode(ReaderType newType)
 {
-    Serial.println("======================================================================");
-    Serial.print("[READER] Switching to ");
-    Serial.println(newType == READER_PAXTON ? "PAXTON" : "HID");
-
-    currentReaderType = newType;
-    saveConfig(newType);
-    attachInterrupts();
+    // Applied by onConfigChanged on the main loop: at once from there, at
+    // the top of the next pass when committed by another task
+    DeviceConfig config = configManager.get();
+    config.readerType = newType;
+    configManager.commit(config, CONFIG_READER);
 }
 
 void ReaderManager::attachInterrupts()
@@ -126,9 +68,9 @@ void ReaderManager::attachInterrupts()
 
     if (currentReaderType == READER_PAXTON)
     {
-        Serial.println("[READER] Attaching PAXTON NATIVE capture:");
-        Serial.println("[READER]   - Net2 native: D1(CLK)/D0(DATA)");
-        Serial.println("[READER]   - For Net2 tokens and KP75 keypad");
+        LOG_I("[READER] Attaching PAXTON NATIVE capture:");
+        LOG_D("[READER]   - Net2 native: D1(CLK)/D0(DATA)");
+        LOG_D("[READER]   - For Net2 tokens and KP75 keypad");
 
         pinMode(NET2_CLK_PIN, INPUT);
         pinMode(NET2_DATA_PIN, INPUT);
@@ -136,7 +78,7 @@ void ReaderManager::attachInterrupts()
     }
     else
     {
-        Serial.println("[READER] Attaching HID interrupt handlers");
+        LOG_I("[READER] Attaching HID interrupt handlers");
 
         pinMode(DATA0, INPUT);
         pinMode(DATA1, INPUT);
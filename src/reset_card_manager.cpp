@@ -1,112 +1,33 @@
 #include "reset_card_manager.h"
-#include <WiFiManager.h>
 #include "version_config.h"
 #include "reader_manager.h"
+#include "wifi_setup_manager.h"
+#include "log.h"
 
-ResetCardManager::ResetCardManager() {}
+#define LOG_MODULE_LEVEL LOG_LEVEL_RESET
 
-void ResetCardManager::begin()
+ResetCardManager::ResetCardManager()
 {
-    if (!LittleFS.exists(RESET_CARD_FILE))
-    {
-        setDefaultResetCard();
-    }
+    // Global constructors run in no set order, so no configManager reference here
+    key = ConfigManager::getInstance().get().resetCard;
 }
 
-void ResetCardManager::setDefaultResetCard()
-{
-    Serial.println("======================================================================");
-    Serial.println("[RESET] Writing the default Reset Card values...");
-
-    JsonDocument json;
-    json["RBL"] = 35;
-    json["RFC"] = 111;
-    json["RCN"] = 4444;
-    json["PAXTON_RESET_HEX"] = "0000001337";
-
-    File resetCardFile = LittleFS.open(RESET_CARD_FILE, "w");
-    if (!resetCardFile)
-    {
-        Serial.println("[RESET CARD] Failed to open Reset Card file for writing");
-        return;
-    }
-
-    serializeJsonPretty(json, Serial);
-
-    if (serializeJson(json, resetCardFile) == 0)
-    {
-        Serial.println(F("[RESET CARD] Failed to write the data to file"));
-    }
-    resetCardFile.close();
-}
-
-bool ResetCardManager::readResetCardConfig(int &resetBL, int &resetFC, int &resetCN)
+void ResetCardManager::begin()
 {
-    String dummyPaxtonHex;
-    return readResetCardConfig(resetBL, resetFC, resetCN, dummyPaxtonHex);
+    key = configManager.get().resetCard;
+    configManager.subscribe(CONFIG_RESET_CARD, onConfigChanged, true);
 }
 
-bool ResetCardManager::readResetCardConfig(int &resetBL, int &resetFC, int &resetCN, String &paxtonHex)
+void ResetCardManager::onConfigChanged(uint32_t sections, const DeviceConfig &config)
 {
-    if (!LittleFS.exists(RESET_CARD_FILE))
-    {
-        Serial.println("[RESET] JSON file not found");
-        return false;
-    }
-
-    File configFile = LittleFS.open(RESET_CARD_FILE, "r");
-    if (!configFile)
-    {
-        Serial.println("[RESET] Failed to open config file");
-        return false;
-    }
-
-    String configData = configFile.readString();
-    configFile.close();
-
-    JsonDocument jsonDoc;
-    DeserializationError error = deserializeJson(jsonDoc, configData);
-    if (error)
-    {
-        Serial.println("[RESET] Failed to parse config");
-        return false;
-    }
-
-    resetBL = jsonDoc["RBL"];
-    resetFC = jsonDoc["RFC"];
-    resetCN = jsonDoc["RCN"];
-    paxtonHex = jsonDoc["PAXTON_RESET_HEX"] | "0000001337";
-    return true;
+    resetCardManager.key = config.resetCard;
 }
 
-bool ResetCardManager::readPaxtonResetCard(String &paxtonHex)
+void ResetCardManager::setDefaultResetCard()
 {
-    if (!LittleFS.exists(RESET_CARD_FILE))
-    {
-        Serial.println("[RESET] JSON file not found");
-        return false;
-    }
-
-    File configFile = LittleFS.open(RESET_CARD_FILE, "r");
-    if (!configFile)
-    {
-        Serial.println("[RESET] Failed to open config file");
-        return false;
-    }
-
-    String configData = configFile.readString();
-    configFile.close();
-
-    JsonDocument jsonDoc;
-    DeserializationError error = deserializeJson(jsonDoc, configData);
-    if (error)
-    {
-        Serial.println("[RESET] Failed to parse config");
-        return false;
-    }
-
-    paxtonHex = jsonDoc["PAXTON_RESET_HEX"] | "0000001337";
-    return true;
+    LOG_SEPARATOR();
+    LOG_I("[RESET] Restoring the default Reset Card values...");
+    configManager.restoreDefaults(CONFIG_RESET_CARD);
 }
 
 void ResetCardManager::checkResetCard(CardProcessor &cardProcessor)
@@ -114,33 +35,19 @@ void ResetCardManager::checkResetCard(CardProcessor &cardProcessor)
     if (readerManager.isPaxtonMode())
     {
         // Check for Paxton reset card
-        String paxtonHex;
-        if (!readPaxtonResetCard(paxtonHex))
+        if (strcasecmp(cardProcessor.getNet2HexEM410x().c_str(), key.paxtonHex) == 0)
         {
-            return;
-        }
-        
-        String cardHex = cardProcessor.getNet2HexEM410x();
-        if (cardHex.equalsIgnoreCase(paxtonHex))
-        {
-            Serial.println("======================================================================");
-            Serial.println("[RESET] Paxton Reset Card detected!");
+            LOG_SEPARATOR();
+            LOG_I("[RESET] Paxton Reset Card detected!");
             resetStoredWiFi();
         }
     }
     else
     {
         // Check for HID reset card
-        int resetBL, resetFC, resetCN;
-        String dummyPaxtonHex;
-        if (!readResetCardConfig(resetBL, resetFC, resetCN, dummyPaxtonHex))
-        {
-            return;
-        }
-
-        if (cardProcessor.getBitCount() == resetBL &&
-            cardProcessor.getFacilityCode() == resetFC &&
-            cardProcessor.getCardNumber() == resetCN)
+        if (cardProcessor.getBitCount() == key.bitLength &&
+            cardProcessor.getFacilityCode() == key.facilityCode &&
+            cardProcessor.getCardNumber() == key.cardNumber)
         {
             resetStoredWiFi();
         }
@@ -149,12 +56,8 @@ void ResetCardManager::checkResetCard(CardProcessor &cardProcessor)
 
 void ResetCardManager::resetStoredWiFi()
 {
-    Serial.println("======================================================================");
-    Serial.println("[RESET WIFI] Clearing stored WiFi Access Point...");
-    WiFiManager wifiManager;
-    wifiManager.resetSettings();
-    delay(3000);
-    ESP.restart();
+    // Restarts once pending settings and card records are on flash
+    wifiSetupManager.resetStoredWiFi();
 }
 
 ResetCardManager resetCardManager;
\ No newline at end of file
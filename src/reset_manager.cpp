@@ -1,4 +1,7 @@
 #include "reset_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_RESET
 
 ResetManager ResetManager::instance;
 
@@ -20,7 +23,7 @@ void ResetManager::update()
         {
             firstPressTime = millis();
             waitingForSecondPress = true;
-            Serial.println("Entering Hard Reset arming mode. Waiting for second press within 5 seconds...");
+            LOG_I("Entering Hard Reset arming mode. Waiting for second press within 5 seconds...");
             LEDManager::getInstance().signalResetArmed();
         }
         else if (waitingForSecondPress && (millis() - firstPressTime >= DEBOUNCE_DELAY))
@@ -33,7 +36,7 @@ void ResetManager::update()
         // Check for reset timeout
         if (waitingForSecondPress && (millis() - firstPressTime >= RESET_TIMEOUT))
         {
-            Serial.println("Hard reset timed out. Exiting arming mode.");
+            LOG_W("Hard reset timed out. Exiting arming mode.");
             waitingForSecondPress = false;
             firstPressTime = 0;
             LEDManager::getInstance().signalResetTimeout();
@@ -43,7 +46,7 @@ void ResetManager::update()
 
 void ResetManager::handleReset()
 {
-    Serial.println("Executing hard reset...");
+    LOG_I("Executing hard reset...");
     waitingForSecondPress = false;
     firstPressTime = 0;
     LEDManager::getInstance().signalResetExecuted();
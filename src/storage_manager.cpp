@@ -0,0 +1,227 @@
+#include "storage_manager.h"
+#include "card_log_manager.h"
+#include "card_stats_manager.h"
+#include "clock_manager.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_STORAGE
+
+StorageManager &storageManager = StorageManager::getInstance();
+
+StorageManager::StorageManager()
+    : queue(nullptr), storageTaskHandle(nullptr), inFlight(0), highWater(0), processed(0), dropped(0),
+      lastLatencyUs(0), maxLatencyUs(0), totalLatencyUs(0)
+{
+}
+
+StorageManager &StorageManager::getInstance()
+{
+    static StorageManager instance;
+    return instance;
+}
+
+void StorageManager::begin()
+{
+    if (queue)
+    {
+        return;
+    }
+
+    queue = xQueueCreateStatic(STORAGE_QUEUE_LENGTH, sizeof(StorageRequest), queueStorage, &queueControl);
+    if (!queue)
+    {
+        LOG_E("[STORAGE] Failed to create the storage queue - writing inline");
+        return;
+    }
+
+    xTaskCreatePinnedToCore(
+        storageTaskFunction,
+        "StorageTask",
+        STORAGE_TASK_STACK,
+        this,
+        STORAGE_TASK_PRIORITY,
+        &storageTaskHandle,
+        STORAGE_TASK_CORE);
+
+    LOG_SEPARATOR();
+    LOG_I("[STORAGE] Storage writer started on core %d (%d request queue)",
+          STORAGE_TASK_CORE, STORAGE_QUEUE_LENGTH);
+}
+
+bool StorageManager::enqueue(StorageRequest &request)
+{
+    request.queuedAt = esp_timer_get_time();
+
+    // Before begin() there is no task to hand the work to
+    inFlight++;
+    if (!queue)
+    {
+        process(request);
+        return true;
+    }
+
+    if (xQueueSend(queue, &request, 0) != pdTRUE)
+    {
+        inFlight--;
+        dropped.fetch_add(1);
+        LOG_W("[STORAGE] Storage queue full - request dropped");
+        return false;
+    }
+
+    // Raise the mark unless another task already raised it past depth
+    uint32_t depth = uxQueueMessagesWaiting(queue);
+    uint32_t mark = highWater.load();
+    while (depth > mark && !highWater.compare_exchange_weak(mark, depth))
+    {
+    }
+    return true;
+}
+
+uint32_t StorageManager::appendCardRecord(const char *record, size_t length, uint32_t timestamp)
+{
+    StorageRequest request;
+    request.type = STORAGE_CARD_RECORD;
+    request.timestamp = timestamp;
+    request.length = length > STORAGE_PAYLOAD_SIZE ? STORAGE_PAYLOAD_SIZE : length;
+    request.seq = cardLogManager.reserveSeq();
+    memcpy(request.payload, record, request.length);
+
+    if (!enqueue(request))
+    {
+        cardLogManager.releaseSeq(request.seq);
+        return 0;
+    }
+    return request.seq;
+}
+
+bool StorageManager::appendFile(const char *path, const void *data, size_t length)
+{
+    if (length > STORAGE_PAYLOAD_SIZE)
+    {
+        LOG_W("[STORAGE] Append to %s is too large to queue", path);
+        return false;
+    }
+
+    StorageRequest request;
+    request.type = STORAGE_APPEND_FILE;
+    request.length = length;
+    strlcpy(request.path, path, sizeof(request.path));
+    memcpy(request.payload, data, length);
+    return enqueue(request);
+}
+
+bool StorageManager::removeFile(const char *path)
+{
+    StorageRequest request;
+    request.type = STORAGE_REMOVE_FILE;
+    request.length = 0;
+    strlcpy(request.path, path, sizeof(request.path));
+    return enqueue(request);
+}
+
+bool StorageManager::run(StorageJob job, const void *data, size_t length)
+{
+    if (length > STORAGE_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+
+    StorageRequest request;
+    request.type = STORAGE_RUN_JOB;
+    request.length = length;
+    request.job = job;
+    if (length > 0)
+    {
+        memcpy(request.payload, data, length);
+    }
+    return enqueue(request);
+}
+
+void StorageManager::process(StorageRequest &request)
+{
+    switch (request.type)
+    {
+    case STORAGE_CARD_RECORD:
+        if (!cardLogManager.append((const char *)request.payload, request.length, request.seq, request.timestamp))
+        {
+            LOG_E("[STORAGE] Failed to store card record #%lu", (unsigned long)request.seq);
+        }
+        break;
+
+    case STORAGE_APPEND_FILE:
+    {
+        File file = LittleFS.open(request.path, "a");
+        if (!file)
+        {
+            LOG_E("[STORAGE] Failed to open %s for writing", request.path);
+            break;
+        }
+        if (file.write(request.payload, request.length) != request.length)
+        {
+            LOG_E("[STORAGE] Short write to %s", request.path);
+        }
+        file.close();
+        break;
+    }
+
+    case STORAGE_REMOVE_FILE:
+        if (LittleFS.exists(request.path))
+        {
+            LittleFS.remove(request.path);
+        }
+        break;
+
+    case STORAGE_RUN_JOB:
+        if (request.job)
+        {
+            request.job(request.payload, request.length);
+        }
+        break;
+    }
+
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - request.queuedAt);
+    lastLatencyUs = latency;
+    if (latency > maxLatencyUs)
+    {
+        maxLatencyUs = latency;
+    }
+    totalLatencyUs += latency;
+    processed.fetch_add(1);
+    inFlight--;
+}
+
+void StorageManager::storageTaskFunction(void *parameter)
+{
+    StorageManager *manager = static_cast<StorageManager *>(parameter);
+
+    while (true)
+    {
+        if (xQueueReceive(manager->queue, &manager->current, STORAGE_IDLE_TICKS) == pdTRUE)
+        {
+            manager->process(manager->current);
+        }
+        else
+        {
+            // Nothing queued - finish a deferred resolve, sweep stale card log
+            // segments and save statistics
+            clockManager.update();
+            cardLogManager.update();
+            cardStatsManager.update();
+        }
+    }
+}
+
+StorageStats StorageManager::getStats() const
+{
+    StorageStats stats;
+    stats.depth = queue ? uxQueueMessagesWaiting(queue) : 0;
+    stats.highWater = highWater;
+    stats.capacity = STORAGE_QUEUE_LENGTH;
+    stats.processed = processed;
+    stats.dropped = dropped;
+    stats.lastLatencyUs = lastLatencyUs;
+    stats.maxLatencyUs = maxLatencyUs;
+    uint32_t count = stats.processed;
+    stats.avgLatencyUs = count ? (uint32_t)(totalLatencyUs / count) : 0;
+    return stats;
+}
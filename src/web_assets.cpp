@@ -0,0 +1,81 @@
+#include "web_assets.h"
+#include <LittleFS.h>
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_STORAGE
+
+#define WEB_LEGACY_MAX_FILES 48
+
+// Only UI files; settings and the card log share the directory
+static bool isLegacyWebFile(const char *name)
+{
+    static const char *const EXTENSIONS[] = {".html", ".css", ".js", ".png", ".ico", ".gz"};
+    const char *dot = strrchr(name, '.');
+    if (!dot)
+    {
+        return false;
+    }
+    for (const char *extension : EXTENSIONS)
+    {
+        if (strcmp(dot, extension) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Collect removable files below dir; paths are removed after the listing
+static void listLegacyWebFiles(const char *dir, String *paths, uint8_t &count)
+{
+    File root = LittleFS.open(dir);
+    if (!root || !root.isDirectory())
+    {
+        return;
+    }
+
+    File entry = root.openNextFile();
+    while (entry && count < WEB_LEGACY_MAX_FILES)
+    {
+        const char *base = strrchr(entry.name(), '/');
+        String path = String(dir) + "/" + (base ? base + 1 : entry.name());
+        if (entry.isDirectory())
+        {
+            entry.close();
+            listLegacyWebFiles(path.c_str(), paths, count);
+        }
+        else
+        {
+            if (isLegacyWebFile(path.c_str()))
+            {
+                paths[count++] = path;
+            }
+            entry.close();
+        }
+        entry = root.openNextFile();
+    }
+    root.close();
+}
+
+void removeLegacyWebFiles()
+{
+    String paths[WEB_LEGACY_MAX_FILES];
+    uint8_t count = 0;
+    listLegacyWebFiles(WEB_LEGACY_DIR, paths, count);
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        LittleFS.remove(paths[i]);
+    }
+    // Only succeeds once they are empty
+    LittleFS.rmdir(WEB_LEGACY_DIR "/css");
+    LittleFS.rmdir(WEB_LEGACY_DIR "/js");
+    LittleFS.rmdir(WEB_LEGACY_DIR "/img");
+
+    LOG_SEPARATOR();
+    LOG_I("[WEB] Removed %u web UI file(s) left on LittleFS; the UI is now served from firmware", count);
+}
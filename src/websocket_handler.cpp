@@ -2,504 +2,378 @@
 #include "reader_manager.h"
 #include "gpio_manager.h"
 #include "card_processor.h"
+#include "card_log_manager.h"
+#include "credential_index.h"
+#include "card_stats_manager.h"
+#include "storage_manager.h"
+#include "clock_manager.h"
+#include "config_manager.h"
+#include "console_stream.h"
+#include "card_stream.h"
+#include "websocket_protocol.h"
+#include "command_executor.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_WEBSOCKET
 
 extern NotificationManager &notificationManager;
 extern ReaderManager &readerManager;
 extern CardProcessor cardProcessor;
 
-void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+// Filled by the async TCP task, drained by the main loop
+static QueueHandle_t eventQueue = nullptr;
+static StaticQueue_t eventQueueControl;
+static uint8_t eventQueueStorage[WS_QUEUE_LENGTH * sizeof(WebSocketEvent)];
+static volatile uint32_t droppedMessages = 0;
+static volatile uint32_t rejectedMessages = 0;
+
+static Command newCommand(uint32_t client, CommandType type)
+{
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.type = type;
+    command.client = client;
+    return command;
+}
+
+// Commands that carry no arguments
+static void submitCommand(uint32_t client, CommandType type)
+{
+    Command command = newCommand(client, type);
+    commandExecutor.submit(command);
+}
+
+static void sendError(uint32_t client, const char *message)
+{
+    JsonDocument response;
+    response["status"] = "error";
+    response["message"] = message;
+    webSocketProtocol.send(client, response);
+}
+
+static void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
+                             void *arg, uint8_t *data, size_t length)
 {
-    String message;
+    // Async TCP task: copy the message out and return
+    WebSocketEvent event;
+    event.client = client->id();
+    event.length = 0;
 
     switch (type)
     {
-    case WStype_DISCONNECTED:
+    case WS_EVT_CONNECT:
+        event.type = WS_EVENT_CONNECT;
         break;
-    case WStype_CONNECTED:
+    case WS_EVT_DISCONNECT:
+        event.type = WS_EVENT_DISCONNECT;
+        break;
+    case WS_EVT_DATA:
     {
-        IPAddress ip = websockets.remoteIP(num);
-        websockets.sendTXT(num, "Connected to Doppelgänger server.");
+        AwsFrameInfo *info = (AwsFrameInfo *)arg;
+        if (!info->final || info->index != 0 || info->len != length || length > WS_MESSAGE_SIZE)
+        {
+            rejectedMessages++;
+            LOG_W("[WEBSOCKET] Ignoring a %lu byte message from client %lu; commands must fit one %u byte frame",
+                  (unsigned long)info->len, (unsigned long)event.client, (unsigned)WS_MESSAGE_SIZE);
+            return;
+        }
+        event.type = info->opcode == WS_BINARY ? WS_EVENT_BINARY : WS_EVENT_TEXT;
+        event.length = length;
+        memcpy(event.payload, data, length);
     }
     break;
-    case WStype_TEXT:
-        message = String((char *)(payload));
+    default:
+        return;
+    }
 
-        if (DEBUG_ENABLED)
+    // Never waits: the TCP task serves every HTTP request too. A lost
+    // disconnect is caught when the streams and encodings are pruned
+    if (xQueueSend(eventQueue, &event, 0) != pdTRUE)
+    {
+        droppedMessages++;
+        LOG_W("[WEBSOCKET] Event queue full; dropped an event from client %lu", (unsigned long)event.client);
+    }
+}
+
+void beginWebSocket(AsyncWebServer &server)
+{
+    eventQueue = xQueueCreateStatic(WS_QUEUE_LENGTH, sizeof(WebSocketEvent), eventQueueStorage, &eventQueueControl);
+    websockets.onEvent(onWebSocketEvent);
+    server.addHandler(&websockets);
+}
+
+WebSocketQueueStats getWebSocketStats()
+{
+    WebSocketQueueStats stats;
+    stats.clients = websockets.count();
+    stats.queued = eventQueue ? uxQueueMessagesWaiting(eventQueue) : 0;
+    stats.dropped = droppedMessages;
+    stats.rejected = rejectedMessages;
+    return stats;
+}
+
+static void handleWebSocketEvent(const WebSocketEvent &event)
+{
+    uint32_t num = event.client;
+    const uint8_t *payload = event.payload;
+    size_t length = event.length;
+
+    switch (event.type)
+    {
+    case WS_EVENT_DISCONNECT:
+        consoleStream.unsubscribe(num);
+        cardStream.unsubscribe(num);
+        webSocketProtocol.reset(num);
+        break;
+    case WS_EVENT_CONNECT:
+    {
+        webSocketProtocol.reset(num);
+        websockets.text(num, "Connected to Doppelgänger server.");
+    }
+    break;
+    case WS_EVENT_TEXT:
+    case WS_EVENT_BINARY:
+    {
+        LOG_D("======================================================================");
+        bool binary = event.type == WS_EVENT_BINARY;
+        if (!binary)
         {
-            Serial.println("======================================================================");
-            Serial.printf("[WEBSOCKET] Client sent instructions: ");
-            Serial.println(message);
+            LOG_D("[WEBSOCKET] Client sent instructions: %.*s", (int)length, (const char *)payload);
+        }
+        else
+        {
+            LOG_D("[WEBSOCKET] Client sent %u bytes of MessagePack instructions", (unsigned)length);
         }
 
         JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, message);
+        if (!webSocketProtocol.decode(binary, payload, length, doc))
+        {
+            return;
+        }
 
-        if (error)
+        // Encoding negotiation comes alone
+        if (webSocketProtocol.negotiate(num, doc))
         {
-            if (DEBUG_ENABLED)
-            {
-                logger.logDebugStatus("deserializeJson() failed");
-            }
             return;
         }
 
-        // Handle debug state changes
-        if (doc["DEBUG"].is<bool>())
+        // Browser clock - used until SNTP has synced
+        if (doc["TIME"].is<uint32_t>())
         {
-            bool newDebugState = doc["DEBUG"].as<bool>();
-            if (debugManager.updateDebugState(newDebugState))
+            clockManager.setFromBrowser(doc["TIME"].as<uint32_t>());
+        }
+
+        // Debug state changes apply without a restart
+        if (doc["DEBUG"].is<bool>() || doc["LOG_LEVEL"].is<const char *>())
+        {
+            Command command = newCommand(num, COMMAND_DEBUG);
+            command.debug.setEnabled = doc["DEBUG"].is<bool>();
+            command.debug.enabled = doc["DEBUG"] | false;
+            command.debug.logLevel = debugManager.getLogLevel();
+            if (doc["LOG_LEVEL"].is<const char *>() &&
+                !consoleLogLevelFromName(doc["LOG_LEVEL"], command.debug.logLevel))
             {
-                if (DEBUG_ENABLED)
-                {
-                    logger.logDebugStatus("Debug settings updated successfully");
-                }
-                ESP.restart();
+                sendError(num, "Failed to update debug settings");
             }
             else
             {
-                if (DEBUG_ENABLED)
-                {
-                    logger.logDebugStatus("Failed to update debug settings");
-                }
+                commandExecutor.submit(command);
             }
         }
 
-        // Handle reader configuration changes
-        if (doc["READER_TYPE"].is<const char *>())
+        // Live console: {"CONSOLE": "debug"} streams lines up to that level
+        // to this client, {"CONSOLE": "none"} stops it
+        if (doc["CONSOLE"].is<const char *>())
         {
-            String readerType = doc["READER_TYPE"].as<String>();
-            ReaderType newType = (readerType == "PAXTON") ? READER_PAXTON : READER_HID;
-            
-            Serial.println("======================================================================");
-            Serial.print("[WEBSOCKET] Changing reader type to: ");
-            Serial.println(readerType);
-            
-            readerManager.switchMode(newType);
-            
+            uint8_t level;
             JsonDocument response;
-            response["status"] = "success";
-            response["reader_type"] = readerType;
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
-            
-            Serial.println("[WEBSOCKET] Reader configuration updated successfully.");
+            if (!consoleLogLevelFromName(doc["CONSOLE"], level))
+            {
+                response["status"] = "error";
+                response["message"] = "Unknown console level";
+            }
+            else if (!consoleStream.subscribe(num, level))
+            {
+                response["status"] = "error";
+                response["message"] = "Too many console viewers";
+            }
+            else
+            {
+                response["status"] = "success";
+                response["console_level"] = consoleLogLevelName(level);
+            }
+            webSocketProtocol.send(num, response);
         }
 
-        // Handle GPIO configuration
-        if (doc["pin35_enabled"].is<bool>() || doc["pin36_enabled"].is<bool>() ||
-            doc["pin35_pulse_duration"].is<int>() || doc["pin36_pulse_duration"].is<int>())
+        // Live reads: {"CARDS": true} pushes every new read to this client,
+        // {"CARDS": false} stops it
+        if (doc["CARDS"].is<bool>())
         {
-            bool pin35Enabled = doc["pin35_enabled"] | false;
-            bool pin36Enabled = doc["pin36_enabled"] | false;
-            bool pin35DefaultHigh = doc["pin35_default_high"] | false;
-            bool pin36DefaultHigh = doc["pin36_default_high"] | false;
-            int pin35PulseDuration = doc["pin35_pulse_duration"] | 1000;
-            int pin36PulseDuration = doc["pin36_pulse_duration"] | 1000;
-
-            GPIOManager::getInstance().setPin35Enabled(pin35Enabled, pin35DefaultHigh);
-            GPIOManager::getInstance().setPin36Enabled(pin36Enabled, pin36DefaultHigh);
-            GPIOManager::getInstance().setPin35PulseDuration(pin35PulseDuration);
-            GPIOManager::getInstance().setPin36PulseDuration(pin36PulseDuration);
-
-            cardProcessor.setPin35OnCardRead(pin35Enabled);
-            cardProcessor.setPin36OnCardRead(pin36Enabled);
-
-            File gpioConfigFile = LittleFS.open("/www/gpio.json", "w");
-            if (gpioConfigFile)
+            JsonDocument response;
+            response["source"] = "live";
+            if (!doc["CARDS"].as<bool>())
             {
-                JsonDocument gpioDoc;
-                gpioDoc["pin35_enabled"] = pin35Enabled;
-                gpioDoc["pin36_enabled"] = pin36Enabled;
-                gpioDoc["pin35_default_high"] = pin35DefaultHigh;
-                gpioDoc["pin36_default_high"] = pin36DefaultHigh;
-                gpioDoc["pin35_pulse_duration"] = pin35PulseDuration;
-                gpioDoc["pin36_pulse_duration"] = pin36PulseDuration;
-                serializeJson(gpioDoc, gpioConfigFile);
-                gpioConfigFile.close();
+                cardStream.unsubscribe(num);
+                response["status"] = "success";
+                response["subscribed"] = false;
             }
-
-            JsonDocument response;
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+            else if (!cardStream.subscribe(num))
+            {
+                response["status"] = "error";
+                response["message"] = "Too many live viewers";
+            }
+            else
+            {
+                response["status"] = "success";
+                response["subscribed"] = true;
+            }
+            webSocketProtocol.send(num, response);
         }
 
-        // Handle GPIO reset
-        if (doc["reset_gpio"] == true)
+        // Everything below changes settings or stored data; the executor
+        // carries it out off the loop and reports back with the command ID
+        if (doc["READER_TYPE"].is<const char *>())
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Resetting GPIO settings to factory defaults...");
-            GPIOManager::getInstance().resetToDefaults();
-            cardProcessor.setPin35OnCardRead(false);
-            cardProcessor.setPin36OnCardRead(false);
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] GPIO settings have been restored to factory defaults.");
-
-            JsonDocument response;
-            response["source"] = "gpio";
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+            Command command = newCommand(num, COMMAND_READER_TYPE);
+            command.readerType = strcmp(doc["READER_TYPE"], "PAXTON") == 0 ? READER_PAXTON : READER_HID;
+            commandExecutor.submit(command);
         }
 
-        bool erase_cards = doc["WIPE_CARDS"];
-        bool reset_wireless = doc["WIPE_WIFI"];
-        bool restore_notifications_config = doc["WIPE_CONFIG"];
-        String notification_settings = doc["enable_email"];
-
-        bool default_reset_card = doc["RESET_CARD"];
-        bool hasRBL = doc["RBL"].is<const char *>() || doc["RBL"].is<int>();
-        bool hasRFC = doc["RFC"].is<const char *>() || doc["RFC"].is<int>();
-        bool hasRCN = doc["RCN"].is<const char *>() || doc["RCN"].is<int>();
-        bool hasPaxtonResetHex = doc["PAXTON_RESET_HEX"].is<const char *>();
-
-        bool default_settings = doc["RESET_DEVICE"];
-
-        if (erase_cards)
+        // GPIO configuration: all four settings in one commit
+        if (doc["pin35_enabled"].is<bool>() || doc["pin36_enabled"].is<bool>() ||
+            doc["pin35_pulse_duration"].is<int>() || doc["pin36_pulse_duration"].is<int>())
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Clearing stored cards from the device...");
-            LittleFS.remove(CARDS_CSV_FILE);
-            delay(1000);
-            File csvCards = LittleFS.open(CARDS_CSV_FILE, "w");
-            csvCards.close();
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Stored card data has been cleared.");
-
-            JsonDocument response;
-            response["source"] = "cards";
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+            Command command = newCommand(num, COMMAND_GPIO);
+            command.gpio.pin35Enabled = doc["pin35_enabled"] | false;
+            command.gpio.pin36Enabled = doc["pin36_enabled"] | false;
+            command.gpio.pin35DefaultHigh = doc["pin35_default_high"] | false;
+            command.gpio.pin36DefaultHigh = doc["pin36_default_high"] | false;
+            command.gpio.pin35PulseMs = doc["pin35_pulse_duration"] | 1000;
+            command.gpio.pin36PulseMs = doc["pin36_pulse_duration"] | 1000;
+            commandExecutor.submit(command);
         }
 
-        if (restore_notifications_config)
+        if (doc["CARD_LOG_MAX_KB"].is<int>() || doc["CARD_LOG_POLICY"].is<const char *>())
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Restoring notification configuration to factory defaults...");
-
-            LittleFS.remove(NOTIFICATION_CONFIG_FILE);
-            delay(1000);
-
-            JsonDocument notifyDoc;
-            notifyDoc["enable_email"] = false;
-            notifyDoc["smtp_host"] = "";
-            notifyDoc["smtp_port"] = "";
-            notifyDoc["smtp_user"] = "";
-            notifyDoc["smtp_recipient"] = "";
-
-            File jsonConfig = LittleFS.open(NOTIFICATION_CONFIG_FILE, "w");
-            if (jsonConfig)
-            {
-                serializeJson(notifyDoc, jsonConfig);
-                jsonConfig.close();
-            }
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Notification preferences have been restored to defaults.");
-
-            emailManager.readConfig();
-
-            JsonDocument response;
-            response["source"] = "notifications";
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+            uint32_t maxKB = doc["CARD_LOG_MAX_KB"] | (int)(cardLogManager.getMaxBytes() / 1024);
+            Command command = newCommand(num, COMMAND_CARD_LOG_CAPACITY);
+            command.cardLog.maxBytes = maxKB * 1024;
+            command.cardLog.policy = strcmp(doc["CARD_LOG_POLICY"] | "evict", "stop") == 0 ? CARD_LOG_STOP_WHEN_FULL
+                                                                                          : CARD_LOG_EVICT_OLDEST;
+            commandExecutor.submit(command);
         }
 
-        if (default_reset_card)
+        // Credential de-duplication options
+        if (doc["CREDENTIAL_RENOTIFY_MIN"].is<int>() || doc["CREDENTIAL_LOG_REPEATS"].is<bool>())
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Restoring the Reset Card to the default values...");
-            LittleFS.remove(RESET_CARD_FILE);
-            delay(1000);
-            File resetCardFile = LittleFS.open(RESET_CARD_FILE, "w");
-            resetCardFile.close();
-            resetCardManager.setDefaultResetCard();
-            Serial.println("");
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Reset Card default values have been restored.");
-
-            JsonDocument response;
-            response["source"] = "reset_card";
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+            uint32_t renotifyMin = doc["CREDENTIAL_RENOTIFY_MIN"] | (int)(credentialIndex.getRenotifySeconds() / 60);
+            Command command = newCommand(num, COMMAND_CREDENTIAL_OPTIONS);
+            command.credentials.renotifySeconds = renotifyMin * 60;
+            command.credentials.logRepeats = doc["CREDENTIAL_LOG_REPEATS"] | credentialIndex.getLogRepeats();
+            commandExecutor.submit(command);
         }
 
-        if (reset_wireless)
+        if (doc["reset_gpio"] == true)
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Removing stored wireless credentials...");
-            wifiSetupManager.resetStoredWiFi();
+            submitCommand(num, COMMAND_RESET_GPIO);
+        }
 
-            JsonDocument response;
-            response["source"] = "wireless";
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+        if (doc["WIPE_CARDS"].as<bool>())
+        {
+            submitCommand(num, COMMAND_WIPE_CARDS);
         }
 
-        if (default_settings)
+        if (doc["WIPE_CONFIG"].as<bool>())
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Restoring factory defaults...");
-
-            LittleFS.remove(CARDS_CSV_FILE);
-            delay(1000);
-            File csvCards = LittleFS.open(CARDS_CSV_FILE, "w");
-            csvCards.close();
-            Serial.println("[WEBSOCKET] Stored card data has been cleared.");
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Resetting notification settings to factory defaults...");
-            LittleFS.remove(NOTIFICATION_CONFIG_FILE);
-            delay(1000);
-            JsonDocument notifyDoc;
-            notifyDoc["enable_email"] = false;
-            notifyDoc["smtp_host"] = "";
-            notifyDoc["smtp_port"] = "";
-            notifyDoc["smtp_user"] = "";
-            notifyDoc["smtp_recipient"] = "";
-            File jsonConfig = LittleFS.open(NOTIFICATION_CONFIG_FILE, "w");
-            if (jsonConfig)
-            {
-                serializeJson(notifyDoc, jsonConfig);
-                jsonConfig.close();
-            }
-            emailManager.readConfig();
-            Serial.println("[WEBSOCKET] Notification settings have been restored.");
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Resetting GPIO settings to factory defaults...");
-            GPIOManager::getInstance().resetToDefaults();
-            cardProcessor.setPin35OnCardRead(false);
-            cardProcessor.setPin36OnCardRead(false);
-            Serial.println("[WEBSOCKET] GPIO settings have been restored to factory defaults.");
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Restoring the Reset Card to default values...");
-            LittleFS.remove(RESET_CARD_FILE);
-            delay(1000);
-            resetCardManager.setDefaultResetCard();
-            Serial.println("");
-            Serial.println("[WEBSOCKET] Reset Card default values have been restored.");
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Removing stored WiFi credentials...");
-            wifiSetupManager.resetSettings();
+            submitCommand(num, COMMAND_RESTORE_NOTIFICATIONS);
+        }
 
-            JsonDocument response;
-            response["source"] = "system";
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Reset device to factory defaults. Restarting the device.");
-            delay(3000);
-            ESP.restart();
+        if (doc["RESET_CARD"].as<bool>())
+        {
+            submitCommand(num, COMMAND_RESET_CARD_DEFAULTS);
         }
 
-        if (notification_settings == "true" || notification_settings == "false")
+        // These two restart the device once they have completed
+        if (doc["WIPE_WIFI"].as<bool>())
         {
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Saving notification configuration...");
-
-            JsonDocument notificationDoc;
-            notificationDoc["enable_email"] = doc["enable_email"];
-            notificationDoc["smtp_host"] = doc["smtp_host"];
-            notificationDoc["smtp_port"] = doc["smtp_port"];
-            notificationDoc["smtp_user"] = doc["smtp_user"];
-            notificationDoc["smtp_pass"] = doc["smtp_pass"];
-            notificationDoc["smtp_recipient"] = doc["smtp_recipient"];
-
-            File notificationConfigFile = LittleFS.open(NOTIFICATION_CONFIG_FILE, "w");
-            if (!notificationConfigFile)
-            {
-                Serial.println("[WEBSOCKET] Failed to open configuration file for writing");
-            }
+            submitCommand(num, COMMAND_WIPE_WIFI);
+        }
 
-            serializeJsonPretty(notificationDoc, Serial);
-            if (serializeJson(notificationDoc, notificationConfigFile) == 0)
-            {
-                Serial.println(F("[WEBSOCKET] Failed to write data to config file"));
-            }
-            notificationConfigFile.close();
-            Serial.println("");
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] File successfully written");
+        if (doc["RESET_DEVICE"].as<bool>())
+        {
+            submitCommand(num, COMMAND_FACTORY_RESET);
+        }
 
-            JsonDocument response;
-            response["status"] = "success";
-            String responseStr;
-            serializeJson(response, responseStr);
-            websockets.sendTXT(num, responseStr);
+        String notificationSettings = doc["enable_email"];
+        if (notificationSettings == "true" || notificationSettings == "false")
+        {
+            Command command = newCommand(num, COMMAND_NOTIFICATIONS);
+            NotificationConfig &notifications = command.notifications;
+            notifications.enableEmail = notificationSettings == "true";
+            strlcpy(notifications.smtpHost, doc["smtp_host"] | "", sizeof(notifications.smtpHost));
+            strlcpy(notifications.smtpPort, doc["smtp_port"] | "", sizeof(notifications.smtpPort));
+            strlcpy(notifications.smtpUser, doc["smtp_user"] | "", sizeof(notifications.smtpUser));
+            strlcpy(notifications.smtpPass, doc["smtp_pass"] | "", sizeof(notifications.smtpPass));
+            strlcpy(notifications.smtpRecipient, doc["smtp_recipient"] | "", sizeof(notifications.smtpRecipient));
+            commandExecutor.submit(command);
         }
 
+        bool hasRBL = doc["RBL"].is<const char *>() || doc["RBL"].is<int>();
+        bool hasRFC = doc["RFC"].is<const char *>() || doc["RFC"].is<int>();
+        bool hasRCN = doc["RCN"].is<const char *>() || doc["RCN"].is<int>();
         if (hasRBL && hasRFC && hasRCN)
         {
-            int resetBL = doc["RBL"].as<int>();
-            int resetFC = doc["RFC"].as<int>();
-            int resetCN = doc["RCN"].as<int>();
-
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Updating Reset Card file...");
-            File resetCardFile = LittleFS.open(RESET_CARD_FILE, "r");
-            JsonDocument resetDoc;
-            String existingPaxtonHex = "0000001337";
-            
-            if (resetCardFile)
-            {
-                String existingData = resetCardFile.readString();
-                resetCardFile.close();
-                JsonDocument existingDoc;
-                DeserializationError error = deserializeJson(existingDoc, existingData);
-                if (!error)
-                {
-                    existingPaxtonHex = existingDoc["PAXTON_RESET_HEX"] | "0000001337";
-                }
-            }
-            
-            resetCardFile = LittleFS.open(RESET_CARD_FILE, "w");
-            if (resetCardFile)
-            {
-                resetDoc["RBL"] = resetBL;
-                resetDoc["RFC"] = resetFC;
-                resetDoc["RCN"] = resetCN;
-                resetDoc["PAXTON_RESET_HEX"] = existingPaxtonHex;
-                serializeJson(resetDoc, resetCardFile);
-                resetCardFile.close();
-                Serial.println("[RESET] Writing the default Reset Card values...");
-                serializeJson(resetDoc, Serial);
-                Serial.println();
-                Serial.println("======================================================================");
-                Serial.println("[WEBSOCKET] Successfully updated Reset Card file");
-
-                JsonDocument response;
-                response["status"] = "success";
-                String responseStr;
-                serializeJson(response, responseStr);
-                websockets.sendTXT(num, responseStr);
-            }
-            else
-            {
-                Serial.println("[WEBSOCKET] Failed to open the JSON file for writing.");
-                JsonDocument response;
-                response["status"] = "error";
-                response["message"] = "Failed to open Reset Card file for writing";
-                String responseStr;
-                serializeJson(response, responseStr);
-                websockets.sendTXT(num, responseStr);
-            }
+            Command command = newCommand(num, COMMAND_RESET_CARD);
+            command.resetCard.bitLength = doc["RBL"].as<int>();
+            command.resetCard.facilityCode = doc["RFC"].as<int>();
+            command.resetCard.cardNumber = doc["RCN"].as<int>();
+            commandExecutor.submit(command);
         }
 
-        if (hasPaxtonResetHex)
+        if (doc["PAXTON_RESET_HEX"].is<const char *>())
         {
             String hex = doc["PAXTON_RESET_HEX"].as<String>();
             hex.toUpperCase();
-            
-            if (hex.length() != 10)
+
+            if (hex.length() != CONFIG_PAXTON_HEX_LENGTH)
             {
-                JsonDocument response;
-                response["status"] = "error";
-                response["message"] = "HEX value must be exactly 10 characters";
-                String responseStr;
-                serializeJson(response, responseStr);
-                websockets.sendTXT(num, responseStr);
+                sendError(num, "HEX value must be exactly 10 characters");
                 return;
             }
-            
-            bool validHex = true;
+
             for (int i = 0; i < hex.length(); i++)
             {
                 char c = hex.charAt(i);
                 if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F')))
                 {
-                    validHex = false;
-                    break;
+                    sendError(num, "HEX value must contain only hexadecimal characters (0-9, A-F)");
+                    return;
                 }
             }
-            
-            if (!validHex)
-            {
-                JsonDocument response;
-                response["status"] = "error";
-                response["message"] = "HEX value must contain only hexadecimal characters (0-9, A-F)";
-                String responseStr;
-                serializeJson(response, responseStr);
-                websockets.sendTXT(num, responseStr);
-                return;
-            }
 
-            Serial.println("======================================================================");
-            Serial.println("[WEBSOCKET] Updating Paxton Reset Card...");
-            File resetCardFile = LittleFS.open(RESET_CARD_FILE, "r");
-            JsonDocument resetDoc;
-            int existingRBL = 35, existingRFC = 111, existingRCN = 4444;
-            
-            // Read existing file to preserve HID reset card values
-            if (resetCardFile)
-            {
-                String existingData = resetCardFile.readString();
-                resetCardFile.close();
-                JsonDocument existingDoc;
-                DeserializationError error = deserializeJson(existingDoc, existingData);
-                if (!error)
-                {
-                    existingRBL = existingDoc["RBL"] | 35;
-                    existingRFC = existingDoc["RFC"] | 111;
-                    existingRCN = existingDoc["RCN"] | 4444;
-                }
-            }
-            
-            resetCardFile = LittleFS.open(RESET_CARD_FILE, "w");
-            if (resetCardFile)
-            {
-                resetDoc["RBL"] = existingRBL;
-                resetDoc["RFC"] = existingRFC;
-                resetDoc["RCN"] = existingRCN;
-                resetDoc["PAXTON_RESET_HEX"] = hex;
-                serializeJson(resetDoc, resetCardFile);
-                resetCardFile.close();
-                Serial.print("[RESET] Paxton Reset Card HEX updated to: ");
-                Serial.println(hex);
-                Serial.println("======================================================================");
-                Serial.println("[WEBSOCKET] Successfully updated Paxton Reset Card");
-
-                JsonDocument response;
-                response["status"] = "success";
-                String responseStr;
-                serializeJson(response, responseStr);
-                websockets.sendTXT(num, responseStr);
-            }
-            else
-            {
-                Serial.println("[WEBSOCKET] Failed to open the JSON file for writing.");
-                JsonDocument response;
-                response["status"] = "error";
-                response["message"] = "Failed to open Reset Card file for writing";
-                String responseStr;
-                serializeJson(response, responseStr);
-                websockets.sendTXT(num, responseStr);
-            }
+            Command command = newCommand(num, COMMAND_PAXTON_RESET_CARD);
+            strlcpy(command.paxtonHex, hex.c_str(), sizeof(command.paxtonHex));
+            commandExecutor.submit(command);
         }
+    }
+    break;
+    }
+}
 
-        doc.clear();
+void processWebSocketEvents()
+{
+    static unsigned long lastCleanup = 0;
+    if (millis() - lastCleanup >= WS_CLEANUP_INTERVAL_MS)
+    {
+        lastCleanup = millis();
+        websockets.cleanupClients(WS_MAX_CLIENTS);
+        webSocketProtocol.prune();
+    }
 
-        delay(1000);
-        if (reset_wireless || default_settings)
-        {
-            ESP.restart();
-        }
+    // One message per pass keeps a burst of commands from delaying a read
+    static WebSocketEvent event;
+    if (eventQueue && xQueueReceive(eventQueue, &event, 0) == pdTRUE)
+    {
+        handleWebSocketEvent(event);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,180 @@
+#include "websocket_protocol.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_WEBSOCKET
+
+extern AsyncWebSocket websockets;
+
+WebSocketProtocol &webSocketProtocol = WebSocketProtocol::getInstance();
+
+WebSocketProtocol::WebSocketProtocol() : binaryClients{}, stats{}
+{
+}
+
+WebSocketProtocol &WebSocketProtocol::getInstance()
+{
+    static WebSocketProtocol instance;
+    return instance;
+}
+
+void WebSocketProtocol::reset(uint32_t client)
+{
+    setEncoding(client, WS_ENCODING_JSON);
+}
+
+void WebSocketProtocol::setEncoding(uint32_t client, WsEncoding encoding)
+{
+    std::lock_guard<std::mutex> lock(frameMutex);
+    for (uint8_t i = 0; i < WS_PROTOCOL_MAX_CLIENTS; i++)
+    {
+        if (binaryClients[i] == client)
+        {
+            binaryClients[i] = 0;
+        }
+    }
+    if (encoding != WS_ENCODING_MSGPACK)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < WS_PROTOCOL_MAX_CLIENTS; i++)
+    {
+        if (binaryClients[i] == 0)
+        {
+            binaryClients[i] = client;
+            return;
+        }
+    }
+}
+
+WsEncoding WebSocketProtocol::getEncoding(uint32_t client)
+{
+    std::lock_guard<std::mutex> lock(frameMutex);
+    for (uint8_t i = 0; i < WS_PROTOCOL_MAX_CLIENTS; i++)
+    {
+        if (binaryClients[i] == client)
+        {
+            return WS_ENCODING_MSGPACK;
+        }
+    }
+    return WS_ENCODING_JSON;
+}
+
+bool WebSocketProtocol::isConnected(uint32_t client)
+{
+    return websockets.client(client) != nullptr;
+}
+
+void WebSocketProtocol::prune()
+{
+    for (uint8_t i = 0; i < WS_PROTOCOL_MAX_CLIENTS; i++)
+    {
+        uint32_t client;
+        {
+            std::lock_guard<std::mutex> lock(frameMutex);
+            client = binaryClients[i];
+        }
+        if (client != 0 && !isConnected(client))
+        {
+            reset(client);
+        }
+    }
+}
+
+bool WebSocketProtocol::decode(bool binary, const uint8_t *payload, size_t length, JsonDocument &doc)
+{
+    DeserializationError error = binary ? deserializeMsgPack(doc, payload, length)
+                                        : deserializeJson(doc, payload, length);
+    if (error)
+    {
+        LOG_D("[WEBSOCKET] Could not decode %s message: %s", binary ? "binary" : "text", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool WebSocketProtocol::negotiate(uint32_t client, JsonDocument &doc)
+{
+    if (doc["HELLO"].isNull())
+    {
+        return false;
+    }
+
+    // A client may offer several encodings; the first one known here wins
+    WsEncoding encoding = WS_ENCODING_JSON;
+    for (JsonVariant offered : doc["HELLO"]["encodings"].as<JsonArray>())
+    {
+        if (offered == "msgpack")
+        {
+            encoding = WS_ENCODING_MSGPACK;
+            break;
+        }
+        if (offered == "json")
+        {
+            break;
+        }
+    }
+    uint32_t version = doc["HELLO"]["v"] | 1;
+    LOG_D("[WEBSOCKET] Client %lu speaks v%lu; using %s", (unsigned long)client, (unsigned long)version,
+          encoding == WS_ENCODING_MSGPACK ? "msgpack" : "json");
+
+    // The answer still goes out as JSON so the client can read it
+    reset(client);
+    JsonDocument response;
+    response["source"] = "hello";
+    response["v"] = WS_PROTOCOL_VERSION;
+    response["encoding"] = encoding == WS_ENCODING_MSGPACK ? "msgpack" : "json";
+    send(client, response);
+
+    setEncoding(client, encoding);
+    return true;
+}
+
+bool WebSocketProtocol::send(uint32_t client, const JsonDocument &doc)
+{
+    bool binary = getEncoding(client) == WS_ENCODING_MSGPACK;
+    std::lock_guard<std::mutex> lock(frameMutex);
+
+    // The server queues a copy per client; a full queue is reported as a
+    // failed send so the streams skip ahead instead of piling up frames
+    AsyncWebSocketClient *target = websockets.client(client);
+    if (!target)
+    {
+        return false;
+    }
+    if (!target->canSend())
+    {
+        stats.busy++;
+        return false;
+    }
+
+    size_t needed = binary ? measureMsgPack(doc) : measureJson(doc);
+    if (needed >= sizeof(frame))
+    {
+        stats.oversized++;
+        LOG_W("[WEBSOCKET] %u byte frame does not fit the %u byte buffer", (unsigned)needed, (unsigned)sizeof(frame));
+        return false;
+    }
+
+    size_t length = binary ? serializeMsgPack(doc, frame, sizeof(frame)) : serializeJson(doc, (char *)frame, sizeof(frame));
+    bool sent = binary ? target->binary(frame, length) : target->text((const char *)frame, length);
+    if (sent)
+    {
+        if (binary)
+        {
+            stats.framesMsgPack++;
+            stats.bytesMsgPack += length;
+        }
+        else
+        {
+            stats.framesJson++;
+            stats.bytesJson += length;
+        }
+    }
+    return sent;
+}
+
+WsProtocolStats WebSocketProtocol::getStats()
+{
+    std::lock_guard<std::mutex> lock(frameMutex);
+    return stats;
+}
@@ -2,6 +2,11 @@
 #include "wifi_manager_style.h"
 #include "version_config.h"
 #include <time.h>
+#include "boot_profiler.h"
+#include "command_executor.h"
+#include "log.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_WIFI
 
 WiFiSetupManager::WiFiSetupManager() : connected(false), rssi(0)
 {
@@ -24,10 +29,14 @@ WiFiSetupManager &wifiSetupManager = WiFiSetupManager::getInstance();
 
 void WiFiSetupManager::begin(const char *deviceName, const char *defaultPass, const char *prefixSSID)
 {
+  bootProfiler.start(BOOT_PHASE_WIFI);
   setupWiFiManager(deviceName, defaultPass, prefixSSID);
+  bootProfiler.end(BOOT_PHASE_WIFI);
   if (connected)
   {
+    bootProfiler.start(BOOT_PHASE_MDNS);
     setupMDNS("rfid");
+    bootProfiler.end(BOOT_PHASE_MDNS);
   }
 }
 
@@ -90,30 +99,32 @@ void WiFiSetupManager::setupMDNS(const char *host)
   
   if (!MDNS.begin(host))
   {
-    Serial.println("[MDNS] Error setting up MDNS responder!");
+    LOG_E("[MDNS] Error setting up MDNS responder!");
   }
   else
   {
     MDNS.addService("http", "tcp", 80);
-    Serial.println("[MDNS] MDNS responder started");
-    Serial.print("[MDNS] Device will be reachable at http://");
-    Serial.print(host);
-    Serial.println(".local/");
+    LOG_I("[MDNS] MDNS responder started");
+    LOG_I("[MDNS] Device will be reachable at http://%s.local/", host);
   }
 }
 
 void WiFiSetupManager::resetSettings()
 {
-  Serial.println("======================================");
-  Serial.println("[RESET WIFI] Clearing stored WiFi Access Point...");
+  clearStoredWiFi();
+  commandExecutor.scheduleRestart();
+}
+
+void WiFiSetupManager::clearStoredWiFi()
+{
+  LOG_SEPARATOR();
+  LOG_I("[RESET WIFI] Clearing stored WiFi Access Point...");
   wifiManager.resetSettings();
-  delay(3000);
-  ESP.restart();
 }
 
 void WiFiSetupManager::resetStoredWiFi()
 {
-  Serial.println("======================================================================");
+  LOG_SEPARATOR();
   resetSettings();
 }
 
@@ -146,30 +157,3 @@ int WiFiSetupManager::getRSSI() const
 {
   return rssi;
 }
-
-bool WiFiSetupManager::setupTime()
-{
-  Serial.println("======================================================================");
-  Serial.println("[NTP] Waiting for NTP server to synchronize.");
-  configTime(3, 0, "pool.ntp.org", "time.nist.gov");
-  unsigned long ms = millis();
-
-  time_t now = time(nullptr);
-  while (now < ESP_TIME_DEFAULT_TS && millis() - ms < 10000)
-  {
-    delay(100);
-    now = time(nullptr);
-  }
-
-  if (now > ESP_TIME_DEFAULT_TS)
-  {
-    char timeStr[26];
-    ctime_r(&now, timeStr);
-    timeStr[24] = '\0'; // Remove the newline
-    Serial.print("[NTP] The current time is: ");
-    Serial.print(timeStr);
-    Serial.println(" UTC");
-  }
-
-  return (now > ESP_TIME_DEFAULT_TS);
-}
@@ -0,0 +1,24 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Host stand-in for the Arduino core, for the native test environment.
+// Only what the modules under test use: the C library and a Serial that
+// discards its output.
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+class HostSerial
+{
+public:
+    size_t write(const uint8_t *data, size_t length) { return length; }
+};
+
+inline HostSerial Serial;
+
+#endif // ARDUINO_H
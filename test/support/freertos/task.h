@@ -0,0 +1,36 @@
+#ifndef TASK_H
+#define TASK_H
+
+// Host stand-in for FreeRTOS tasks: a task is a detached thread, and a
+// notification wait is a short sleep, so waiters poll instead
+
+#include <chrono>
+#include <thread>
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth,
+                                          void *parameter, UBaseType_t priority, TaskHandle_t *handle,
+                                          BaseType_t core)
+{
+    std::thread(function, parameter).detach();
+    if (handle)
+    {
+        *handle = (TaskHandle_t)1;
+    }
+    return pdPASS;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task)
+{
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return 0;
+}
+
+#endif // TASK_H
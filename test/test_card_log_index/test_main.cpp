@@ -0,0 +1,257 @@
+#include <unity.h>
+#include "card_log_index.h"
+
+// Record parsing, format lookup and the filter tests behind /api/cards
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static CardIndexEntry parse(const char *record)
+{
+    CardIndexEntry entry;
+    memset(&entry, 0xA5, sizeof(entry));
+    cardIndexParseRecord(record, strlen(record), entry);
+    return entry;
+}
+
+static CardIndexEntry makeEntry(uint32_t seq, uint32_t timestamp, uint8_t format, uint32_t facilityCode, bool hasFc)
+{
+    CardIndexEntry entry = {};
+    entry.seq = seq;
+    entry.timestamp = timestamp;
+    entry.format = format;
+    entry.facilityCode = facilityCode;
+    entry.flags = hasFc ? CARD_INDEX_HAS_FC : 0;
+    return entry;
+}
+
+void test_format_ids(void)
+{
+    uint8_t id = cardIndexFormatId("H10301/Ind26/AWID26", strlen("H10301/Ind26/AWID26"));
+    TEST_ASSERT_TRUE(id != CARD_INDEX_FORMAT_OTHER);
+    TEST_ASSERT_EQUAL_STRING("H10301/Ind26/AWID26", cardIndexFormatName(id));
+
+    // Exact names only: no prefixes, no case folding
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_FORMAT_OTHER, cardIndexFormatId("H10301", 6));
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_FORMAT_OTHER, cardIndexFormatId("net2/em", 7));
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_FORMAT_OTHER, cardIndexFormatId("", 0));
+
+    TEST_ASSERT_EQUAL_STRING("Other", cardIndexFormatName(CARD_INDEX_FORMAT_OTHER));
+    TEST_ASSERT_EQUAL_STRING("Other", cardIndexFormatName(200));
+}
+
+void test_format_mask(void)
+{
+    uint8_t net2 = cardIndexFormatId("Net2/EM", 7);
+    uint8_t wie32 = cardIndexFormatId("WIE32/EM", 8);
+    uint8_t h10301 = cardIndexFormatId("H10301/Ind26/AWID26", 19);
+
+    // Case-insensitive substring of the name
+    TEST_ASSERT_EQUAL_HEX32(1UL << net2, cardIndexFormatMask("net2"));
+    uint32_t em = cardIndexFormatMask("/em");
+    TEST_ASSERT_BITS_HIGH((1UL << net2) | (1UL << wie32), em);
+    TEST_ASSERT_BITS_LOW(1UL << h10301, em);
+    TEST_ASSERT_BITS_HIGH(1UL << h10301, cardIndexFormatMask("awid26"));
+    TEST_ASSERT_EQUAL_HEX32(0, cardIndexFormatMask("no such format"));
+    // The "other" bucket is never part of a name match
+    TEST_ASSERT_BITS_LOW(1UL << CARD_INDEX_FORMAT_OTHER, cardIndexFormatMask(""));
+}
+
+void test_parse_card_record(void)
+{
+    CardIndexEntry entry = parse("DATA_TYPE: CARD, Format: H10301/Ind26/AWID26, Bit_Length: 26, Hex_Value: 2004A57, "
+                                 "Facility_Code: 123, Card_Number: 4567, BIN: 10000000000100101001010111");
+    TEST_ASSERT_EQUAL_UINT8(cardIndexFormatId("H10301/Ind26/AWID26", 19), entry.format);
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_HAS_FC, entry.flags);
+    TEST_ASSERT_EQUAL_UINT32(123, entry.facilityCode);
+}
+
+void test_parse_without_facility_code(void)
+{
+    CardIndexEntry entry = parse("DATA_TYPE: PAXTON, Format: Net2/EM, Bit_Length: 75, Hex_Value: 0000001337, "
+                                 "Facility_Code: N/A, Card_Number: 1337, BIN: 0101");
+    TEST_ASSERT_EQUAL_UINT8(cardIndexFormatId("Net2/EM", 7), entry.format);
+    TEST_ASSERT_EQUAL_UINT8(0, entry.flags);
+    TEST_ASSERT_EQUAL_UINT32(0, entry.facilityCode);
+
+    entry = parse("DATA_TYPE: NO_PARSER, Bit_Length: 19, Hex_Value: N/A, Facility_Code: N/A, Card_Number: N/A");
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_FORMAT_OTHER, entry.format);
+    TEST_ASSERT_EQUAL_UINT8(0, entry.flags);
+}
+
+void test_parse_edge_cases(void)
+{
+    // Format names with spaces and parentheses, field last in the record
+    CardIndexEntry entry = parse("Facility_Code: 0, Format: C1k35s (C-1000)");
+    TEST_ASSERT_EQUAL_UINT8(cardIndexFormatId("C1k35s (C-1000)", 15), entry.format);
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_HAS_FC, entry.flags);
+    TEST_ASSERT_EQUAL_UINT32(0, entry.facilityCode);
+
+    // Unknown format, keys that only share a prefix, a dangling key
+    entry = parse("Format: Mystery99, Facility_Codes: 5, Facility_Code");
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_FORMAT_OTHER, entry.format);
+    TEST_ASSERT_EQUAL_UINT8(0, entry.flags);
+
+    entry = parse("");
+    TEST_ASSERT_EQUAL_UINT8(CARD_INDEX_FORMAT_OTHER, entry.format);
+    TEST_ASSERT_EQUAL_UINT8(0, entry.flags);
+}
+
+void test_parse_respects_length(void)
+{
+    // The payload is a frame, not a C string: bytes past length are ignored
+    const char *record = "Format: Net2/EM, Facility_Code: 77";
+    CardIndexEntry entry;
+    cardIndexParseRecord(record, strlen("Format: Net2/EM"), entry);
+    TEST_ASSERT_EQUAL_UINT8(cardIndexFormatId("Net2/EM", 7), entry.format);
+    TEST_ASSERT_EQUAL_UINT8(0, entry.flags);
+}
+
+void test_entry_filter(void)
+{
+    uint8_t format = cardIndexFormatId("H10301/Ind26/AWID26", 19);
+    CardIndexEntry entry = makeEntry(10, 1700000000, format, 42, true);
+
+    CardLogFilter filter;
+    TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+
+    filter.hasFormat = true;
+    filter.formatMask = cardIndexFormatMask("h10301");
+    TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+    filter.formatMask = cardIndexFormatMask("net2");
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(entry, filter));
+
+    filter = CardLogFilter();
+    filter.hasFacilityCode = true;
+    filter.facilityCode = 42;
+    TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+    filter.facilityCode = 43;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(entry, filter));
+    // A record without a facility code never matches one, not even 0
+    filter.facilityCode = 0;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(makeEntry(10, 1700000000, format, 0, false), filter));
+
+    filter = CardLogFilter();
+    filter.from = 1700000000;
+    filter.to = 1700000000;
+    TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+    filter.from = 1700000001;
+    filter.to = 0;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(entry, filter));
+    filter.from = 0;
+    filter.to = 1699999999;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(entry, filter));
+    // Unknown capture time is outside every time range
+    filter.to = UINT32_MAX;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(makeEntry(10, 0, format, 42, true), filter));
+
+    filter = CardLogFilter();
+    filter.afterSeq = 9;
+    TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+    filter.afterSeq = 10;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(entry, filter));
+    filter = CardLogFilter();
+    filter.beforeSeq = 11;
+    TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+    filter.beforeSeq = 10;
+    TEST_ASSERT_FALSE(cardIndexEntryMatches(entry, filter));
+}
+
+void test_empty_summary(void)
+{
+    CardSegmentSummary summary;
+    cardIndexClearSummary(summary);
+
+    CardLogFilter filter;
+    TEST_ASSERT_TRUE(cardIndexSummaryMayMatch(summary, filter));
+
+    filter.hasFormat = true;
+    filter.formatMask = cardIndexFormatMask("h10301");
+    TEST_ASSERT_FALSE(cardIndexSummaryMayMatch(summary, filter));
+
+    filter = CardLogFilter();
+    filter.hasFacilityCode = true;
+    filter.facilityCode = 1;
+    TEST_ASSERT_FALSE(cardIndexSummaryMayMatch(summary, filter));
+
+    filter = CardLogFilter();
+    filter.from = 1;
+    TEST_ASSERT_FALSE(cardIndexSummaryMayMatch(summary, filter));
+}
+
+void test_summary_time_range(void)
+{
+    CardSegmentSummary summary;
+    cardIndexClearSummary(summary);
+    cardIndexAddToSummary(summary, makeEntry(1, 0, CARD_INDEX_FORMAT_OTHER, 0, false));
+    TEST_ASSERT_EQUAL_UINT32(CARD_INDEX_NO_TIME, summary.minTime);
+
+    cardIndexAddToSummary(summary, makeEntry(2, 1700000100, CARD_INDEX_FORMAT_OTHER, 0, false));
+    cardIndexAddToSummary(summary, makeEntry(3, 1700000000, CARD_INDEX_FORMAT_OTHER, 0, false));
+    TEST_ASSERT_EQUAL_UINT32(1700000000, summary.minTime);
+    TEST_ASSERT_EQUAL_UINT32(1700000100, summary.maxTime);
+
+    CardLogFilter filter;
+    filter.from = 1700000100;
+    TEST_ASSERT_TRUE(cardIndexSummaryMayMatch(summary, filter));
+    filter.from = 1700000101;
+    TEST_ASSERT_FALSE(cardIndexSummaryMayMatch(summary, filter));
+    filter.from = 0;
+    filter.to = 1700000000;
+    TEST_ASSERT_TRUE(cardIndexSummaryMayMatch(summary, filter));
+    filter.to = 1699999999;
+    TEST_ASSERT_FALSE(cardIndexSummaryMayMatch(summary, filter));
+}
+
+void test_summary_has_no_false_negatives(void)
+{
+    // Whatever an entry matches, the summary of a segment holding it must
+    // not rule out
+    CardSegmentSummary summary;
+    cardIndexClearSummary(summary);
+    CardIndexEntry entries[64];
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        entries[i] = makeEntry(i + 1, 1700000000 + i * 37, (uint8_t)(i % 26), i * 97 % 65536, i % 3 != 0);
+        cardIndexAddToSummary(summary, entries[i]);
+    }
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        const CardIndexEntry &entry = entries[i];
+        CardLogFilter filter;
+        filter.active = true;
+        filter.hasFormat = true;
+        filter.formatMask = 1UL << entry.format;
+        filter.from = entry.timestamp;
+        filter.to = entry.timestamp;
+        if (entry.flags & CARD_INDEX_HAS_FC)
+        {
+            filter.hasFacilityCode = true;
+            filter.facilityCode = entry.facilityCode;
+        }
+        TEST_ASSERT_TRUE(cardIndexEntryMatches(entry, filter));
+        TEST_ASSERT_TRUE(cardIndexSummaryMayMatch(summary, filter));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_format_ids);
+    RUN_TEST(test_format_mask);
+    RUN_TEST(test_parse_card_record);
+    RUN_TEST(test_parse_without_facility_code);
+    RUN_TEST(test_parse_edge_cases);
+    RUN_TEST(test_parse_respects_length);
+    RUN_TEST(test_entry_filter);
+    RUN_TEST(test_empty_summary);
+    RUN_TEST(test_summary_time_range);
+    RUN_TEST(test_summary_has_no_false_negatives);
+    return UNITY_END();
+}
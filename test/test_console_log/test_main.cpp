@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "console_log.h"
+
+// The console ring: drops when full, truncation, levels, and many producers
+// against the drain task. ConsoleLog is a singleton, so the tests run in
+// order and compare stats before and after.
+
+static std::mutex tapMutex;
+static std::vector<std::string> lines;
+
+static void captureLine(uint8_t level, const char *text, size_t length)
+{
+    std::lock_guard<std::mutex> lock(tapMutex);
+    lines.push_back(std::string(text, length));
+}
+
+static size_t capturedCount()
+{
+    std::lock_guard<std::mutex> lock(tapMutex);
+    return lines.size();
+}
+
+static bool waitForLines(size_t count)
+{
+    for (int i = 0; i < 2000 && capturedCount() < count; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return capturedCount() >= count;
+}
+
+static bool isDropNotice(const std::string &line)
+{
+    return line.compare(0, 10, "[CONSOLE] ") == 0;
+}
+
+void setUp(void)
+{
+    std::lock_guard<std::mutex> lock(tapMutex);
+    lines.clear();
+}
+
+void tearDown(void)
+{
+}
+
+void test_level_names(void)
+{
+    for (uint8_t level = LOG_LEVEL_NONE; level <= LOG_LEVEL_VERBOSE; level++)
+    {
+        uint8_t parsed = 0xFF;
+        TEST_ASSERT_TRUE(consoleLogLevelFromName(consoleLogLevelName(level), parsed));
+        TEST_ASSERT_EQUAL_UINT8(level, parsed);
+    }
+
+    uint8_t parsed = 0xFF;
+    TEST_ASSERT_TRUE(consoleLogLevelFromName("WARN", parsed));
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_WARN, parsed);
+    TEST_ASSERT_FALSE(consoleLogLevelFromName("loud", parsed));
+    TEST_ASSERT_EQUAL_STRING("verbose", consoleLogLevelName(42));
+}
+
+void test_runtime_level_is_the_most_verbose_output(void)
+{
+    consoleLog.setSerialLevel(LOG_LEVEL_WARN);
+    consoleLog.setStreamLevel(LOG_LEVEL_DEBUG);
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_DEBUG, consoleLog.getLevel());
+    consoleLog.setStreamLevel(LOG_LEVEL_NONE);
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_WARN, consoleLog.getLevel());
+    consoleLog.setSerialLevel(LOG_LEVEL_NONE);
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_NONE, consoleLog.getLevel());
+    consoleLog.setSerialLevel(LOG_LEVEL_VERBOSE);
+}
+
+void test_full_ring_drops_without_waiting(void)
+{
+    // Before begin() nothing drains, so the ring fills up
+    ConsoleLogStats before = consoleLog.getStats();
+    for (uint32_t i = 0; i < CONSOLE_LOG_SLOTS; i++)
+    {
+        TEST_ASSERT_TRUE(consoleLog.printf("queued %lu", (unsigned long)i));
+    }
+    TEST_ASSERT_FALSE(consoleLog.println("one too many"));
+
+    ConsoleLogStats after = consoleLog.getStats();
+    TEST_ASSERT_EQUAL_UINT32(CONSOLE_LOG_SLOTS, after.written - before.written);
+    TEST_ASSERT_EQUAL_UINT32(1, after.dropped - before.dropped);
+    TEST_ASSERT_EQUAL_UINT32(CONSOLE_LOG_SLOTS, after.highWater);
+
+    // The drain task delivers them in order and then reports the loss
+    consoleLog.setTap(captureLine);
+    consoleLog.begin();
+    TEST_ASSERT_TRUE(waitForLines(CONSOLE_LOG_SLOTS + 1));
+    std::lock_guard<std::mutex> lock(tapMutex);
+    for (uint32_t i = 0; i < CONSOLE_LOG_SLOTS; i++)
+    {
+        TEST_ASSERT_EQUAL_STRING(("queued " + std::to_string(i)).c_str(), lines[i].c_str());
+    }
+    TEST_ASSERT_TRUE(isDropNotice(lines[CONSOLE_LOG_SLOTS]));
+}
+
+void test_long_lines_are_truncated(void)
+{
+    ConsoleLogStats before = consoleLog.getStats();
+    std::string text(CONSOLE_LOG_LINE_SIZE + 50, 'x');
+    TEST_ASSERT_TRUE(consoleLog.write(text.c_str(), text.size()));
+    TEST_ASSERT_TRUE(consoleLog.logf(LOG_LEVEL_INFO, "%s", text.c_str()));
+    TEST_ASSERT_TRUE(consoleLog.println("short"));
+    TEST_ASSERT_TRUE(waitForLines(3));
+
+    ConsoleLogStats after = consoleLog.getStats();
+    TEST_ASSERT_EQUAL_UINT32(2, after.truncated - before.truncated);
+    std::lock_guard<std::mutex> lock(tapMutex);
+    TEST_ASSERT_EQUAL_size_t(CONSOLE_LOG_LINE_SIZE, lines[0].size());
+    // Formatted lines keep room for vsnprintf's terminator
+    TEST_ASSERT_EQUAL_size_t(CONSOLE_LOG_LINE_SIZE - 1, lines[1].size());
+    TEST_ASSERT_EQUAL_STRING("short", lines[2].c_str());
+}
+
+void test_concurrent_producers(void)
+{
+    const int PRODUCERS = 4;
+    const int LINES = 2000;
+    ConsoleLogStats before = consoleLog.getStats();
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([p]() {
+            for (int i = 0; i < LINES; i++)
+            {
+                consoleLog.logf(LOG_LEVEL_INFO, "%d %d", p, i);
+            }
+        });
+    }
+    for (std::thread &producer : producers)
+    {
+        producer.join();
+    }
+
+    // Every line is either delivered exactly once or counted as dropped
+    ConsoleLogStats after = consoleLog.getStats();
+    uint32_t written = after.written - before.written;
+    uint32_t dropped = after.dropped - before.dropped;
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * LINES, written + dropped);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        size_t delivered = 0;
+        {
+            std::lock_guard<std::mutex> lock(tapMutex);
+            for (const std::string &line : lines)
+            {
+                delivered += isDropNotice(line) ? 0 : 1;
+            }
+        }
+        if (delivered >= written)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Each producer's lines arrive in the order it wrote them
+    std::vector<int> next(PRODUCERS, 0);
+    uint32_t delivered = 0;
+    std::lock_guard<std::mutex> lock(tapMutex);
+    for (const std::string &line : lines)
+    {
+        if (isDropNotice(line))
+        {
+            continue;
+        }
+        int p = -1;
+        int i = -1;
+        TEST_ASSERT_EQUAL_INT(2, sscanf(line.c_str(), "%d %d", &p, &i));
+        TEST_ASSERT_TRUE(p >= 0 && p < PRODUCERS);
+        TEST_ASSERT_TRUE(i >= next[p]);
+        next[p] = i + 1;
+        delivered++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(written, delivered);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_level_names);
+    RUN_TEST(test_runtime_level_is_the_most_verbose_output);
+    RUN_TEST(test_full_ring_drops_without_waiting);
+    RUN_TEST(test_long_lines_are_truncated);
+    RUN_TEST(test_concurrent_producers);
+    return UNITY_END();
+}
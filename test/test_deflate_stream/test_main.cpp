@@ -0,0 +1,203 @@
+#include <unity.h>
+#include <zlib.h>
+#include <vector>
+#include "deflate_stream.h"
+
+// Compress with DeflateStream the way CardExport drives it, then inflate the
+// result with zlib, which also checks the gzip header, CRC and length.
+
+typedef std::vector<uint8_t> Bytes;
+
+static DeflateStream encoder;
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+// Feed input in chunks cycling through chunkSizes and drain the output
+// readSize bytes at a time
+static Bytes compress(const Bytes &input, const std::vector<size_t> &chunkSizes, size_t readSize)
+{
+    Bytes output;
+    std::vector<uint8_t> buffer(readSize);
+    size_t offset = 0;
+    size_t chunk = 0;
+    const uint8_t *pending = input.data();
+    size_t pendingLen = 0;
+    bool sourceDone = false;
+
+    encoder.begin();
+    while (true)
+    {
+        size_t n = encoder.read(buffer.data(), readSize);
+        if (n > 0)
+        {
+            output.insert(output.end(), buffer.begin(), buffer.begin() + n);
+            continue;
+        }
+        if (encoder.isDone())
+        {
+            break;
+        }
+        if (pendingLen == 0 && !sourceDone)
+        {
+            size_t size = chunkSizes[chunk++ % chunkSizes.size()];
+            if (size > input.size() - offset)
+            {
+                size = input.size() - offset;
+            }
+            pending = input.data() + offset;
+            pendingLen = size;
+            offset += size;
+            sourceDone = (size == 0);
+        }
+        size_t consumed = encoder.process(pending, pendingLen, sourceDone);
+        pending += consumed;
+        pendingLen -= consumed;
+    }
+    return output;
+}
+
+static bool gunzip(const Bytes &compressed, Bytes &output)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+    {
+        return false;
+    }
+    stream.next_in = (Bytef *)compressed.data();
+    stream.avail_in = compressed.size();
+
+    uint8_t buffer[4096];
+    int result;
+    do
+    {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        result = inflate(&stream, Z_NO_FLUSH);
+        output.insert(output.end(), buffer, buffer + (sizeof(buffer) - stream.avail_out));
+    } while (result == Z_OK);
+
+    bool complete = result == Z_STREAM_END && stream.avail_in == 0;
+    inflateEnd(&stream);
+    return complete;
+}
+
+static void assertRoundTrip(const Bytes &input, const std::vector<size_t> &chunkSizes, size_t readSize)
+{
+    Bytes compressed = compress(input, chunkSizes, readSize);
+    TEST_ASSERT_EQUAL_UINT32(input.size(), encoder.getTotalIn());
+    TEST_ASSERT_EQUAL_UINT32(compressed.size(), encoder.getTotalOut());
+
+    Bytes output;
+    TEST_ASSERT_TRUE(gunzip(compressed, output));
+    TEST_ASSERT_EQUAL_size_t(input.size(), output.size());
+    if (!input.empty())
+    {
+        TEST_ASSERT_EQUAL_MEMORY(input.data(), output.data(), input.size());
+    }
+}
+
+static Bytes randomBytes(size_t length, uint32_t seed)
+{
+    Bytes bytes(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        seed = seed * 1664525UL + 1013904223UL;
+        bytes[i] = (uint8_t)(seed >> 24);
+    }
+    return bytes;
+}
+
+// Card log lines, the data the export actually compresses
+static Bytes logLines(size_t count)
+{
+    Bytes bytes;
+    char line[160];
+    for (size_t i = 0; i < count; i++)
+    {
+        int length = snprintf(line, sizeof(line),
+                              "DATA_TYPE: CARD, Format: H10301/Ind26/AWID26, Bit_Length: 26, Hex_Value: %06lX, "
+                              "Facility_Code: %lu, Card_Number: %lu\n",
+                              (unsigned long)(i * 7919 & 0xFFFFFF), (unsigned long)(i % 5), (unsigned long)(1000 + i));
+        bytes.insert(bytes.end(), line, line + length);
+    }
+    return bytes;
+}
+
+static const std::vector<size_t> UNEVEN = {1, 7, 300, 4096, 13, 2500, 64};
+
+void test_empty_input(void)
+{
+    assertRoundTrip(Bytes(), {512}, 512);
+}
+
+void test_single_byte(void)
+{
+    assertRoundTrip(Bytes(1, 'x'), {1}, 1);
+}
+
+void test_random_input(void)
+{
+    assertRoundTrip(randomBytes(20000, 1), UNEVEN, 512);
+    assertRoundTrip(randomBytes(5000, 2), {1}, 3);
+}
+
+void test_repetitive_input(void)
+{
+    Bytes input = logLines(600);
+    assertRoundTrip(input, UNEVEN, 512);
+    assertRoundTrip(input, {1}, 1);
+    assertRoundTrip(input, {100000}, 7);
+
+    Bytes compressed = compress(input, UNEVEN, 512);
+    TEST_ASSERT_LESS_THAN(input.size() / 4, compressed.size());
+}
+
+void test_long_runs(void)
+{
+    // Runs far longer than the longest match and the window
+    Bytes input(3 * DEFLATE_WINDOW_SIZE + 1000, 'A');
+    Bytes tail = randomBytes(700, 3);
+    input.insert(input.end(), tail.begin(), tail.end());
+    input.insert(input.end(), 5000, 'B');
+    assertRoundTrip(input, UNEVEN, 512);
+}
+
+void test_matches_across_window_slides(void)
+{
+    // A block repeated at exactly the window distance and beyond it
+    Bytes block = randomBytes(DEFLATE_WINDOW_SIZE, 4);
+    Bytes input;
+    for (int i = 0; i < 5; i++)
+    {
+        input.insert(input.end(), block.begin(), block.end());
+        input.insert(input.end(), block.begin(), block.begin() + 100 * (i + 1));
+    }
+    assertRoundTrip(input, UNEVEN, 512);
+}
+
+void test_reuse_after_begin(void)
+{
+    Bytes first = logLines(50);
+    compress(first, UNEVEN, 512);
+    assertRoundTrip(randomBytes(3000, 5), UNEVEN, 512);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_input);
+    RUN_TEST(test_single_byte);
+    RUN_TEST(test_random_input);
+    RUN_TEST(test_repetitive_input);
+    RUN_TEST(test_long_runs);
+    RUN_TEST(test_matches_across_window_slides);
+    RUN_TEST(test_reuse_after_begin);
+    return UNITY_END();
+}